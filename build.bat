@@ -9,7 +9,5 @@ set CL_FILES=main.cpp reflexive_tests.cpp basic_tests.cpp user_tests.cpp
 
 pushd test
 cl %CL_ARGS% /std:c++14              %CL_FILES% /link /out:cpp14_seq.exe
-cl %CL_ARGS% /std:c++14      /openmp %CL_FILES% /link /out:cpp14_par.exe
 cl %CL_ARGS% /std:c++17              %CL_FILES% /link /out:cpp17_seq.exe
-cl %CL_ARGS% /std:c++17      /openmp %CL_FILES% /link /out:cpp17_par.exe
 popd
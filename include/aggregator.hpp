@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_AGGREGATOR_HPP
+#define TPP_AGGREGATOR_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/channel.hpp"
+#include "test/testsuite.hpp"
+#include "test/testsuite_parallel.hpp"
+
+#include "cmdline_parser.hpp"
+#include "runner.hpp"
+#include "version.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+/**
+ * Runs the testcases of several Test++ binaries in worker processes of these binaries, and reports them at once. Every
+ * binary lists its testsuites first, which are then filtered, scheduled, and reported, as if they were defined in this
+ * one. All binaries share the number of workers, that run at once, and workers are spawned for the binary, whose
+ * testcases are waiting.
+ */
+class aggregator
+{
+public:
+    /// Parse the options of a runner, followed by "--" and the paths of all binaries, and run them.
+    auto
+    run(int argc_, char const** argv_) noexcept -> int {
+        cmdline_parser           cmd;
+        std::vector<std::string> binaries;
+        try {
+            if (argc_ < 0) {
+                throw std::runtime_error("argument count cannot be less than zero");
+            }
+            auto const n{static_cast<std::size_t>(argc_)};
+            auto const sep{std::find_if(argv_, argv_ + n, [](char const* a_) { return std::strcmp(a_, "--") == 0; })};
+            cmd.parse(static_cast<std::size_t>(sep - argv_), argv_);
+            if (sep != argv_ + n) {
+                binaries.assign(sep + 1, argv_ + n);
+            }
+            if (binaries.empty()) {
+                throw std::runtime_error("no binaries given after --!");
+            }
+        } catch (cmdline_parser::help_called) {
+            std::cout << "\nBinaries to run are given after all options, like: " << (argc_ > 0 ? argv_[0] : "")
+                      << " [OPTIONS] [filename] -- <binary>...\n"
+                         "The -j option limits the worker processes of all binaries, that run at once."
+                      << std::endl;
+            return runner::to_int(runner::retval::HELP);
+        } catch (std::runtime_error const& e) {
+            return runner::err_exit(e.what());
+        }
+        return run(binaries, cmd.config());
+    }
+
+    /// Run all testsuites of the binaries at paths_.
+    auto
+    run(std::vector<std::string> const& paths_, config const& cfg_) noexcept -> int {
+        try {
+            runner r;
+            auto const batch{static_cast<std::size_t>(std::max(cfg_.jobs > 0 ? cfg_.jobs : cfg_.thd_count, 1))};
+            for (std::size_t b{0}; b < paths_.size(); b += batch) {
+                // Binaries are listed concurrently, as starting them may take a while.
+                std::vector<std::unique_ptr<test::connection>> conns;
+                for (auto i{b}; i < std::min(b + batch, paths_.size()); ++i) {
+                    conns.push_back(spawn(paths_[i]));
+                    conns.back()->chan().send(test::message("LIST"));
+                }
+                for (std::size_t i{0}; i < conns.size(); ++i) {
+                    list(b + i, paths_[b + i], *conns[i], r);
+                }
+            }
+            r.spawn_by([&](std::size_t b_) { return spawn(paths_[b_]); });
+            return r.run(cfg_);
+        } catch (std::exception const& e) {
+            return runner::err_exit(e.what());
+        }
+    }
+
+private:
+    static auto
+    spawn(std::string const& path_) -> std::unique_ptr<test::connection> {
+        return test::connection::spawn(path_, {"--worker", "fd:{fd}"});
+    }
+
+    /// Add all testsuites, that the binary at path_ lists, as testsuites of it to r_.
+    void
+    list(std::size_t binary_, std::string const& path_, test::connection& conn_, runner& r_) {
+        test::message       msg;
+        test::testsuite_ptr ts;
+        std::size_t         id{0};
+        while (conn_.chan().receive(msg)) {
+            auto const& cmd{msg.command()};
+            if (cmd == "HELLO" && msg.str(0) != TPP_VERSION) {
+                throw std::runtime_error(path_ + " was built with Test++ " + msg.str(0));
+            }
+            if (cmd == "SUITE") {
+                ts = msg.num<bool>(1) ? test::testsuite_parallel::create(keep(msg.str(0))) :
+                                        test::testsuite::create(keep(msg.str(0)));
+                for (std::size_t i{2}; i < msg.size(); ++i) {
+                    ts->depends_on(keep(msg.str(i)));
+                }
+                r_.add_remote(ts, binary_, id++);
+            } else if (cmd == "TEST" && ts) {
+                test::test_spec spec(keep(msg.str(0)));
+                spec.attrs.mode    = static_cast<test::concurrency>(msg.num<int>(1));
+                spec.attrs.timeout = msg.num<double>(2);
+                auto const tags{4 + msg.num<std::size_t>(3)};
+                for (std::size_t i{4}; i < tags; ++i) {
+                    spec.attrs.tags.push_back(keep(msg.str(i)));
+                }
+                for (auto i{tags}; i + 1 < msg.size(); i += 2) {
+                    spec.attrs.resources.push_back(test::resource{keep(msg.str(i)), msg.num<std::size_t>(i + 1)});
+                }
+                // Testcases are only run by workers.
+                ts->test(std::move(spec), [] {});
+            } else if (cmd == "END") {
+                conn_.chan().send(test::message("QUIT"));
+                return;
+            }
+        }
+        throw std::runtime_error("could not list the testsuites of " + path_ + ", it " + conn_.wait());
+    }
+
+    /// Keep a copy of str_ as long as this aggregator, as testsuites and testcases only refer to their names.
+    auto
+    keep(std::string const& str_) -> char const* {
+        m_strings.push_back(str_);
+        return m_strings.back().c_str();
+    }
+
+    std::deque<std::string> m_strings;
+};
+}  // namespace intern
+
+using aggregator = intern::aggregator;
+}  // namespace tpp
+
+#endif  // TPP_AGGREGATOR_HPP
@@ -20,101 +20,98 @@
 #ifndef TPP_API_HPP
 #define TPP_API_HPP
 
-#include <utility>
-
-namespace tpp
-{
-namespace intern
-{
-template<typename T>
-struct singleton final
-{
-    template<typename... Args>
-    static auto
-    instance(Args&&... args_) noexcept -> T const& {
-        static T const inst(std::forward<Args>(args_)...);
-        return inst;
-    }
-};
-}  // namespace intern
-}  // namespace tpp
-
 #define TPP_INTERN_CONCAT3(A, B, C) A##B##C
 #define TPP_INTERN_API_TEST_NAME(ID) TPP_INTERN_CONCAT3(tpp_intern_test_, ID, _)
-#define TPP_INTERN_API_TEST_INST(ID) TPP_INTERN_CONCAT3(tpp_intern_test_, ID, _inst_)
 #define TPP_INTERN_API_TEST_FN(ID) TPP_INTERN_CONCAT3(tpp_intern_test_fn_, ID, _)
 #define TPP_INTERN_API_SUITE_NS(ID) TPP_INTERN_CONCAT3(tpp_intern_ns_, ID, _)
 #define TPP_INTERN_API_SUITE_NAME(ID) TPP_INTERN_CONCAT3(tpp_intern_suite_, ID, _)
 
-#define TPP_INTERN_API_SUITE_WRAPPER(DESCR, BASE)                                                      \
-    namespace TPP_INTERN_API_SUITE_NS(__LINE__) {                                                      \
-        class test_module                                                                              \
-        {                                                                                              \
-            tpp::intern::test::testsuite_ptr m_ts_;                                                    \
-                                                                                                       \
-        public:                                                                                        \
-            test_module(test_module const&)     = delete;                                              \
-            test_module(test_module&&) noexcept = delete;                                              \
-            virtual ~test_module() noexcept     = default;                                             \
-            auto                                                                                       \
-            operator=(test_module const&) -> test_module& = delete;                                    \
-            auto                                                                                       \
-            operator=(test_module&&) noexcept -> test_module& = delete;                                \
-                                                                                                       \
-        protected:                                                                                     \
-            test_module() : m_ts_(tpp::intern::test::BASE::create(DESCR)) {                            \
-                tpp::runner::instance().add_testsuite(m_ts_);                                          \
-            }                                                                                          \
-            auto                                                                                       \
-            tpp_intern_ts_() const -> tpp::intern::test::testsuite_ptr const& {                        \
-                return m_ts_;                                                                          \
-            }                                                                                          \
-        };                                                                                             \
-        class TPP_INTERN_API_SUITE_NAME(__LINE__);                                                     \
-        using tpp_intern_mod_type_         = TPP_INTERN_API_SUITE_NAME(__LINE__);                      \
-        static auto const& tpp_intern_mod_ = tpp::intern::singleton<tpp_intern_mod_type_>::instance(); \
-    }                                                                                                  \
-    class TPP_INTERN_API_SUITE_NS(__LINE__)::TPP_INTERN_API_SUITE_NAME(__LINE__)                       \
+#define TPP_INTERN_API_SUITE_WRAPPER(BASE, INST, MODULE, ...)                                                       \
+    namespace TPP_INTERN_API_SUITE_NS(__LINE__) {                                                                   \
+        class TPP_INTERN_API_SUITE_NAME(__LINE__);                                                                  \
+        using tpp_intern_mod_type_ = TPP_INTERN_API_SUITE_NAME(__LINE__);                                           \
+        using tpp::intern::test::depends_on;                                                                        \
+        using tpp::intern::test::do_not_optimize;                                                                   \
+        using tpp::intern::test::clobber_memory;                                                                    \
+        static auto                                                                                                 \
+        tpp_intern_spec_() -> tpp::intern::test::suite_spec {                                                       \
+            return tpp::intern::test::suite_spec(__VA_ARGS__);                                                      \
+        }                                                                                                           \
+        static tpp::intern::test::suite_record tpp_intern_rec_{                                                     \
+            &tpp_intern_spec_, &tpp::intern::test::BASE::create,                                                    \
+            &tpp::intern::test::make_##MODULE<tpp_intern_mod_type_>,                                                \
+            &tpp::intern::test::destroy_##MODULE<tpp_intern_mod_type_>, tpp::intern::test::instancing::INST};       \
+        static tpp::intern::test::suite_registrar const tpp_intern_reg_{tpp_intern_rec_};                           \
+        class test_module : public tpp::intern::test::attribute_factory                                             \
+        {                                                                                                           \
+        public:                                                                                                     \
+            test_module(test_module const&)     = delete;                                                           \
+            test_module(test_module&&) noexcept = delete;                                                           \
+            virtual ~test_module() noexcept     = default;                                                          \
+            auto                                                                                                    \
+            operator=(test_module const&) -> test_module& = delete;                                                 \
+            auto                                                                                                    \
+            operator=(test_module&&) noexcept -> test_module& = delete;                                             \
+                                                                                                                    \
+        protected:                                                                                                  \
+            test_module() = default;                                                                                \
+        };                                                                                                          \
+    }                                                                                                               \
+    class TPP_INTERN_API_SUITE_NS(__LINE__)::TPP_INTERN_API_SUITE_NAME(__LINE__)                                    \
         : public TPP_INTERN_API_SUITE_NS(__LINE__)::test_module
 
-#define TPP_INTERN_API_TEST_WRAPPER(DESCR)                                                          \
-    class TPP_INTERN_API_TEST_NAME(__LINE__)                                                        \
-    {                                                                                               \
-    public:                                                                                         \
-        explicit TPP_INTERN_API_TEST_NAME(__LINE__)(tpp_intern_mod_type_ * mod_) {                  \
-            mod_->tpp_intern_ts_()->test(DESCR, [=] { mod_->TPP_INTERN_API_TEST_FN(__LINE__)(); }); \
-        }                                                                                           \
-    } TPP_INTERN_API_TEST_INST(__LINE__){this};                                                     \
-    void TPP_INTERN_API_TEST_FN(__LINE__)()
-
-#define TPP_INTERN_API_FN_WRAPPER(FN)                                           \
-    class tpp_intern_##FN##_                                                    \
-    {                                                                           \
-    public:                                                                     \
-        explicit tpp_intern_##FN##_(tpp_intern_mod_type_* mod_) {               \
-            mod_->tpp_intern_ts_()->FN([=] { mod_->tpp_intern_##FN##_fn_(); }); \
-        }                                                                       \
-    } tpp_intern_##FN##_inst_{this};                                            \
-    void tpp_intern_##FN##_fn_()
+#define TPP_INTERN_API_MEMBER_WRAPPER(NAME, KIND_, FN, SPEC)                                                        \
+    struct NAME                                                                                                     \
+    {                                                                                                               \
+        static constexpr tpp::intern::test::member_kind KIND = tpp::intern::test::member_kind::KIND_;               \
+        static constexpr int                            LINE = __LINE__;                                            \
+        static auto                                                                                                 \
+        suite() -> tpp::intern::test::suite_record& {                                                               \
+            return tpp_intern_rec_;                                                                                 \
+        }                                                                                                           \
+        static auto                                                                                                 \
+        spec() -> tpp::intern::test::test_spec {                                                                    \
+            return tpp::intern::test::test_spec SPEC;                                                               \
+        }                                                                                                           \
+        static void                                                                                                 \
+        run(void* mod_) {                                                                                           \
+            static_cast<tpp_intern_mod_type_*>(mod_)->FN();                                                         \
+        }                                                                                                           \
+        static auto                                                                                                 \
+        record() -> tpp::intern::test::member_record const* {                                                       \
+            return &tpp::intern::test::member_registrar<NAME>::record;                                              \
+        }                                                                                                           \
+    };                                                                                                              \
+    void FN()
+
+#define TPP_INTERN_API_TEST_WRAPPER(...)                                                                           \
+    TPP_INTERN_API_MEMBER_WRAPPER(TPP_INTERN_API_TEST_NAME(__LINE__), testcase, TPP_INTERN_API_TEST_FN(__LINE__), \
+                                  (__VA_ARGS__))
+
+#define TPP_INTERN_API_FN_WRAPPER(FN) \
+    TPP_INTERN_API_MEMBER_WRAPPER(tpp_intern_##FN##_, FN, tpp_intern_##FN##_fn_, (#FN))
 
 /**
  * Create a testsuite, where all testcases run sequentially.
  *
- * @param DESCR is a cstring with the description, or name of the testsuite.
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
  * SUITE("test some stuff") {
  *   // testcases
  * };
+ * SUITE("test other stuff", depends_on("test some stuff")) {
+ *   // testcases
+ * };
  * @endcode
  */
-#define SUITE(DESCR) TPP_INTERN_API_SUITE_WRAPPER(DESCR, testsuite)
+#define SUITE(...) TPP_INTERN_API_SUITE_WRAPPER(testsuite, per_suite, module, __VA_ARGS__)
 
 /**
  * Create a testsuite, where all testcases are run in parallel.
  *
- * @param DESCR is a cstring with the description, or name of the testsuite.
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
@@ -123,12 +120,59 @@ struct singleton final
  * };
  * @endcode
  */
-#define SUITE_PAR(DESCR) TPP_INTERN_API_SUITE_WRAPPER(DESCR, testsuite_parallel)
+#define SUITE_PAR(...) TPP_INTERN_API_SUITE_WRAPPER(testsuite_parallel, per_suite, module, __VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases are run in parallel, and every worker thread runs them on its own instance
+ * of the testsuite. SETUP and TEARDOWN run on another instance, which is only created if one of them is defined.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * SUITE_PAR_PER_WORKER("test some stuff in parallel") {
+ *   // members, THREAD_SETUP, THREAD_TEARDOWN, and testcases
+ * };
+ * @endcode
+ */
+#define SUITE_PAR_PER_WORKER(...) TPP_INTERN_API_SUITE_WRAPPER(testsuite_parallel, per_worker, module, __VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases run sequentially, and every testcase runs on a new instance of the
+ * testsuite, including BEFORE_EACH and AFTER_EACH. SETUP and TEARDOWN run on another instance, which is only created if
+ * one of them is defined.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * SUITE_PER_TEST("test some stuff in isolation") {
+ *   // members and testcases
+ * };
+ * @endcode
+ */
+#define SUITE_PER_TEST(...) TPP_INTERN_API_SUITE_WRAPPER(testsuite, per_testcase, recycled_module, __VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases are run in parallel, and every testcase runs on a new instance of the
+ * testsuite, including BEFORE_EACH and AFTER_EACH.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * SUITE_PAR_PER_TEST("test some stuff in isolation and parallel") {
+ *   // members and testcases
+ * };
+ * @endcode
+ */
+#define SUITE_PAR_PER_TEST(...) \
+    TPP_INTERN_API_SUITE_WRAPPER(testsuite_parallel, per_testcase, recycled_module, __VA_ARGS__)
 
 /**
  * Create a testsuite, where all testcases run sequentially.
  *
- * @param DESCR is a cstring with the description, or name of the testsuite.
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
@@ -137,12 +181,12 @@ struct singleton final
  * };
  * @endcode
  */
-#define DESCRIBE(DESCR) SUITE(DESCR)
+#define DESCRIBE(...) SUITE(__VA_ARGS__)
 
 /**
  * Create a testsuite, where all testcases are run in parallel.
  *
- * @param DESCR is a cstring with the description, or name of the testsuite.
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
@@ -151,26 +195,94 @@ struct singleton final
  * };
  * @endcode
  */
-#define DESCRIBE_PAR(DESCR) SUITE_PAR(DESCR)
+#define DESCRIBE_PAR(...) SUITE_PAR(__VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases are run in parallel, and every worker thread runs them on its own instance
+ * of the testsuite.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * DESCRIBE_PAR_PER_WORKER("test some stuff in parallel") {
+ *   // members, THREAD_SETUP, THREAD_TEARDOWN, and testcases
+ * };
+ * @endcode
+ */
+#define DESCRIBE_PAR_PER_WORKER(...) SUITE_PAR_PER_WORKER(__VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases run sequentially, and every testcase runs on a new instance of the
+ * testsuite.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * DESCRIBE_PER_TEST("test some stuff in isolation") {
+ *   // members and testcases
+ * };
+ * @endcode
+ */
+#define DESCRIBE_PER_TEST(...) SUITE_PER_TEST(__VA_ARGS__)
+
+/**
+ * Create a testsuite, where all testcases are run in parallel, and every testcase runs on a new instance of the
+ * testsuite.
+ *
+ * @param ... is a cstring with the description, or name of the testsuite, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * DESCRIBE_PAR_PER_TEST("test some stuff in isolation and parallel") {
+ *   // members and testcases
+ * };
+ * @endcode
+ */
+#define DESCRIBE_PAR_PER_TEST(...) SUITE_PAR_PER_TEST(__VA_ARGS__)
 
 /**
  * Create a testcase.
  *
- * @param DESCR is a cstring with the description, or name of the testcase.
+ * @param ... is a cstring with the description, or name of the testcase, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
  * TEST("some test") {
  *   // assertions
  * }
+ * TEST("some slow test", timeout(100)) {
+ *   // assertions
+ * }
  * @endcode
  */
-#define TEST(DESCR) TPP_INTERN_API_TEST_WRAPPER(DESCR)
+#define TEST(...) TPP_INTERN_API_TEST_WRAPPER(__VA_ARGS__)
+
+/**
+ * Create a benchmark, which is a testcase, whose body is measured. It is run repeatedly, first to warm up and calibrate
+ * the number of iterations per sample, then to take the samples. The statistics of all samples are reported. It fails,
+ * if an assertion in its body fails. Use do_not_optimize and clobber_memory, to keep the compiler from optimizing away
+ * the code to measure.
+ *
+ * @param ... is a cstring with the description, or name of the benchmark, optionally followed by attributes.
+ *
+ * EXAMPLE:
+ * @code
+ * BENCHMARK("sort") {
+ *   std::vector<int> v{3, 1, 2};
+ *   std::sort(v.begin(), v.end());
+ *   do_not_optimize(v);
+ * }
+ * @endcode
+ */
+#define BENCHMARK(...) \
+    TPP_INTERN_API_TEST_WRAPPER(__VA_ARGS__, tpp::intern::test::attribute_factory::benchmark())
 
 /**
  * Create a testcase.
  *
- * @param DESCR is a cstring with the description, or name of the testcase.
+ * @param ... is a cstring with the description, or name of the testcase, optionally followed by attributes.
  *
  * EXAMPLE:
  * @code
@@ -179,7 +291,7 @@ struct singleton final
  * }
  * @endcode
  */
-#define IT(DESCR) TPP_INTERN_API_TEST_WRAPPER("It " DESCR)
+#define IT(...) TPP_INTERN_API_TEST_WRAPPER("It " __VA_ARGS__)
 
 /**
  * Create a definition for a function as part of a testsuite, that is executed once before each
@@ -233,4 +345,31 @@ struct singleton final
  */
 #define TEARDOWN() TPP_INTERN_API_FN_WRAPPER(teardown)
 
+/**
+ * Create a definition for a function as part of a testsuite, that is executed on every instance of the testsuite
+ * right after it was constructed. In SUITE_PAR_PER_WORKER testsuites, this is done once by every worker thread.
+ *
+ * EXAMPLE:
+ * @code
+ * THREAD_SETUP() {
+ *   // acquire resources of this thread
+ * }
+ * @endcode
+ */
+#define THREAD_SETUP() TPP_INTERN_API_FN_WRAPPER(thread_setup)
+
+/**
+ * Create a definition for a function as part of a testsuite, that is executed on every instance of the testsuite
+ * right before it is destroyed, after all testcases and TEARDOWN. In SUITE_PAR_PER_WORKER testsuites, this is done by
+ * every worker thread on its own instance.
+ *
+ * EXAMPLE:
+ * @code
+ * THREAD_TEARDOWN() {
+ *   // release resources of this thread
+ * }
+ * @endcode
+ */
+#define THREAD_TEARDOWN() TPP_INTERN_API_FN_WRAPPER(thread_teardown)
+
 #endif  // TPP_API_HPP
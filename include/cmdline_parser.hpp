@@ -20,8 +20,11 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 
 #include "config.hpp"
 #include "version.hpp"
@@ -39,7 +42,8 @@ public:
     void
     parse(std::size_t argc_, char const** argv_) {
         auto const args{tokenize_args(argc_, argv_)};
-        m_progname = argv_[0];
+        m_progname    = argv_[0];
+        m_cfg.program = argv_[0];
         for (auto i{1UL}; i < args.size(); ++i) {
             eval_arg(args[i], [&](std::string const& arg_) -> std::string const& {
                 try {
@@ -49,6 +53,12 @@ public:
                 }
             });
         }
+        if (m_cfg.until_fail && m_cfg.repeat < 1) {
+            throw std::runtime_error("--until-fail requires --repeat!");
+        }
+        if (m_cfg.timeout > 0 && !m_cfg.isolated) {
+            throw std::runtime_error("--timeout requires --isolate!");
+        }
     }
 
     inline auto
@@ -76,6 +86,22 @@ private:
         }
     };
 
+    /// Matches arguments of the form prefix=value.
+    struct valued_option
+    {
+        std::string m_prefix;
+
+        template<typename Fn>
+        auto
+        operator()(std::string const& arg_, Fn&& fn_) const -> decltype(*this)& {
+            if (arg_.compare(0, m_prefix.size(), m_prefix) == 0) {
+                fn_(arg_.substr(m_prefix.size()));
+                throw matched{};
+            }
+            return *this;
+        }
+    };
+
     struct combined_option
     {
         template<typename Fn>
@@ -102,19 +128,43 @@ private:
             make_option(+"--xml")(arg_, [&] { m_cfg.report_fmt = config::report_format::XML; });
             make_option(+"--md")(arg_, [&] { m_cfg.report_fmt = config::report_format::MD; });
             make_option(+"--json")(arg_, [&] { m_cfg.report_fmt = config::report_format::JSON; });
+            make_option(+"--parallel-suites")(arg_, [&] { m_cfg.parallel_suites = true; });
+            make_option(+"--cache")(arg_, [&] { m_cfg.cache_file = getval_fn_(arg_); });
+            make_option(+"--rerun-failed")(arg_, [&] { m_cfg.rerun_failed = true; });
+            make_option(+"--failed-first")(arg_, [&] { m_cfg.failed_first = true; });
+            make_option(+"--repeat")(arg_, [&] { m_cfg.repeat = to_int(getval_fn_(arg_)); });
+            make_option(+"--until-fail")(arg_, [&] { m_cfg.until_fail = true; });
+            make_option(+"--isolate")(arg_, [&] { m_cfg.isolated = true; });
+            make_option(+"--timeout")(arg_, [&] { m_cfg.timeout = to_int(getval_fn_(arg_)); });
+            make_option(+"--fail-fast")(arg_, [&] { m_cfg.fail_fast = 1; });
+            valued_option{"--fail-fast="}(arg_, [&](std::string const& val_) { m_cfg.fail_fast = to_int(val_); });
+            make_option(+"--list")(arg_, [&] { m_cfg.list_fmt = config::list_format::TEXT; });
+            valued_option{"--list="}(arg_, [&](std::string const& val_) { m_cfg.list_fmt = to_list_format(val_); });
+            make_option(+"--shuffle")(arg_, [&] { m_cfg.shuffle = to_shuffle(test::shuffle::random_seed()); });
+            valued_option{"--shuffle="}(arg_,
+                                        [&](std::string const& val_) { m_cfg.shuffle = to_shuffle(to_seed(val_)); });
+            make_option(+"--shard")(arg_, [&] { m_cfg.shard = to_shard(getval_fn_(arg_)); });
+            make_option(+"--worker")(arg_, [&] { m_cfg.worker = getval_fn_(arg_); });
+            make_option(+"--listen")(arg_, [&] { m_cfg.listen = getval_fn_(arg_); });
+            make_option(+"--save-baseline")(arg_, [&] { m_cfg.save_baseline = getval_fn_(arg_); });
+            make_option(+"--compare-baseline")(arg_, [&] { m_cfg.compare_baseline = getval_fn_(arg_); });
+            make_option(+"--max-regression")(arg_, [&] { m_cfg.max_regression = to_double(getval_fn_(arg_)); });
+            make_option(+"--significance")(arg_, [&] { m_cfg.significance = to_double(getval_fn_(arg_)); });
             combined_option{}(arg_, [&](char c_) {
                 make_option('c')(c_, [&] { m_cfg.report_cfg.color = true; });
                 make_option('o')(c_, [&] { m_cfg.report_cfg.capture_out = true; });
                 make_option('s')(c_, [&] { m_cfg.report_cfg.strip = true; });
                 make_option('e')(c_, [&] {
                     set_filter_mode(config::filter_mode::EXCLUDE);
-                    m_cfg.f_patterns.push_back(to_regex(getval_fn_(arg_)));
+                    m_cfg.f_patterns.add(getval_fn_(arg_));
                 });
                 make_option('i')(c_, [&] {
                     set_filter_mode(config::filter_mode::INCLUDE);
-                    m_cfg.f_patterns.push_back(to_regex(getval_fn_(arg_)));
+                    m_cfg.f_patterns.add(getval_fn_(arg_));
                 });
                 make_option('t')(c_, [&] { m_cfg.thd_count = to_int(getval_fn_(arg_)); });
+                make_option('p')(c_, [&] { m_cfg.parallel_suites = true; });
+                make_option('j')(c_, [&] { m_cfg.jobs = to_int(getval_fn_(arg_)); });
             });
         } catch (matched) {
             return;
@@ -139,14 +189,48 @@ private:
                      "  --xml : Report in JUnit-like XML format.\n"
                      "  --md  : Report in markdown format.\n"
                      "  --json: Report in json format.\n"
+                     "  --parallel-suites: Same as -p.\n"
+                     "  --cache <file>   : Start the longest testcases first, as known from previous runs, and update\n"
+                     "                     their times in file afterwards.\n"
+                     "  --rerun-failed   : Run only testcases, that failed, or had an error when they were run last,\n"
+                     "                     as known from --cache.\n"
+                     "  --failed-first   : Start testcases, that failed, or had an error when they were run last, and\n"
+                     "                     their testsuites first, as known from --cache.\n"
+                     "  --repeat <n>     : Run every testcase n times, and report statistics of their times.\n"
+                     "  --until-fail     : Stop repeating a testcase after it failed, but after n runs at most as set by\n"
+                     "                     --repeat, which is required.\n"
+                     "  --isolate        : Run every testcase in a child process, so that crashes are reported as errors.\n"
+                     "  --timeout <ms>   : Let testcases, that take longer than ms milliseconds, end with an error.\n"
+                     "                     Their child process is killed, and their stack is reported. Requires --isolate.\n"
+                     "  --fail-fast[=n]  : Stop starting testcases after n failures, or errors (default 1).\n"
+                     "  --shard <i>/<n>  : Run only the i-th of n disjoint parts of all testcases, counting from 0.\n"
+                     "                     Parts are balanced by the times from --cache, which must be equal for all.\n"
+                     "  --list[=json]    : List all selected testsuites and testcases with their tags and times from\n"
+                     "                     --cache, and exit without running them.\n"
+                     "  --shuffle[=seed] : Run testsuites, and testcases of parallel testsuites in random order. The\n"
+                     "                     seed is reported, so that the order can be reproduced.\n"
+                     "  --listen <addr>  : Run testcases also in workers, that connect to addr ([host:]port) over TCP,\n"
+                     "                     in addition to the ones from -j. The run waits for workers, if none is left.\n"
+                     "                     Without host, only the loopback interface is listened at.\n"
+                     "  --worker <addr>  : Run testcases on behalf of the binary at addr (host:port), that was started\n"
+                     "                     with the same testcases and --listen, until its run is done.\n"
+                     "  --save-baseline <file>     : Save the samples of all benchmarks, that passed, to file.\n"
+                     "  --compare-baseline <file>  : Fail benchmarks, that are significantly slower than in file.\n"
+                     "  --max-regression <percent> : Slowdown of the median, that is tolerated (default 5).\n"
+                     "  --significance <p>         : Significance level of the Mann-Whitney U test (default 0.01).\n"
                      "  -c    : Use ANSI colors in report, if supported by reporter.\n"
                      "  -s    : Strip unnecessary whitespaces from report.\n"
                      "  -o    : Report captured output from tests, if supported by reporter.\n"
-                     "  -t <n>: Set the thread count for parallel testsuites explicitly.\n\n"
+                     "  -t <n>: Set the thread count for parallel testsuites explicitly.\n"
+                     "  -p    : Run testsuites concurrently, sharing the thread count among them.\n"
+                     "  -j <n>: Run testcases in n worker processes, which are copies of this binary. Testcases of\n"
+                     "          parallel testsuites are spread over all workers, sequential testsuites run as whole.\n\n"
                      "  Multiple filters are possible, but includes and excludes are mutually exclusive.\n"
-                     "  Patterns may contain * as wildcard.\n\n"
-                     "  -e <pattern> : Exclude testsuites with names matching pattern.\n"
-                     "  -i <pattern> : Include only testsuites with names matching pattern."
+                     "  Patterns may contain * for any text, ? for any character, and [...] for a set of characters.\n"
+                     "  A pattern matches testsuite names, suite/test matches testcases by the names of both, and\n"
+                     "  @tag matches testcases by their tags.\n\n"
+                     "  -e <pattern> : Exclude testsuites, or testcases matching pattern.\n"
+                     "  -i <pattern> : Include only testsuites, or testcases matching pattern."
                   << std::endl;
         throw help_called{};
     }
@@ -177,24 +261,65 @@ private:
     }
 
     static auto
-    to_regex(std::string const& str_) -> std::regex {
-        try {
-            return std::regex(std::regex_replace(str_, std::regex("\\*"), ".*"),
-                              std::regex_constants::nosubs | std::regex_constants::basic);
-        } catch (std::regex_error const&) {
-            throw std::runtime_error(str_ + " is not a valid pattern!");
+    to_int(std::string const& str_) -> int {
+        int v{1};
+        if (!(std::istringstream(str_) >> v) || v < 1) {
+            throw std::runtime_error(str_ + " is not a valid number!");
         }
+        return v;
     }
 
     static auto
-    to_int(std::string const& str_) -> int {
-        int v{1};
-        if (!(std::istringstream(str_) >> v) || v < 1) {
+    to_double(std::string const& str_) -> double {
+        std::istringstream in(str_);
+        double             v{.0};
+        if (!(in >> v) || !in.eof() || v < .0) {
             throw std::runtime_error(str_ + " is not a valid number!");
         }
         return v;
     }
 
+    static auto
+    to_shard(std::string const& str_) -> test::shard {
+        std::istringstream in(str_);
+        test::shard        s;
+        char               sep{0};
+        if (!(in >> s.index >> sep >> s.count) || sep != '/' || !in.eof() || s.index >= s.count ||
+            str_.find('-') != std::string::npos) {
+            throw std::runtime_error(str_ + " is not a valid shard!");
+        }
+        return s;
+    }
+
+    static auto
+    to_seed(std::string const& str_) -> std::uint64_t {
+        std::istringstream in(str_);
+        std::uint64_t      v{0};
+        if (!(in >> v) || !in.eof() || str_.find('-') != std::string::npos) {
+            throw std::runtime_error(str_ + " is not a valid seed!");
+        }
+        return v;
+    }
+
+    static auto
+    to_shuffle(std::uint64_t seed_) -> test::shuffle {
+        test::shuffle s;
+        s.enabled = true;
+        s.seed    = seed_;
+        return s;
+    }
+
+    static auto
+    to_list_format(std::string const& str_) -> config::list_format {
+        if (str_ == "text") {
+            return config::list_format::TEXT;
+        }
+        if (str_ == "json") {
+            return config::list_format::JSON;
+        }
+        throw std::runtime_error(str_ + " is not a valid list format!");
+    }
+
     struct config m_cfg;
     char const*   m_progname{nullptr};
 };
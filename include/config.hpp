@@ -18,17 +18,24 @@
 #ifndef TPP_CONFIG_HPP
 #define TPP_CONFIG_HPP
 
-#include <regex>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "exec/executor.hpp"
+#include "exec/thread_pool.hpp"
+#include "test/filter.hpp"
+#include "test/shard.hpp"
+#include "test/shuffle.hpp"
+
 #include "report/console_reporter.hpp"
 #include "report/json_reporter.hpp"
 #include "report/markdown_reporter.hpp"
 #include "report/reporter_factory.hpp"
 #include "report/xml_reporter.hpp"
 
-#include "omp.hpp"
-
 namespace tpp
 {
 namespace intern
@@ -50,8 +57,59 @@ struct config
         CNS
     };
 
+    enum class list_format
+    {
+        NONE,
+        TEXT,
+        JSON
+    };
+
     auto
     reporter() const -> reporter_ptr {
+        auto rep{make_reporter()};
+        if (shuffle.enabled) {
+            rep->with_seed(shuffle.seed);
+        }
+        return rep;
+    }
+
+    auto
+    executor() const -> exec::executor_ptr {
+        if (thd_count > 1) {
+            return std::make_shared<exec::thread_pool>(static_cast<std::size_t>(thd_count));
+        }
+        return std::make_shared<exec::sequential_executor>();
+    }
+
+    report_format           report_fmt{report_format::CNS};
+    report::reporter_config report_cfg;
+    list_format             list_fmt{list_format::NONE};
+    test::filter            f_patterns;
+    filter_mode             f_mode{filter_mode::NONE};
+    int                     thd_count{static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U))};
+    bool                    parallel_suites{false};
+    bool                    isolated{false};
+    int                     timeout{0};
+    int                     fail_fast{0};
+    bool                    rerun_failed{false};
+    int                     repeat{0};
+    bool                    until_fail{false};
+    bool                    failed_first{false};
+    std::string             cache_file;
+    test::shard             shard;
+    test::shuffle           shuffle;
+    int                     jobs{0};
+    std::string             worker;               ///< Address of the coordinator, if this process is a worker.
+    std::string             listen;               ///< Address to accept workers at over TCP.
+    std::string             save_baseline;        ///< File to save the samples of benchmarks to.
+    std::string             compare_baseline;     ///< File with samples of benchmarks to compare against.
+    double                  max_regression{5.0};  ///< Slowdown of benchmarks in percent, that is tolerated.
+    double                  significance{0.01};   ///< Significance level, at which slower samples fail a benchmark.
+    std::string             program;              ///< Path of this executable, as it was called.
+
+private:
+    auto
+    make_reporter() const -> reporter_ptr {
         switch (report_fmt) {
             case report_format::XML: return report::reporter_factory::make<xml_reporter>(report_cfg);
             case report_format::MD: return report::reporter_factory::make<markdown_reporter>(report_cfg);
@@ -59,12 +117,6 @@ struct config
             default /*CNS*/: return report::reporter_factory::make<console_reporter>(report_cfg);
         }
     }
-
-    report_format           report_fmt{report_format::CNS};
-    report::reporter_config report_cfg;
-    std::vector<std::regex> f_patterns;
-    filter_mode             f_mode{filter_mode::NONE};
-    int                     thd_count = omp_get_max_threads();
 };
 }  // namespace intern
 
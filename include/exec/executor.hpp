@@ -0,0 +1,145 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_EXEC_EXECUTOR_HPP
+#define TPP_EXEC_EXECUTOR_HPP
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace tpp
+{
+namespace intern
+{
+namespace exec
+{
+/// Assumed size of a cache line, used to pad data that is written by different threads.
+static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+class executor;
+using executor_ptr = std::shared_ptr<executor>;
+
+/**
+ * Interface for strategies to execute tasks, that may run concurrently.
+ * A task gets its own index, and the index of the worker executing it in [0, concurrency()).
+ */
+class executor
+{
+public:
+    using task_function = std::function<void(std::size_t, std::size_t)>;
+
+    executor()                    = default;
+    executor(executor const&)     = delete;
+    executor(executor&&) noexcept = delete;
+    virtual ~executor() noexcept  = default;
+    auto
+    operator=(executor const&) -> executor& = delete;
+    auto
+    operator=(executor&&) noexcept -> executor& = delete;
+
+    /**
+     * Execute fn_ for every index in [0, n_), and return when all of them are done.
+     * All tasks are executed, even if some throw. The first caught exception is rethrown afterwards.
+     */
+    virtual void
+    parallel_for(std::size_t n_, task_function const& fn_) = 0;
+
+    /**
+     * Execute fn_ for every index i in [0, workers_.size()) on the thread of worker workers_[i], and return when all of
+     * them are done. This is meant for state, that is bound to the thread of a worker. Errors are handled as by
+     * parallel_for.
+     */
+    virtual void
+    on_workers(std::vector<std::size_t> const& workers_, task_function const& fn_) = 0;
+
+    /**
+     * Start fn_ as a single task with index 0, and return without waiting for it. The caller has to wait for its
+     * completion by its own means. Exceptions thrown by fn_ are dropped, so it should handle errors itself.
+     */
+    virtual void
+    spawn(task_function fn_) = 0;
+
+    /// Get the number of workers, that may execute tasks concurrently.
+    virtual auto
+    concurrency() const -> std::size_t = 0;
+};
+
+/// Executes all tasks one after another in the calling thread.
+class sequential_executor : public executor
+{
+public:
+    void
+    parallel_for(std::size_t n_, task_function const& fn_) override {
+        std::exception_ptr err;
+        for (std::size_t i{0}; i < n_; ++i) {
+            try {
+                fn_(i, 0);
+            } catch (...) {
+                if (!err) {
+                    err = std::current_exception();
+                }
+            }
+        }
+        if (err) {
+            std::rethrow_exception(err);
+        }
+    }
+
+    /// The only worker is the calling thread.
+    void
+    on_workers(std::vector<std::size_t> const& workers_, task_function const& fn_) override {
+        parallel_for(workers_.size(), [&](std::size_t i_, std::size_t) { fn_(i_, workers_[i_]); });
+    }
+
+    /// Tasks spawned by a running task are deferred until it returns, instead of nesting them.
+    void
+    spawn(task_function fn_) override {
+        m_spawned.push_back(std::move(fn_));
+        if (m_draining) {
+            return;
+        }
+        m_draining = true;
+        while (!m_spawned.empty()) {
+            task_function const fn{std::move(m_spawned.front())};
+            m_spawned.pop_front();
+            try {
+                fn(0, 0);
+            } catch (...) {
+            }
+        }
+        m_draining = false;
+    }
+
+    auto
+    concurrency() const -> std::size_t override {
+        return 1;
+    }
+
+private:
+    std::deque<task_function> m_spawned;
+    bool                      m_draining{false};
+};
+}  // namespace exec
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_EXEC_EXECUTOR_HPP
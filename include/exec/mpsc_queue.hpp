@@ -0,0 +1,120 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_EXEC_MPSC_QUEUE_HPP
+#define TPP_EXEC_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "exec/executor.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace exec
+{
+/**
+ * A bounded lock-free queue for multiple producers and a single consumer.
+ * Every cell carries a sequence number, that tells whether it is free for the producer of a position, or filled for the
+ * consumer. Producers claim positions by CAS on the tail, so that none of them ever waits for another.
+ */
+template<typename T>
+class mpsc_queue
+{
+public:
+    /// The capacity is rounded up to the next power of 2.
+    explicit mpsc_queue(std::size_t capacity_) {
+        std::size_t n{2};
+        while (n < capacity_) {
+            n <<= 1;
+        }
+        m_mask = n - 1;
+        m_cells.reset(new cell[n]);
+        for (std::size_t i{0}; i < n; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc_queue(mpsc_queue const&)     = delete;
+    mpsc_queue(mpsc_queue&&) noexcept = delete;
+    ~mpsc_queue() noexcept            = default;
+    auto
+    operator=(mpsc_queue const&) -> mpsc_queue& = delete;
+    auto
+    operator=(mpsc_queue&&) noexcept -> mpsc_queue& = delete;
+
+    /// Append v_, or return false if the queue is full. May be called by any thread.
+    auto
+    push(T const& v_) -> bool {
+        auto pos{m_tail.load(std::memory_order_relaxed)};
+        for (;;) {
+            auto&      c{m_cells[pos & m_mask]};
+            auto const seq{c.seq.load(std::memory_order_acquire)};
+            if (seq == pos) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = v_;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos) {
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Take the first value into v_, or return false if the queue is empty. Must only be called by the consumer.
+    auto
+    pop(T& v_) -> bool {
+        auto& c{m_cells[m_head & m_mask]};
+        if (c.seq.load(std::memory_order_acquire) != m_head + 1) {
+            return false;
+        }
+        v_ = c.value;
+        c.seq.store(m_head + m_mask + 1, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+    /// Check whether there is nothing to pop. Must only be called by the consumer.
+    auto
+    empty() const -> bool {
+        return m_cells[m_head & m_mask].seq.load(std::memory_order_acquire) != m_head + 1;
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<std::size_t> seq{0};
+        T                        value{};
+    };
+
+    std::unique_ptr<cell[]>  m_cells;
+    std::size_t              m_mask{0};
+    std::atomic<std::size_t> m_tail{0};
+    char                     m_pad[CACHE_LINE_SIZE];  ///< Keeps the tail of producers apart from the consumers head.
+    std::size_t              m_head{0};
+};
+}  // namespace exec
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_EXEC_MPSC_QUEUE_HPP
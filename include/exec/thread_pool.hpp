@@ -0,0 +1,405 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_EXEC_THREAD_POOL_HPP
+#define TPP_EXEC_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "exec/executor.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace exec
+{
+/**
+ * A work-stealing thread pool.
+ * Every worker owns a task queue and takes tasks from its front. Idle workers steal half of the tasks from the back of
+ * another workers queue. If a worker calls parallel_for itself, the new tasks are put in front of its queue and it
+ * keeps executing them, and the tasks they create in turn, until they are done, instead of blocking. Unrelated tasks
+ * are left to other workers, so that a waiting worker never gets stuck below a long running task. Other threads calling
+ * parallel_for distribute the tasks over all queues in order and wait for them. Tasks pinned to a worker by on_workers
+ * are never stolen, and are executed by their worker even while it waits.
+ */
+class thread_pool : public executor
+{
+public:
+    explicit thread_pool(std::size_t threads_) {
+        threads_ = std::max<std::size_t>(threads_, 1);
+        m_queues.reserve(threads_);
+        for (std::size_t i{0}; i < threads_; ++i) {
+            m_queues.emplace_back(new task_queue);
+        }
+        m_workers.reserve(threads_);
+        for (std::size_t i{0}; i < threads_; ++i) {
+            m_workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~thread_pool() noexcept override {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        std::for_each(m_workers.begin(), m_workers.end(), [](std::thread& t_) { t_.join(); });
+    }
+
+    void
+    parallel_for(std::size_t n_, task_function const& fn_) override {
+        if (n_ == 0) {
+            return;
+        }
+        auto const& self{current()};
+        task_group  grp(fn_, n_, self.pool == this ? self.group : nullptr);
+        if (self.pool == this) {
+            push_front(self.index, grp, n_);
+            help(self.index, grp);
+        } else {
+            distribute(grp, n_);
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_cv.wait(lk, [&] { return grp.done(); });
+        }
+        if (grp.error) {
+            std::rethrow_exception(grp.error);
+        }
+    }
+
+    void
+    on_workers(std::vector<std::size_t> const& workers_, task_function const& fn_) override {
+        if (workers_.empty()) {
+            return;
+        }
+        auto const& self{current()};
+        task_group  grp(fn_, workers_.size(), self.pool == this ? self.group : nullptr);
+        for (std::size_t i{0}; i < workers_.size(); ++i) {
+            auto&                       q{*m_queues[workers_[i] % m_queues.size()]};
+            std::lock_guard<std::mutex> lk(q.mutex);
+            q.pinned.push_back(task{&grp, i});
+            ++q.num_pinned;
+        }
+        ++m_generation;
+        notify();
+        if (self.pool == this) {
+            help(self.index, grp);
+        } else {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_cv.wait(lk, [&] { return grp.done(); });
+        }
+        if (grp.error) {
+            std::rethrow_exception(grp.error);
+        }
+    }
+
+    /// A worker puts the task in front of its own queue, other threads put it at the back of the first queue.
+    void
+    spawn(task_function fn_) override {
+        std::unique_ptr<task_function> fn{new task_function(std::move(fn_))};
+        auto* const                    grp{new task_group(*fn, 1, nullptr)};
+        grp->owned = std::move(fn);
+        auto const& self{current()};
+        if (self.pool == this) {
+            push_front(self.index, *grp, 1);
+        } else {
+            distribute(*grp, 1);
+        }
+    }
+
+    auto
+    concurrency() const -> std::size_t override {
+        return m_workers.size();
+    }
+
+    /**
+     * Get a process wide pool with as many workers as there are hardware threads. It is never destroyed, as its workers
+     * do not exist in forked child processes, where exit handlers may run, e.g. if an isolated testcase calls exit().
+     */
+    static auto
+    shared() -> thread_pool& {
+        static thread_pool* const pool{new thread_pool(std::thread::hardware_concurrency())};
+        return *pool;
+    }
+
+private:
+    struct task_group
+    {
+        task_group(task_function const& fn_, std::size_t n_, task_group const* parent_)
+            : fn(fn_), pending(n_), parent(parent_) {}
+
+        inline auto
+        done() const -> bool {
+            return pending.load() == 0;
+        }
+
+        /// Check whether this group is grp_, or was created by a task of grp_ or its descendants.
+        auto
+        within(task_group const& grp_) const -> bool {
+            for (auto const* g{this}; g != nullptr; g = g->parent) {
+                if (g == &grp_) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        task_function const&           fn;
+        std::atomic<std::size_t>       pending;
+        std::mutex                     mutex;
+        std::exception_ptr             error;
+        std::unique_ptr<task_function> owned;   ///< Set for spawned tasks, whose group is owned by the pool.
+        task_group const*              parent;  ///< Group of the task, that created this one. It outlives this one.
+    };
+
+    struct task
+    {
+        task_group* grp;
+        std::size_t idx;
+    };
+
+    /// Allocated separately per worker, and padded to prevent false sharing between neighbours.
+    struct task_queue
+    {
+        std::mutex               mutex;
+        std::deque<task>         tasks;
+        std::deque<task>         pinned;  ///< Tasks, that only this worker may execute.
+        std::atomic<std::size_t> num_pinned{0};
+        char                     pad[CACHE_LINE_SIZE];
+    };
+
+    struct worker_context
+    {
+        thread_pool const* pool;
+        std::size_t        index;
+        task_group const*  group;  ///< Group of the task, that is executed right now.
+    };
+
+    static auto
+    current() -> worker_context& {
+        static thread_local worker_context ctx{nullptr, 0, nullptr};
+        return ctx;
+    }
+
+    void
+    work(std::size_t w_) {
+        current() = worker_context{this, w_, nullptr};
+        for (;;) {
+            task t{};
+            if (pop(w_, t) || steal(w_, t)) {
+                execute(t, w_);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_cv.wait(lk, [&] { return m_stop || m_queued.load() > 0 || m_queues[w_]->num_pinned.load() > 0; });
+            if (m_stop) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Execute tasks of the group and its descendants, and tasks pinned to this worker, until all tasks of the group are
+     * done. Wait, if there are none, until tasks get queued or moved.
+     */
+    void
+    help(std::size_t w_, task_group& grp_) {
+        while (!grp_.done()) {
+            auto const gen{m_generation.load()};
+            task       t{};
+            if (pop_pinned(w_, t) || take(w_, grp_, t)) {
+                execute(t, w_);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_cv.wait(lk, [&] {
+                return grp_.done() || m_generation.load() != gen || m_queues[w_]->num_pinned.load() > 0;
+            });
+        }
+    }
+
+    void
+    execute(task const& t_, std::size_t w_) {
+        auto&      ctx{current()};
+        auto const outer{ctx.group};
+        ctx.group = t_.grp;
+        try {
+            t_.grp->fn(t_.idx, w_);
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(t_.grp->mutex);
+            if (!t_.grp->error) {
+                t_.grp->error = std::current_exception();
+            }
+        }
+        ctx.group = outer;
+        if (t_.grp->owned) {
+            delete t_.grp;
+            return;
+        }
+        // The group must not be touched after the last task is done, as its owner may return immediately.
+        if (t_.grp->pending.fetch_sub(1) == 1) {
+            notify();
+        }
+    }
+
+    auto
+    pop_pinned(std::size_t w_, task& t_) -> bool {
+        auto&                       q{*m_queues[w_]};
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (q.pinned.empty()) {
+            return false;
+        }
+        t_ = q.pinned.front();
+        q.pinned.pop_front();
+        --q.num_pinned;
+        return true;
+    }
+
+    auto
+    pop(std::size_t w_, task& t_) -> bool {
+        if (pop_pinned(w_, t_)) {
+            return true;
+        }
+        auto&                       q{*m_queues[w_]};
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (q.tasks.empty()) {
+            return false;
+        }
+        t_ = q.tasks.front();
+        q.tasks.pop_front();
+        --m_queued;
+        return true;
+    }
+
+    /// Steal half of the tasks from the first non empty queue of another worker.
+    auto
+    steal(std::size_t w_, task& t_) -> bool {
+        std::vector<task> loot;
+        for (std::size_t k{1}; k < m_queues.size() && loot.empty(); ++k) {
+            auto&                       victim{*m_queues[(w_ + k) % m_queues.size()]};
+            std::lock_guard<std::mutex> lk(victim.mutex);
+            auto const                  n{(victim.tasks.size() + 1) / 2};
+            auto const                  from{victim.tasks.end() - static_cast<std::ptrdiff_t>(n)};
+            loot.assign(from, victim.tasks.end());
+            victim.tasks.erase(from, victim.tasks.end());
+        }
+        if (loot.empty()) {
+            return false;
+        }
+        t_ = loot.front();
+        --m_queued;
+        if (loot.size() > 1) {
+            {
+                auto&                       q{*m_queues[w_]};
+                std::lock_guard<std::mutex> lk(q.mutex);
+                q.tasks.insert(q.tasks.end(), loot.begin() + 1, loot.end());
+            }
+            // Waiting workers may have missed their tasks in the loot.
+            ++m_generation;
+            notify();
+        }
+        return true;
+    }
+
+    /**
+     * Take a task of the group or its descendants from the front of the own queue, or else from the back of another
+     * workers queue.
+     */
+    auto
+    take(std::size_t w_, task_group const& grp_, task& t_) -> bool {
+        auto const of_group{[&](task const& c_) { return c_.grp->within(grp_); }};
+        for (std::size_t k{0}; k < m_queues.size(); ++k) {
+            auto&                       q{*m_queues[(w_ + k) % m_queues.size()]};
+            std::lock_guard<std::mutex> lk(q.mutex);
+            auto                        it{q.tasks.end()};
+            if (k == 0) {
+                it = std::find_if(q.tasks.begin(), q.tasks.end(), of_group);
+            } else {
+                auto const rit{std::find_if(q.tasks.rbegin(), q.tasks.rend(), of_group)};
+                it = rit == q.tasks.rend() ? q.tasks.end() : std::prev(rit.base());
+            }
+            if (it != q.tasks.end()) {
+                t_ = *it;
+                q.tasks.erase(it);
+                --m_queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void
+    push_front(std::size_t w_, task_group& grp_, std::size_t n_) {
+        auto& q{*m_queues[w_]};
+        {
+            std::lock_guard<std::mutex> lk(q.mutex);
+            m_queued += n_;
+            for (std::size_t i{n_}; i > 0; --i) {
+                q.tasks.push_front(task{&grp_, i - 1});
+            }
+        }
+        ++m_generation;
+        notify();
+    }
+
+    /// Distribute tasks round robin, so that they are started roughly in order.
+    void
+    distribute(task_group& grp_, std::size_t n_) {
+        m_queued += n_;
+        for (std::size_t w{0}; w < m_queues.size() && w < n_; ++w) {
+            auto&                       q{*m_queues[w]};
+            std::lock_guard<std::mutex> lk(q.mutex);
+            for (std::size_t i{w}; i < n_; i += m_queues.size()) {
+                q.tasks.push_back(task{&grp_, i});
+            }
+        }
+        ++m_generation;
+        notify();
+    }
+
+    void
+    notify() {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+        }
+        m_cv.notify_all();
+    }
+
+    std::vector<std::unique_ptr<task_queue>> m_queues;
+    std::atomic<std::size_t>                 m_queued{0};      ///< Upper bound of the tasks in all queues.
+    std::atomic<std::size_t>                 m_generation{0};  ///< Count of changes, that may bring tasks to helpers.
+    std::mutex                               m_mutex;
+    std::condition_variable                  m_cv;
+    bool                                     m_stop{false};
+    std::vector<std::thread>                 m_workers;
+};
+}  // namespace exec
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_EXEC_THREAD_POOL_HPP
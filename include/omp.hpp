@@ -1,31 +0,0 @@
-/*
-    Copyright (C) 2017  Jarthianur
-
-    This program is free software: you can redistribute it and/or modify
-    it under the terms of the GNU General Public License as published by
-    the Free Software Foundation, either version 3 of the License, or
-    (at your option) any later version.
-
-    This program is distributed in the hope that it will be useful,
-    but WITHOUT ANY WARRANTY; without even the implied warranty of
-    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-    GNU General Public License for more details.
-
-    You should have received a copy of the GNU General Public License
-    along with this program.  If not, see <https://www.gnu.org/licenses/>.
-*/
-
-/// @file
-
-#ifndef TPP_OMP_HPP
-#define TPP_OMP_HPP
-
-#ifdef _OPENMP
-#    include <omp.h>
-#else
-#    define omp_get_max_threads() 1
-#    define omp_get_thread_num() 0
-#    define omp_set_num_threads(N)
-#endif
-
-#endif  // TPP_OMP_HPP
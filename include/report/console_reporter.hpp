@@ -59,6 +59,18 @@ private:
     void
     report_testcase(test::testcase const& tc_) override {
         *this << fmt::SPACE << tc_.name() << " (" << tc_.elapsed_time() << "ms)" << fmt::LF << fmt::SPACE << fmt::SPACE;
+        auto const& reps{tc_.repetitions()};
+        if (reps.runs() > 1) {
+            *this << "runs = " << reps.runs() << ", failed = " << reps.failures() << ", min = " << reps.min()
+                  << "ms, median = " << reps.median() << "ms, p99 = " << reps.p99() << "ms" << fmt::LF << fmt::SPACE
+                  << fmt::SPACE;
+        }
+        auto const& bench{tc_.measured()};
+        if (!bench.samples().empty()) {
+            *this << "iterations = " << bench.iterations() << ", mean = " << bench.mean() << "ns, median = "
+                  << bench.median() << "ns, stddev = " << bench.stddev() << "ns, min = " << bench.min() << "ns, max = "
+                  << bench.max() << "ns" << fmt::LF << fmt::SPACE << fmt::SPACE;
+        }
         if (capture()) {
             *this << "stdout = \"" << escaped_string(tc_.cout()) << '"' << fmt::LF << fmt::SPACE << fmt::SPACE;
             *this << "stderr = \"" << escaped_string(tc_.cerr()) << '"' << fmt::LF << fmt::SPACE << fmt::SPACE;
@@ -66,11 +78,21 @@ private:
         switch (tc_.result()) {
             case test::testcase::HAD_ERROR: *this << color().RED << "ERROR! " << tc_.reason(); break;
             case test::testcase::HAS_FAILED: *this << color().BLUE << "FAILED! " << tc_.reason(); break;
+            case test::testcase::IS_UNDONE: *this << color().YELLOW << "SKIPPED!"; break;
             default: *this << color().GREEN << "PASSED!"; break;
         }
         *this << color() << fmt::LF;
     }
 
+    void
+    begin_report() override {
+        reporter::begin_report();
+
+        if (shuffled()) {
+            *this << "Shuffled with seed " << seed() << fmt::LF << fmt::LF;
+        }
+    }
+
     void
     end_report() override {
         if (abs_errs() > 0) {
@@ -80,9 +102,12 @@ private:
         } else {
             *this << color().CYAN;
         }
-        *this << "=== Result ===" << fmt::LF << "passes: " << abs_tests() - faults() << '/' << abs_tests()
-              << " failures: " << abs_fails() << '/' << abs_tests() << " errors: " << abs_errs() << '/' << abs_tests()
-              << " (" << abs_time() << "ms)" << color() << fmt::LF;
+        *this << "=== Result ===" << fmt::LF << "passes: " << abs_passes() << '/' << abs_tests()
+              << " failures: " << abs_fails() << '/' << abs_tests() << " errors: " << abs_errs() << '/' << abs_tests();
+        if (abs_skips() > 0) {
+            *this << " skipped: " << abs_skips() << '/' << abs_tests();
+        }
+        *this << " (" << abs_time() << "ms)" << color() << fmt::LF;
     }
 };
 }  // namespace report
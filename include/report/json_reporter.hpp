@@ -52,7 +52,6 @@ public:
 private:
     void
     report_testsuite(test::testsuite_ptr const& ts_) override {
-        m_first_test = true;
         conditional_prefix(&m_first_suite);
         json_property_string("name", ts_->name(), true, color().CYAN);
         json_property_value("time", ts_->statistics().elapsed_time(), true);
@@ -60,6 +59,9 @@ private:
         json_property_value("passes", ts_->statistics().successes(), true);
         json_property_value("failures", ts_->statistics().failures(), true);
         json_property_value("errors", ts_->statistics().errors(), true);
+        if (ts_->statistics().skipped() > 0) {
+            json_property_value("skipped", ts_->statistics().skipped(), true);
+        }
         *this << "\"tests\":";
         space();
         *this << '[';
@@ -72,6 +74,8 @@ private:
         newline();
         *this << '}';
         pop_indent();
+        // Reset afterwards, as the testcases of the next testsuite may be prepared before it is reported.
+        m_first_test = true;
     }
 
     void
@@ -81,6 +85,23 @@ private:
         json_property_string("name", tc_.name(), true, color().W_BOLD);
         json_property_string("result", std::get<0>(dres), true, std::get<1>(dres));
         json_property_string("reason", tc_.reason(), true, std::get<1>(dres));
+        auto const& reps{tc_.repetitions()};
+        if (reps.runs() > 1) {
+            json_property_value("runs", reps.runs(), true);
+            json_property_value("failed_runs", reps.failures(), true);
+            json_property_value("min", reps.min(), true);
+            json_property_value("median", reps.median(), true);
+            json_property_value("p99", reps.p99(), true);
+        }
+        auto const& bench{tc_.measured()};
+        if (!bench.samples().empty()) {
+            json_property_value("iterations", bench.iterations(), true);
+            json_property_value("mean_ns", bench.mean(), true);
+            json_property_value("median_ns", bench.median(), true);
+            json_property_value("stddev_ns", bench.stddev(), true);
+            json_property_value("min_ns", bench.min(), true);
+            json_property_value("max_ns", bench.max(), true);
+        }
         json_property_value("time", tc_.elapsed_time(), capture());
         if (capture()) {
             json_property_string("stdout", tc_.cout(), true);
@@ -99,6 +120,9 @@ private:
         *this << '{';
         push_indent();
         newline();
+        if (shuffled()) {
+            json_property_value("seed", seed(), true);
+        }
         *this << "\"testsuites\":";
         space();
         *this << '[';
@@ -110,9 +134,12 @@ private:
         *this << "],";
         newline();
         json_property_value("count", abs_tests(), true, color().W_BOLD);
-        json_property_value("passes", abs_tests() - faults(), true, color().GREEN);
+        json_property_value("passes", abs_passes(), true, color().GREEN);
         json_property_value("failures", abs_fails(), true, color().BLUE);
         json_property_value("errors", abs_errs(), true, color().RED);
+        if (abs_skips() > 0) {
+            json_property_value("skipped", abs_skips(), true, color().YELLOW);
+        }
         json_property_value("time", abs_time(), false);
         pop_indent();
         newline();
@@ -163,6 +190,7 @@ private:
         switch (res_) {
             case test::testcase::HAD_ERROR: return {"error", color().RED};
             case test::testcase::HAS_FAILED: return {"failure", color().BLUE};
+            case test::testcase::IS_UNDONE: return {"skipped", color().YELLOW};
             default: return {"success", color().GREEN};
         }
     }
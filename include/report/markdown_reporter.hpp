@@ -50,9 +50,10 @@ public:
 private:
     void
     report_testsuite(test::testsuite_ptr const& ts_) override {
-        *this << "## " << ts_->name() << fmt::LF << fmt::LF << "|Tests|Successes|Failures|Errors|Time|" << fmt::LF
-              << "|-|-|-|-|-|" << fmt::LF << '|' << ts_->statistics().tests() << '|' << ts_->statistics().successes()
-              << '|' << ts_->statistics().failures() << '|' << ts_->statistics().errors() << '|'
+        *this << "## " << ts_->name() << fmt::LF << fmt::LF << "|Tests|Successes|Failures|Errors|Skipped|Time|"
+              << fmt::LF << "|-|-|-|-|-|-|" << fmt::LF << '|' << ts_->statistics().tests() << '|'
+              << ts_->statistics().successes() << '|' << ts_->statistics().failures() << '|'
+              << ts_->statistics().errors() << '|' << ts_->statistics().skipped() << '|'
               << ts_->statistics().elapsed_time() << "ms|" << fmt::LF << fmt::LF << "### Tests" << fmt::LF << fmt::LF
               << "|Name|Time|Status|" << fmt::LF << "|-|-|-|" << fmt::LF;
 
@@ -69,10 +70,27 @@ private:
             switch (tc_.result()) {
                 case test::testcase::HAD_ERROR: return "ERROR";
                 case test::testcase::HAS_FAILED: return "FAILED";
+                case test::testcase::IS_UNDONE: return "SKIPPED";
                 default: return "PASSED";
             }
         };
-        *this << '|' << tc_.name() << '|' << tc_.elapsed_time() << "ms|" << status() << '|' << fmt::LF;
+        auto const& reps{tc_.repetitions()};
+        *this << '|' << tc_.name() << '|' << tc_.elapsed_time() << "ms";
+        if (reps.runs() > 1) {
+            *this << " (" << reps.runs() << " runs, min " << reps.min() << "ms, median " << reps.median() << "ms, p99 "
+                  << reps.p99() << "ms)";
+        }
+        auto const& bench{tc_.measured()};
+        if (!bench.samples().empty()) {
+            *this << " (" << bench.iterations() << " iterations, mean " << bench.mean() << "ns, median "
+                  << bench.median() << "ns, stddev " << bench.stddev() << "ns, min " << bench.min() << "ns, max "
+                  << bench.max() << "ns)";
+        }
+        *this << '|' << status();
+        if (reps.runs() > 1) {
+            *this << " (" << reps.failures() << '/' << reps.runs() << " failed)";
+        }
+        *this << '|' << fmt::LF;
     }
 
     void
@@ -80,18 +98,22 @@ private:
         reporter::begin_report();
 
         *this << "# Test Report" << fmt::LF << fmt::LF;
+        if (shuffled()) {
+            *this << "Shuffled with seed " << seed() << fmt::LF << fmt::LF;
+        }
     }
 
     void
     end_report() override {
-        *this << "## Summary" << fmt::LF << fmt::LF << "|Tests|Successes|Failures|Errors|Time|" << fmt::LF
-              << "|-|-|-|-|-|" << fmt::LF << '|' << abs_tests() << '|' << (abs_tests() - faults()) << '|' << abs_fails()
-              << '|' << abs_errs() << '|' << abs_time() << "ms|" << fmt::LF;
+        *this << "## Summary" << fmt::LF << fmt::LF << "|Tests|Successes|Failures|Errors|Skipped|Time|" << fmt::LF
+              << "|-|-|-|-|-|-|" << fmt::LF << '|' << abs_tests() << '|' << abs_passes() << '|' << abs_fails()
+              << '|' << abs_errs() << '|' << abs_skips() << '|' << abs_time() << "ms|" << fmt::LF;
     }
 
     void
     testcase_details(test::testcase const& tc_) {
-        bool const isFailed = tc_.result() != test::testcase::HAS_PASSED;
+        bool const isFailed =
+            tc_.result() == test::testcase::HAS_FAILED || tc_.result() == test::testcase::HAD_ERROR;
         if (isFailed || capture()) {
             *this << "#### " << tc_.name() << fmt::LF << fmt::LF;
         }
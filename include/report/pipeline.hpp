@@ -0,0 +1,208 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_REPORT_PIPELINE_HPP
+#define TPP_REPORT_PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "exec/mpsc_queue.hpp"
+#include "report/reporter.hpp"
+#include "test/streambuf_proxy.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace report
+{
+/**
+ * Feeds a reporter from its own thread, so that formatting and writing the report overlaps with test execution.
+ * Testsuites announce every testcase, and themselves when they are done, through a lock-free queue. The reporter thread
+ * prepares a testcase as soon as it and all testcases before it are done, and reports whole testsuites in the given
+ * order. This way the report stays the same, no matter in which order tests are executed.
+ */
+class pipeline
+{
+public:
+    pipeline(reporter_ptr const& rep_, std::vector<test::testsuite_ptr> const& suites_)
+        : m_rep(rep_), m_suites(suites_), m_errors(suites_.size()), m_queue(capacity(suites_)) {
+        for (std::size_t i{0}; i < m_suites.size(); ++i) {
+            m_suites[i]->on_done([this, i](std::size_t tc_) { push(event{i, tc_}); });
+        }
+        // The reporter writes into the same capture buffers as the thread, that starts the pipeline.
+        auto* const bufs{test::streambuf_proxy::current()};
+        m_thread = std::thread([this, bufs] {
+            test::streambuf_proxy::current() = bufs;
+            consume();
+        });
+    }
+
+    pipeline(pipeline const&)     = delete;
+    pipeline(pipeline&&) noexcept = delete;
+    ~pipeline() noexcept {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_one();
+            m_thread.join();
+        }
+        detach();
+    }
+    auto
+    operator=(pipeline const&) -> pipeline& = delete;
+    auto
+    operator=(pipeline&&) noexcept -> pipeline& = delete;
+
+    /// Announce that the testsuite at index ts_ is done, or failed with err_.
+    void
+    done(std::size_t ts_, std::exception_ptr const& err_ = nullptr) {
+        m_errors[ts_] = err_;
+        push(event{ts_, SUITE});
+    }
+
+    /**
+     * Wait until all testsuites are reported. Reporting stops at the first testsuite in order, that failed, and its
+     * error is rethrown. Hence testsuites after it do not have to be done. Errors of the reporter are rethrown as well.
+     */
+    void
+    finish() {
+        m_thread.join();
+        detach();
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+private:
+    /// Marks an event for a whole testsuite, instead of a testcase.
+    static constexpr std::size_t SUITE = std::numeric_limits<std::size_t>::max();
+
+    struct event
+    {
+        std::size_t ts;
+        std::size_t tc;
+    };
+
+    static auto
+    capacity(std::vector<test::testsuite_ptr> const& suites_) -> std::size_t {
+        std::size_t n{suites_.size()};
+        std::for_each(suites_.cbegin(), suites_.cend(),
+                      [&](test::testsuite_ptr const& ts_) { n += ts_->testcases().size(); });
+        return n;
+    }
+
+    void
+    push(event const& ev_) {
+        while (!m_queue.push(ev_)) {
+            std::this_thread::yield();
+        }
+        // Pairs with the fence in pop(), so that either the consumer sees the event, or this sees it waiting.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_cv.notify_one();
+        }
+    }
+
+    auto
+    pop(event& ev_) -> bool {
+        while (!m_queue.pop(ev_)) {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_cv.wait(lk, [&] { return m_stop || !m_queue.empty(); });
+            m_waiting.store(false, std::memory_order_relaxed);
+            if (m_stop) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void
+    consume() {
+        std::vector<std::vector<char>> tc_done;
+        std::vector<char>              ts_done(m_suites.size(), 0);
+        tc_done.reserve(m_suites.size());
+        std::for_each(m_suites.cbegin(), m_suites.cend(),
+                      [&](test::testsuite_ptr const& ts_) { tc_done.emplace_back(ts_->testcases().size(), 0); });
+        std::size_t cur{0};
+        std::size_t next{0};
+        try {
+            event ev{};
+            while (cur < m_suites.size() && pop(ev)) {
+                if (ev.tc == SUITE) {
+                    ts_done[ev.ts] = 1;
+                } else {
+                    tc_done[ev.ts][ev.tc] = 1;
+                }
+                while (cur < m_suites.size()) {
+                    if (ts_done[cur] && m_errors[cur]) {
+                        m_error = m_errors[cur];
+                        return;
+                    }
+                    auto const& tcs{m_suites[cur]->testcases()};
+                    for (; next < tcs.size() && (ts_done[cur] || tc_done[cur][next]); ++next) {
+                        m_rep->prepare(tcs[next]);
+                    }
+                    if (!ts_done[cur]) {
+                        break;
+                    }
+                    m_rep->report(m_suites[cur]);
+                    ++cur;
+                    next = 0;
+                }
+            }
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+    }
+
+    void
+    detach() {
+        std::for_each(m_suites.cbegin(), m_suites.cend(),
+                      [](test::testsuite_ptr const& ts_) { ts_->on_done(test::testsuite::done_function()); });
+    }
+
+    reporter_ptr                            m_rep;
+    std::vector<test::testsuite_ptr> const& m_suites;
+    std::vector<std::exception_ptr>         m_errors;
+    std::exception_ptr                      m_error;
+    exec::mpsc_queue<event>                 m_queue;
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_cv;
+    std::atomic<bool>                       m_waiting{false};
+    bool                                    m_stop{false};
+    std::thread                             m_thread;
+};
+}  // namespace report
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_REPORT_PIPELINE_HPP
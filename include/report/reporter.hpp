@@ -23,9 +23,11 @@
 #include <fstream>
 #include <memory>
 #include <ostream>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "test/testsuite.hpp"
 
@@ -69,13 +71,37 @@ public:
     void
     report(test::testsuite_ptr const& ts_) {
         report_testsuite(ts_);
+        m_fragments.clear();
         m_out_stream.flush();
     }
 
+    /**
+     * Format a testcase in advance, while its testsuite may still run. Testcases must be prepared in their order, and are
+     * written by the next call to report(), instead of being formatted there.
+     */
+    void
+    prepare(test::testcase const& tc_) {
+        std::ostringstream buf;
+        m_fragments.emplace_back();
+        auto const lvl{m_indent_lvl};
+        m_indent_lvl = 0;
+        m_out        = &buf;
+        m_fragment   = &m_fragments.back();
+        try {
+            report_testcase(tc_);
+        } catch (...) {
+            end_fragment(lvl);
+            throw;
+        }
+        end_fragment(lvl);
+        m_fragments.back().text = buf.str();
+    }
+
     virtual void
     begin_report() {
         m_abs_errs  = 0;
         m_abs_fails = 0;
+        m_abs_skips = 0;
         m_abs_tests = 0;
         m_abs_time  = .0;
     };
@@ -113,6 +139,14 @@ public:
         return shared_from_this();
     }
 
+    /// Report the seed, that the order of tests was shuffled with.
+    auto
+    with_seed(std::uint64_t seed_) -> reporter_ptr {
+        m_shuffled = true;
+        m_seed     = seed_;
+        return shared_from_this();
+    }
+
 protected:
     /// Helper type to prevent public constructor usage.
     struct enable
@@ -134,13 +168,14 @@ protected:
         }
     };
 
-    explicit reporter(std::ostream& stream_) : m_out_stream(stream_) {
+    explicit reporter(std::ostream& stream_) : m_out_stream(stream_), m_out(&m_out_stream) {
         if (!m_out_stream) {
             throw std::runtime_error("could not open stream for report");
         }
     }
 
-    explicit reporter(std::string const& fname_) : m_out_file(fname_), m_out_stream(m_out_file) {
+    explicit reporter(std::string const& fname_)
+        : m_out_file(fname_), m_out_stream(m_out_file), m_out(&m_out_stream) {
         if (!m_out_stream) {
             throw std::runtime_error("could not open file for report");
         }
@@ -150,10 +185,16 @@ protected:
     report_testsuite(test::testsuite_ptr const& ts_) {
         m_abs_errs += ts_->statistics().errors();
         m_abs_fails += ts_->statistics().failures();
+        m_abs_skips += ts_->statistics().skipped();
         m_abs_tests += ts_->statistics().tests();
         m_abs_time += ts_->statistics().elapsed_time();
-        std::for_each(ts_->testcases().begin(), ts_->testcases().end(),
-                      [this](test::testcase const& tc_) { report_testcase(tc_); });
+        for (std::size_t i{0}; i < ts_->testcases().size(); ++i) {
+            if (i < m_fragments.size()) {
+                write_fragment(m_fragments[i]);
+            } else {
+                report_testcase(ts_->testcases()[i]);
+            }
+        }
     }
 
     virtual void
@@ -162,8 +203,8 @@ protected:
     template<typename T>
     auto
     operator<<(T&& t_) const -> std::ostream& {
-        m_out_stream << std::forward<T>(t_);
-        return m_out_stream;
+        *m_out << std::forward<T>(t_);
+        return *m_out;
     }
 
     /// Has side-effects, so care about evaluation order!
@@ -183,6 +224,9 @@ protected:
             for (auto i{0U}; i < depth_; ++i) {
                 *this << fmt::LF;
             }
+            if (m_fragment) {
+                m_fragment->breaks.push_back(static_cast<std::size_t>(m_out->tellp()));
+            }
         }
         space(m_indent_lvl);
     }
@@ -217,27 +261,78 @@ protected:
         return m_abs_errs;
     }
 
+    inline auto
+    abs_skips() const -> std::size_t {
+        return m_abs_skips;
+    }
+
+    inline auto
+    abs_passes() const -> std::size_t {
+        return m_abs_tests - m_abs_errs - m_abs_fails - m_abs_skips;
+    }
+
     inline auto
     abs_time() const -> double {
         return m_abs_time;
     }
 
+    inline auto
+    shuffled() const -> bool {
+        return m_shuffled;
+    }
+
+    inline auto
+    seed() const -> std::uint64_t {
+        return m_seed;
+    }
+
     auto
     color() const -> color_palette const& {
         return m_colors;
     }
 
 private:
-    std::ofstream m_out_file;
-    std::ostream& m_out_stream;
-    std::uint32_t m_indent_lvl{0};
-    color_palette m_colors{};
-    bool          m_capture{false};
-    bool          m_stripped{false};
-    std::size_t   m_abs_tests{0};
-    std::size_t   m_abs_fails{0};
-    std::size_t   m_abs_errs{0};
-    double        m_abs_time{0};
+    /// A formatted testcase, and the positions after line breaks, where the indentation of the report is inserted.
+    struct fragment
+    {
+        std::string              text;
+        std::vector<std::size_t> breaks;
+    };
+
+    void
+    end_fragment(std::uint32_t lvl_) {
+        m_indent_lvl = lvl_;
+        m_out        = &m_out_stream;
+        m_fragment   = nullptr;
+    }
+
+    void
+    write_fragment(fragment const& frag_) const {
+        std::size_t pos{0};
+        std::for_each(frag_.breaks.cbegin(), frag_.breaks.cend(), [&](std::size_t brk_) {
+            m_out->write(frag_.text.data() + pos, static_cast<std::streamsize>(brk_ - pos));
+            space(m_indent_lvl);
+            pos = brk_;
+        });
+        m_out->write(frag_.text.data() + pos, static_cast<std::streamsize>(frag_.text.size() - pos));
+    }
+
+    std::ofstream         m_out_file;
+    std::ostream&         m_out_stream;
+    std::ostream*         m_out;  ///< Either the report stream, or the buffer of the fragment in preparation.
+    std::vector<fragment> m_fragments;
+    fragment*             m_fragment{nullptr};
+    std::uint32_t         m_indent_lvl{0};
+    color_palette         m_colors{};
+    bool                  m_capture{false};
+    bool                  m_stripped{false};
+    bool                  m_shuffled{false};
+    std::uint64_t         m_seed{0};
+    std::size_t           m_abs_tests{0};
+    std::size_t           m_abs_fails{0};
+    std::size_t           m_abs_errs{0};
+    std::size_t           m_abs_skips{0};
+    double                m_abs_time{0};
 };
 }  // namespace report
 }  // namespace intern
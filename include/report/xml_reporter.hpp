@@ -59,7 +59,8 @@ private:
         newline();
         *this << "<testsuite id=\"" << m_id++ << "\" name=\"" << ts_->name() << "\" errors=\""
               << ts_->statistics().errors() << "\" tests=\"" << ts_->statistics().tests() << "\" failures=\""
-              << ts_->statistics().failures() << R"(" skipped="0" time=")" << ts_->statistics().elapsed_time()
+              << ts_->statistics().failures() << "\" skipped=\"" << ts_->statistics().skipped() << "\" time=\""
+              << ts_->statistics().elapsed_time()
               << "\" timestamp=\"" << buff.data() << "\">";
 
         reporter::report_testsuite(ts_);
@@ -75,7 +76,26 @@ private:
         newline();
         *this << "<testcase name=\"" << tc_.name() << "\" classname=\"" << tc_.suite_name() << "\" time=\""
               << tc_.elapsed_time() << "\"";
-        if (tc_.result() != test::testcase::HAS_PASSED) {
+        auto const& reps{tc_.repetitions()};
+        if (reps.runs() > 1) {
+            *this << " runs=\"" << reps.runs() << "\" failed_runs=\"" << reps.failures() << "\" min=\"" << reps.min()
+                  << "\" median=\"" << reps.median() << "\" p99=\"" << reps.p99() << "\"";
+        }
+        auto const& bench{tc_.measured()};
+        if (!bench.samples().empty()) {
+            *this << " iterations=\"" << bench.iterations() << "\" mean_ns=\"" << bench.mean() << "\" median_ns=\""
+                  << bench.median() << "\" stddev_ns=\"" << bench.stddev() << "\" min_ns=\"" << bench.min()
+                  << "\" max_ns=\"" << bench.max() << "\"";
+        }
+        if (tc_.result() == test::testcase::IS_UNDONE) {
+            *this << '>';
+            push_indent();
+            newline();
+            *this << "<skipped/>";
+            pop_indent();
+            newline();
+            *this << "</testcase>";
+        } else if (tc_.result() != test::testcase::HAS_PASSED) {
             auto const unsuccess = [&] { return tc_.result() == test::testcase::HAD_ERROR ? "error" : "failure"; };
             *this << '>';
             push_indent();
@@ -102,7 +122,11 @@ private:
 
         *this << R"(<?xml version="1.0" encoding="UTF-8" ?>)";
         newline();
-        *this << "<testsuites>";
+        *this << "<testsuites";
+        if (shuffled()) {
+            *this << " seed=\"" << seed() << '"';
+        }
+        *this << '>';
     }
 
     void
@@ -19,14 +19,33 @@
 #define TPP_RUNNER_HPP
 
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "report/pipeline.hpp"
 #include "report/reporter.hpp"
+#include "test/baseline.hpp"
+#include "test/distributor.hpp"
+#include "test/manifest.hpp"
+#include "test/registry.hpp"
+#include "test/run_cache.hpp"
+#include "test/selection.hpp"
+#include "test/suite_graph.hpp"
 #include "test/testsuite.hpp"
 #include "test/testsuite_parallel.hpp"
+#include "test/worker.hpp"
 
 #include "cmdline_parser.hpp"
-#include "omp.hpp"
 
 namespace tpp
 {
@@ -34,6 +53,8 @@ namespace intern
 {
 class runner
 {
+    friend class aggregator;
+
     enum class retval : int
     {
         HELP   = -1,
@@ -41,11 +62,32 @@ class runner
     };
 
 public:
+    runner() = default;
+
+    /// Create a runner, that also runs all testsuites defined in reg_.
+    explicit runner(test::registry const& reg_) : m_registry(&reg_) {}
+
     void
     add_testsuite(test::testsuite_ptr const& ts_) {
         m_testsuites.push_back(ts_);
     }
 
+    /**
+     * Add a testsuite, that is run by workers of another binary, which know it by id_. Such workers are spawned by the
+     * function given to spawn_by(), and all testcases are run by workers then.
+     */
+    void
+    add_remote(test::testsuite_ptr const& ts_, std::size_t binary_, std::size_t id_) {
+        m_remote.push_back(ts_);
+        m_origins[ts_.get()] = origin{binary_ + 1, id_};
+    }
+
+    /// Spawn workers of the binary with the number given to add_remote() by fn_.
+    void
+    spawn_by(test::distributor::spawn_function&& fn_) {
+        m_spawn = std::move(fn_);
+    }
+
     auto
     run(int argc_, char const** argv_) noexcept -> int {
         cmdline_parser cmd;
@@ -64,29 +106,145 @@ public:
 
     auto
     run(config const& cfg_) noexcept -> int {
-        omp_set_num_threads(cfg_.thd_count);
-        bool const fm_inc{cfg_.f_mode != config::filter_mode::EXCLUDE};
         try {
-            auto rep{cfg_.reporter()};
-            rep->begin_report();
-            std::for_each(m_testsuites.begin(), m_testsuites.end(), [&](test::testsuite_ptr& ts_) {
-                bool const match{
-                  cfg_.f_patterns.empty() ||
-                  std::any_of(cfg_.f_patterns.cbegin(), cfg_.f_patterns.cend(),
-                              [&](std::regex const& re_) -> bool { return std::regex_match(ts_->name(), re_); })};
-                if (fm_inc == match) {
-                    try {
-                        ts_->run();
-                    } catch (std::exception const& e) {
-                        throw std::runtime_error(std::string(">") + ts_->name() + "< [" + name_for_type(e) + "] " +
-                                                 e.what());
-                    } catch (...) {
-                        throw std::runtime_error(std::string(">") + ts_->name() + "< unknown error");
+            if (!cfg_.worker.empty()) {
+                std::vector<test::testsuite_ptr> suites(m_registry ? m_registry->instantiate()
+                                                                   : std::vector<test::testsuite_ptr>());
+                suites.insert(suites.end(), m_testsuites.cbegin(), m_testsuites.cend());
+                auto conn{test::connection::open(cfg_.worker)};
+                test::worker(suites).serve(conn->chan());
+                return 0;
+            }
+            // Testcases are selected before anything is instantiated. Workers know testsuites by their index, before
+            // any was filtered.
+            std::vector<test::selection>                     sel;
+            std::map<test::suite_record const*, std::size_t> ids;
+            for (auto const* r{m_registry ? m_registry->front() : nullptr}; r; r = r->next()) {
+                ids[r] = sel.size();
+                sel.emplace_back(*r);
+            }
+            auto origins{m_origins};
+            std::for_each(m_testsuites.cbegin(), m_testsuites.cend(), [&](test::testsuite_ptr const& ts_) {
+                origins[ts_.get()] = origin{0, sel.size()};
+                sel.emplace_back(ts_);
+            });
+            std::for_each(m_remote.cbegin(), m_remote.cend(),
+                          [&](test::testsuite_ptr const& ts_) { sel.emplace_back(ts_); });
+            if (!cfg_.f_patterns.empty()) {
+                cfg_.f_patterns.apply(sel, cfg_.f_mode != config::filter_mode::EXCLUDE);
+            }
+            test::run_cache cache;
+            if (!cfg_.cache_file.empty()) {
+                cache.load(cfg_.cache_file);
+            } else if (cfg_.rerun_failed || cfg_.failed_first) {
+                throw std::runtime_error("rerunning failed testcases requires a cache file");
+            }
+            if (cfg_.rerun_failed) {
+                std::for_each(sel.begin(), sel.end(), [&](test::selection& s_) {
+                    for (std::size_t i{0}; i < s_.tests().size(); ++i) {
+                        s_.keep()[i] = s_.keep()[i] != 0 && cache.failed(s_.name(), s_.tests()[i].name);
                     }
-                    rep->report(ts_);
+                });
+                remove_empty(sel);
+            }
+            if (cfg_.shard.count > 1) {
+                cfg_.shard.apply(sel, cache);
+                remove_empty(sel);
+            }
+            std::vector<test::testsuite_ptr> suites;
+            std::for_each(sel.cbegin(), sel.cend(), [&](test::selection const& s_) {
+                suites.push_back(s_.instantiate());
+                if (s_.record()) {
+                    origins[suites.back().get()] = origin{0, ids.at(s_.record())};
                 }
             });
+            if (cfg_.shuffle.enabled) {
+                cfg_.shuffle.apply(suites);
+            }
+            if (cfg_.failed_first) {
+                cache.failed_first();
+                std::stable_partition(suites.begin(), suites.end(),
+                                      [&](test::testsuite_ptr const& ts_) { return cache.failed(*ts_); });
+            }
+            if (cfg_.list_fmt != config::list_format::NONE) {
+                list(suites, cache, cfg_);
+                return 0;
+            }
+            auto const cancel{std::make_shared<test::cancellation>(static_cast<std::size_t>(cfg_.fail_fast))};
+            auto const res{std::make_shared<test::resources>()};
+            test::baseline_ptr base;
+            if (!cfg_.compare_baseline.empty()) {
+                auto b{std::make_shared<test::baseline>()};
+                b->load(cfg_.compare_baseline);
+                b->thresholds(cfg_.max_regression, cfg_.significance);
+                base = std::move(b);
+            }
+            std::for_each(suites.begin(), suites.end(), [&](test::testsuite_ptr& ts_) {
+                ts_->cancel_by(cancel);
+                ts_->limit_by(res);
+                std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(),
+                              [&](test::testcase const& tc_) { res->declare(tc_.attributes().resources); });
+                if (base) {
+                    ts_->compare_by(base);
+                }
+                if (cfg_.isolated) {
+                    ts_->isolate();
+                }
+                ts_->timeout(cfg_.timeout);
+                if (cfg_.repeat > 0) {
+                    ts_->repeat(static_cast<std::size_t>(cfg_.repeat), cfg_.until_fail);
+                }
+            });
+            if (!cfg_.cache_file.empty() && !cfg_.shuffle.enabled) {
+                std::for_each(suites.begin(), suites.end(),
+                              [&](test::testsuite_ptr& ts_) { ts_->schedule(cache.schedule(*ts_)); });
+            }
+            auto const time_fn{[&](test::testsuite const& ts_) { return cache.time(ts_); }};
+            test::suite_graph graph(suites, time_fn);
+            if (!graph.empty()) {
+                // Testsuites are reported in the order, in which they run sequentially.
+                std::vector<test::testsuite_ptr> sorted;
+                std::for_each(graph.order().cbegin(), graph.order().cend(),
+                              [&](std::size_t i_) { sorted.push_back(suites[i_]); });
+                suites.swap(sorted);
+                graph = test::suite_graph(suites, time_fn);
+            }
+            auto exec{cfg_.executor()};
+            auto rep{cfg_.reporter()};
+            // Captures as long as the reporter thread runs, as installing the proxies would race with its output.
+            test::output_capture cap;
+            rep->begin_report();
+            {
+                report::pipeline pipe(rep, suites);
+                if (cfg_.jobs > 0 || !m_remote.empty() || !cfg_.listen.empty()) {
+                    run_distributed(suites, origins, graph,
+                                    cfg_.shuffle.enabled ? in_order(suites.size()) : cache.schedule(suites), cfg_,
+                                    cancel, res, pipe);
+                } else if (cfg_.parallel_suites && !graph.empty()) {
+                    run_graph(suites, graph, *exec, pipe);
+                } else if (cfg_.parallel_suites) {
+                    run_parallel(suites, cfg_.shuffle.enabled ? in_order(suites.size()) : cache.schedule(suites), *exec,
+                                 pipe);
+                } else {
+                    run_sequential(suites, graph, *exec, pipe);
+                }
+                pipe.finish();
+            }
             rep->end_report();
+            if (!cfg_.cache_file.empty()) {
+                std::for_each(suites.cbegin(), suites.cend(),
+                              [&](test::testsuite_ptr const& ts_) { cache.update(*ts_); });
+                cache.save(cfg_.cache_file);
+            }
+            if (!cfg_.save_baseline.empty()) {
+                test::baseline b;
+                b.load(cfg_.save_baseline);
+                std::for_each(suites.cbegin(), suites.cend(), [&](test::testsuite_ptr const& ts_) {
+                    std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(),
+                                  [&](test::testcase const& tc_) { b.update(tc_); });
+                });
+                b.save(cfg_.save_baseline);
+            }
             return static_cast<int>(std::min(rep->faults(), static_cast<std::size_t>(std::numeric_limits<int>::max())));
         } catch (std::exception const& e) {
             return err_exit(e.what());
@@ -95,7 +253,7 @@ public:
 
     static auto
     instance() -> runner& {
-        static runner r;
+        static runner r(test::registry::instance());
         return r;
     }
 
@@ -105,13 +263,279 @@ private:
         return static_cast<int>(v_);
     }
 
+    static auto
+    in_order(std::size_t n_) -> std::vector<std::size_t> {
+        std::vector<std::size_t> order(n_);
+        std::iota(order.begin(), order.end(), 0);
+        return order;
+    }
+
+    static void
+    remove_empty(std::vector<test::selection>& sel_) {
+        sel_.erase(std::remove_if(sel_.begin(), sel_.end(), [](test::selection const& s_) { return !s_.any(); }),
+                   sel_.end());
+    }
+
+    /// Write the manifest of all given testsuites to the report destination.
+    static void
+    list(std::vector<test::testsuite_ptr> const& suites_, test::run_cache const& cache_, config const& cfg_) {
+        std::ofstream file;
+        if (!cfg_.report_cfg.outfile.empty()) {
+            file.open(cfg_.report_cfg.outfile);
+            if (!file) {
+                throw std::runtime_error("could not open file for listing");
+            }
+        }
+        auto* const          stream{cfg_.report_cfg.ostream ? cfg_.report_cfg.ostream : &std::cout};
+        std::ostream&        out(file.is_open() ? file : *stream);
+        test::manifest const m(suites_, cache_);
+        if (cfg_.list_fmt == config::list_format::JSON) {
+            m.json(out);
+        } else {
+            m.text(out);
+        }
+    }
+
+    static void
+    run_testsuite(test::testsuite_ptr const& ts_, exec::executor& exec_) {
+        try {
+            ts_->run(exec_);
+        } catch (std::exception const& e) {
+            throw std::runtime_error(std::string(">") + ts_->name() + "< [" + name_for_type(e) + "] " + e.what());
+        } catch (...) {
+            throw std::runtime_error(std::string(">") + ts_->name() + "< unknown error");
+        }
+    }
+
+    static inline auto
+    passed(test::testsuite const& ts_) -> bool {
+        return ts_.statistics().successes() == ts_.statistics().tests();
+    }
+
+    /**
+     * Run all given testsuites in order, until one of them fails. Testsuites are expected to follow their
+     * dependencies, and are skipped if one of them did not pass.
+     */
+    static void
+    run_sequential(std::vector<test::testsuite_ptr> const& suites_, test::suite_graph const& graph_,
+                   exec::executor& exec_, report::pipeline& pipe_) {
+        std::vector<char> ok(suites_.size(), 0);
+        for (std::size_t i{0}; i < suites_.size(); ++i) {
+            auto const& deps{graph_.dependencies(i)};
+            if (std::all_of(deps.cbegin(), deps.cend(), [&](std::size_t d_) { return ok[d_] != 0; })) {
+                try {
+                    run_testsuite(suites_[i], exec_);
+                } catch (...) {
+                    pipe_.done(i, std::current_exception());
+                    return;
+                }
+                ok[i] = passed(*suites_[i]);
+            } else {
+                suites_[i]->skip();
+            }
+            pipe_.done(i);
+        }
+    }
+
+    /// State of a concurrent run of testsuites with dependencies.
+    struct graph_run
+    {
+        std::vector<test::testsuite_ptr> const& suites;
+        test::suite_graph const&                graph;
+        exec::executor&                         exec;
+        report::pipeline&                       pipe;
+        std::mutex                              mutex;
+        std::condition_variable                 cv;
+        std::vector<std::size_t>                pending;
+        std::vector<char>                       ok;
+        std::vector<std::size_t>                ready;    ///< Heap of testsuites, that may start.
+        std::size_t                             running;  ///< Number of spawned tasks, that are not done yet.
+        std::exception_ptr                      error;
+
+        auto
+        operator()(std::size_t l_, std::size_t r_) const -> bool {
+            return graph.priority(l_) < graph.priority(r_) || (graph.priority(l_) == graph.priority(r_) && l_ > r_);
+        }
+    };
+
+    /**
+     * Run all given testsuites concurrently, each as soon as all its dependencies passed. Ready testsuites are started
+     * by the longest path of dependents behind them, so that the critical path starts first. Testsuites, whose
+     * dependencies did not pass, are skipped. Failed testsuites do not stop the others.
+     */
+    static void
+    run_graph(std::vector<test::testsuite_ptr> const& suites_, test::suite_graph const& graph_, exec::executor& exec_,
+              report::pipeline& pipe_) {
+        graph_run g{suites_, graph_, exec_, pipe_, {}, {}, std::vector<std::size_t>(suites_.size()),
+                    std::vector<char>(suites_.size(), 0), {}, 0, {}};
+        for (std::size_t i{0}; i < suites_.size(); ++i) {
+            g.pending[i] = graph_.dependencies(i).size();
+            if (g.pending[i] == 0) {
+                g.ready.push_back(i);
+            }
+        }
+        std::make_heap(g.ready.begin(), g.ready.end(), std::cref(g));
+        launch(g, g.ready.size());
+        std::unique_lock<std::mutex> lk(g.mutex);
+        g.cv.wait(lk, [&] { return g.running == 0; });
+        if (g.error) {
+            std::rethrow_exception(g.error);
+        }
+    }
+
+    /// Spawn a task for each of n_ testsuites, that got ready.
+    static void
+    launch(graph_run& g_, std::size_t n_) {
+        {
+            std::lock_guard<std::mutex> lk(g_.mutex);
+            g_.running += n_;
+        }
+        for (std::size_t i{0}; i < n_; ++i) {
+            g_.exec.spawn([&g_](std::size_t, std::size_t) { step(g_); });
+        }
+    }
+
+    /// Run the first testsuite from the ready heap, and launch its dependents, that got ready by it.
+    static void
+    step(graph_run& g_) {
+        std::size_t n{0};
+        try {
+            std::size_t idx{0};
+            {
+                std::lock_guard<std::mutex> lk(g_.mutex);
+                std::pop_heap(g_.ready.begin(), g_.ready.end(), std::cref(g_));
+                idx = g_.ready.back();
+                g_.ready.pop_back();
+            }
+            std::exception_ptr err;
+            try {
+                run_testsuite(g_.suites[idx], g_.exec);
+            } catch (...) {
+                err = std::current_exception();
+            }
+            g_.pipe.done(idx, err);
+            n = resolve(g_, idx, !err && passed(*g_.suites[idx]));
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(g_.mutex);
+            if (!g_.error) {
+                g_.error = std::current_exception();
+            }
+        }
+        launch(g_, n);
+        // The run must not be touched after the last task is done, as run_graph may return immediately.
+        std::lock_guard<std::mutex> lk(g_.mutex);
+        if (--g_.running == 0) {
+            g_.cv.notify_all();
+        }
+    }
+
+    /**
+     * Mark the testsuite at i_ as done, and push its dependents to the ready heap, once all of their dependencies are
+     * done. Dependents of a testsuite, that did not pass, are skipped. Return the number of testsuites, that got ready.
+     */
+    static auto
+    resolve(graph_run& g_, std::size_t i_, bool ok_) -> std::size_t {
+        std::lock_guard<std::mutex> lk(g_.mutex);
+        std::size_t                 n{0};
+        std::vector<std::size_t>    done{i_};
+        g_.ok[i_] = ok_;
+        while (!done.empty()) {
+            auto const d{done.back()};
+            done.pop_back();
+            std::for_each(g_.graph.dependents(d).cbegin(), g_.graph.dependents(d).cend(), [&](std::size_t t_) {
+                if (--g_.pending[t_] > 0) {
+                    return;
+                }
+                auto const& deps{g_.graph.dependencies(t_)};
+                if (std::all_of(deps.cbegin(), deps.cend(), [&](std::size_t p_) { return g_.ok[p_] != 0; })) {
+                    g_.ready.push_back(t_);
+                    std::push_heap(g_.ready.begin(), g_.ready.end(), std::cref(g_));
+                    ++n;
+                } else {
+                    g_.suites[t_]->skip();
+                    g_.pipe.done(t_);
+                    done.push_back(t_);
+                }
+            });
+        }
+        return n;
+    }
+
+    /// Run all given testsuites concurrently in the scheduled order. Failed testsuites do not stop the others.
+    static void
+    run_parallel(std::vector<test::testsuite_ptr> const& suites_, std::vector<std::size_t> const& order_,
+                 exec::executor& exec_, report::pipeline& pipe_) {
+        exec_.parallel_for(suites_.size(), [&](std::size_t i_, std::size_t) {
+            auto const         idx{order_[i_]};
+            std::exception_ptr err;
+            try {
+                run_testsuite(suites_[idx], exec_);
+            } catch (...) {
+                err = std::current_exception();
+            }
+            pipe_.done(idx, err);
+        });
+    }
+
+    /// Where a testsuite is run, as the number of a binary, where 0 is this one, and its index there.
+    struct origin
+    {
+        std::size_t binary;
+        std::size_t id;
+    };
+
+    /**
+     * Run all given testsuites in worker processes, that are spawned from this executable, or the binary they were
+     * added from, and in workers, that connect over TCP. Testsuites with dependencies are started by the longest path
+     * of dependents behind them, all others in the given order. At most cfg_.jobs workers are spawned at once, or as
+     * many as threads by default, unless workers connect over TCP.
+     */
+    void
+    run_distributed(std::vector<test::testsuite_ptr> const& suites_,
+                    std::map<test::testsuite const*, origin> const& origins_, test::suite_graph const& graph_,
+                    std::vector<std::size_t> order_, config const& cfg_, test::cancellation_ptr const& cancel_,
+                    test::resources_ptr const& res_, report::pipeline& pipe_) {
+        if (!graph_.empty()) {
+            order_ = in_order(suites_.size());
+            std::stable_sort(order_.begin(), order_.end(),
+                             [&](std::size_t l_, std::size_t r_) { return graph_.priority(l_) > graph_.priority(r_); });
+        }
+        std::vector<std::size_t> ids;
+        std::vector<std::size_t> groups;
+        std::for_each(suites_.cbegin(), suites_.cend(), [&](test::testsuite_ptr const& ts_) {
+            ids.push_back(origins_.at(ts_.get()).id);
+            groups.push_back(origins_.at(ts_.get()).binary);
+        });
+        test::distributor dist(suites_, ids, graph_, order_,
+                               [&](std::size_t i_, std::exception_ptr const& e_) { pipe_.done(i_, e_); });
+        dist.group_by(groups);
+        dist.cancel_by(cancel_);
+        dist.limit_by(res_);
+        dist.configure(test::message("CONFIG") << cfg_.timeout << cfg_.repeat << cfg_.until_fail << cfg_.isolated);
+        if (!cfg_.listen.empty()) {
+            dist.accept_from(std::make_shared<test::listener>(cfg_.listen));
+        }
+        auto const exe{test::connection::self(cfg_.program)};
+        auto const local{cfg_.jobs > 0 ? cfg_.jobs : (cfg_.listen.empty() || !m_remote.empty() ? cfg_.thd_count : 0)};
+        dist.spawn_by(
+            [&](std::size_t g_) {
+                return g_ == 0 ? test::connection::spawn(exe, {"--worker", "fd:{fd}"}) : m_spawn(g_ - 1);
+            },
+            static_cast<std::size_t>(std::max(local, 0)));
+        dist.run();
+    }
+
     static inline auto
     err_exit(char const* msg_) -> int {
         std::cerr << "A fatal error occurred!\n  what(): " << msg_ << std::endl;
         return to_int(retval::EXCEPT);
     }
 
-    std::vector<test::testsuite_ptr> m_testsuites;
+    std::vector<test::testsuite_ptr>         m_testsuites;
+    std::vector<test::testsuite_ptr>         m_remote;
+    std::map<test::testsuite const*, origin> m_origins;
+    test::distributor::spawn_function        m_spawn;
+    test::registry const*                    m_registry{nullptr};
 };
 }  // namespace intern
 
@@ -0,0 +1,201 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_ATTRIBUTES_HPP
+#define TPP_TEST_ATTRIBUTES_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/// How a testcase may run concurrently to other testcases of its testsuite.
+enum class concurrency
+{
+    DEFAULT,    ///< As defined by the testsuite.
+    SERIAL,     ///< Not concurrently to other serial testcases of a parallel testsuite.
+    EXCLUSIVE,  ///< Not concurrently to any other testcase of a parallel testsuite.
+    PARALLEL    ///< Concurrently to adjacent parallel testcases of a sequential testsuite.
+};
+
+/// A named resource, that a testcase holds while it runs, and how many testcases may hold it at the same time.
+struct resource
+{
+    char const* name;
+    std::size_t limit;
+};
+
+/// Name of the resource, that every benchmark holds. Names starting with "tpp:" are reserved for internal use.
+static constexpr char const* BENCHMARK_RESOURCE = "tpp:benchmark";
+
+/// Optional properties of a testcase.
+struct test_attributes
+{
+    double                   timeout{.0};                 ///< Maximum time in milliseconds, or 0 if unlimited.
+    std::vector<char const*> tags;                        ///< Names to select the testcase by, see filter.
+    concurrency              mode{concurrency::DEFAULT};  ///< How the testcase may run concurrently to others.
+    std::vector<resource>    resources;                   ///< Resources to hold while the testcase runs.
+    bool                     benchmark{false};            ///< Whether the testcase is measured, see benchmark.
+    bool                     isolated{false};             ///< Whether the testcase runs in a child process.
+};
+
+using test_attribute = std::function<void(test_attributes&)>;
+
+/// Name and attributes of a testcase, as given to TEST.
+struct test_spec
+{
+    template<typename... Attrs>
+    explicit test_spec(char const* name_, Attrs&&... attrs_) : name(name_) {
+        int const applied[]{0, (attrs_(attrs), 0)...};
+        static_cast<void>(applied);
+    }
+
+    char const*     name;
+    test_attributes attrs;
+};
+
+/// Optional properties of a testsuite.
+struct suite_attributes
+{
+    std::vector<char const*> depends;  ///< Names of testsuites, that must pass before this one runs.
+};
+
+using suite_attribute = std::function<void(suite_attributes&)>;
+
+/// Name and attributes of a testsuite, as given to SUITE.
+struct suite_spec
+{
+    template<typename... Attrs>
+    explicit suite_spec(char const* name_, Attrs&&... attrs_) : name(name_) {
+        int const applied[]{0, (attrs_(attrs), 0)...};
+        static_cast<void>(applied);
+    }
+
+    char const*      name;
+    suite_attributes attrs;
+};
+
+/**
+ * Let a testsuite run only after all testsuites with the given names passed. If one of them did not pass, all
+ * testcases of the testsuite are skipped.
+ *
+ * EXAMPLE:
+ * @code
+ * SUITE("queries", depends_on("schema migration")) {
+ *   // testcases
+ * };
+ * @endcode
+ */
+template<typename... Names>
+auto
+depends_on(Names... names_) -> suite_attribute {
+    std::vector<char const*> const d{names_...};
+    return [d](suite_attributes& a_) { a_.depends.insert(a_.depends.end(), d.cbegin(), d.cend()); };
+}
+
+/**
+ * Functions to create attributes for testcases. They are available in every testsuite.
+ *
+ * EXAMPLE:
+ * @code
+ * TEST("some test", timeout(100)) {
+ *   // assertions
+ * }
+ * @endcode
+ */
+struct attribute_factory
+{
+    /**
+     * Let the testcase end with an error, if it takes longer than ms_ milliseconds. It is isolated, so that it can be
+     * killed with its stack reported, when it is not done in time.
+     */
+    static auto
+    timeout(double ms_) -> test_attribute {
+        return [ms_](test_attributes& a_) {
+            a_.timeout  = ms_;
+            a_.isolated = true;
+        };
+    }
+
+    /**
+     * Run the testcase, including the hooks around it, in a child process, as done for all testcases by --isolate. This
+     * is ignored on systems without process isolation.
+     */
+    static auto
+    isolated() -> test_attribute {
+        return [](test_attributes& a_) { a_.isolated = true; };
+    }
+
+    /// Tag the testcase with all given names.
+    template<typename... Tags>
+    static auto
+    tags(Tags... tags_) -> test_attribute {
+        std::vector<char const*> const t{tags_...};
+        return [t](test_attributes& a_) { a_.tags.insert(a_.tags.end(), t.cbegin(), t.cend()); };
+    }
+
+    /// Run the testcase one after another with all other serial testcases of a parallel testsuite.
+    static auto
+    serial() -> test_attribute {
+        return [](test_attributes& a_) { a_.mode = concurrency::SERIAL; };
+    }
+
+    /// Run the testcase after all others of a parallel testsuite, while no other testcase of it is running.
+    static auto
+    exclusive() -> test_attribute {
+        return [](test_attributes& a_) { a_.mode = concurrency::EXCLUSIVE; };
+    }
+
+    /**
+     * Hold the resource name_ while the testcase runs, which at most limit_ testcases of the whole run may hold at once.
+     * All testcases, that hold it, must declare the same limit. Names starting with "tpp:" are reserved.
+     */
+    static auto
+    resource(char const* name_, std::size_t limit_) -> test_attribute {
+        return [name_, limit_](test_attributes& a_) {
+            a_.resources.push_back(test::resource{name_, limit_ > 0 ? limit_ : 1});
+        };
+    }
+
+    /// Run the testcase concurrently with the adjacent parallel safe testcases of a sequential testsuite.
+    static auto
+    parallel_safe() -> test_attribute {
+        return [](test_attributes& a_) { a_.mode = concurrency::PARALLEL; };
+    }
+
+    /// Measure the testcase as benchmark. It runs exclusively, while no other testcase of the whole run does.
+    static auto
+    benchmark() -> test_attribute {
+        return [](test_attributes& a_) {
+            a_.benchmark = true;
+            if (a_.mode == concurrency::DEFAULT) {
+                a_.mode = concurrency::EXCLUSIVE;
+            }
+            a_.resources.push_back(test::resource{BENCHMARK_RESOURCE, 1});
+        };
+    }
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_ATTRIBUTES_HPP
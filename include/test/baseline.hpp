@@ -0,0 +1,198 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_BASELINE_HPP
+#define TPP_TEST_BASELINE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test/testcase.hpp"
+
+#include "stringify.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Samples of benchmarks from a previous run, that is persisted in a file, to detect regressions against it.
+ * Every line holds the samples of a benchmark in nanoseconds per iteration, with tab separated fields.
+ *   B <testsuite> <testcase> {<sample>}...
+ * Names are stored escaped, so that they do not contain any tab, or newline.
+ */
+class baseline
+{
+public:
+    /// Load all records from a file. A missing file is treated as empty baseline.
+    void
+    load(std::string const& fname_) {
+        std::ifstream in(fname_);
+        std::string   line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string        kind;
+            std::string        ts;
+            std::string        tc;
+            if (!std::getline(fields, kind, '\t') || kind != "B" || !std::getline(fields, ts, '\t') ||
+                !std::getline(fields, tc, '\t')) {
+                continue;
+            }
+            std::vector<double> samples;
+            double              s{.0};
+            while (fields >> s) {
+                samples.push_back(s);
+            }
+            if (!samples.empty()) {
+                m_samples[key(ts, tc)] = std::move(samples);
+            }
+        }
+    }
+
+    void
+    save(std::string const& fname_) const {
+        std::ofstream out(fname_, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("could not open file for baseline");
+        }
+        out << std::setprecision(std::numeric_limits<double>::max_digits10);
+        for (auto const& b : m_samples) {
+            out << "B\t" << b.first;
+            std::for_each(b.second.cbegin(), b.second.cend(), [&](double s_) { out << '\t' << s_; });
+            out << '\n';
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("could not write baseline");
+        }
+    }
+
+    /**
+     * Record the samples of a benchmark, if it was measured and passed. Benchmarks, that failed, e.g. as they regressed
+     * against this baseline, keep their previous samples, so that a regression does not become the new baseline.
+     */
+    void
+    update(testcase const& tc_) {
+        if (tc_.result() == testcase::HAS_PASSED && !tc_.measured().samples().empty()) {
+            m_samples[key(tc_)] = tc_.measured().samples();
+        }
+    }
+
+    /**
+     * Let compare() only fail benchmarks, whose median is more than max_pct_ percent slower than in the baseline, and
+     * whose samples are slower with a significance level of alpha_.
+     */
+    void
+    thresholds(double max_pct_, double alpha_) {
+        m_max_pct = max_pct_;
+        m_alpha   = alpha_;
+    }
+
+    /**
+     * Fail a passed benchmark, if it regressed against the baseline. Benchmarks without a baseline pass. As samples
+     * of benchmarks are rarely normally distributed, they are compared by a Mann-Whitney U test.
+     */
+    void
+    compare(testcase& tc_) const {
+        auto const& now{tc_.measured().samples()};
+        auto const  it{m_samples.find(key(tc_))};
+        if (tc_.result() != testcase::HAS_PASSED || now.empty() || it == m_samples.cend()) {
+            return;
+        }
+        measurement before;
+        std::for_each(it->second.cbegin(), it->second.cend(), [&](double s_) { before.add(s_); });
+        auto const slowdown{before.median() > .0 ? (tc_.measured().median() / before.median() - 1.0) * 100.0 : .0};
+        auto const p{p_slower(it->second, now)};
+        if (slowdown > m_max_pct && p < m_alpha) {
+            std::ostringstream msg;
+            msg << "regressed by " << slowdown << "% against the baseline median of " << before.median()
+                << "ns (p = " << p << ")";
+            tc_.result(testcase::HAS_FAILED, tc_.elapsed_time(), msg.str());
+        }
+    }
+
+    /**
+     * Get the one-sided p-value of the Mann-Whitney U test, that samples in after_ tend to be greater than in
+     * before_. It is approximated by the normal distribution with correction for ties and continuity, which is precise
+     * enough for the sample sizes of benchmarks.
+     */
+    static auto
+    p_slower(std::vector<double> const& before_, std::vector<double> const& after_) -> double {
+        std::vector<std::pair<double, bool>> all;
+        std::for_each(before_.cbegin(), before_.cend(), [&](double s_) { all.emplace_back(s_, false); });
+        std::for_each(after_.cbegin(), after_.cend(), [&](double s_) { all.emplace_back(s_, true); });
+        std::sort(all.begin(), all.end());
+        auto const n{static_cast<double>(all.size())};
+        double     ranks{.0};  // Sum of the ranks of after_.
+        double     ties{.0};   // Sum of t^3 - t over all groups of t equal samples.
+        for (std::size_t i{0}; i < all.size();) {
+            auto j{i};
+            while (j < all.size() && all[j].first == all[i].first) {
+                ++j;
+            }
+            auto const t{static_cast<double>(j - i)};
+            auto const rank{(static_cast<double>(i + j) + 1.0) / 2.0};
+            std::for_each(all.cbegin() + static_cast<std::ptrdiff_t>(i), all.cbegin() + static_cast<std::ptrdiff_t>(j),
+                          [&](std::pair<double, bool> const& s_) { ranks += s_.second ? rank : .0; });
+            ties += t * t * t - t;
+            i = j;
+        }
+        auto const n1{static_cast<double>(before_.size())};
+        auto const n2{static_cast<double>(after_.size())};
+        auto const u{ranks - n2 * (n2 + 1.0) / 2.0};
+        auto const var{n1 * n2 / 12.0 * ((n + 1.0) - (n > 1.0 ? ties / (n * (n - 1.0)) : .0))};
+        if (n1 == .0 || n2 == .0 || var <= .0) {
+            return 1.0;
+        }
+        auto const z{(u - n1 * n2 / 2.0 - 0.5) / std::sqrt(var)};
+        return 0.5 * std::erfc(z / std::sqrt(2.0));
+    }
+
+private:
+    static auto
+    key(std::string const& ts_, std::string const& tc_) -> std::string {
+        return ts_ + '\t' + tc_;
+    }
+
+    static auto
+    key(testcase const& tc_) -> std::string {
+        return key(escaped_string(tc_.suite_name()), escaped_string(tc_.name()));
+    }
+
+    std::map<std::string, std::vector<double>> m_samples;  ///< Keyed by testsuite and testcase name.
+    double                                     m_max_pct{5.0};
+    double                                     m_alpha{0.01};
+};
+
+using baseline_ptr = std::shared_ptr<baseline const>;
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_BASELINE_HPP
@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_BENCHMARK_HPP
+#define TPP_TEST_BENCHMARK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "test/statistic.hpp"
+
+#include "cpp_meta.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Measures, how long a function takes, by running it repeatedly. Every sample is taken over as many iterations, that
+ * it takes at least a target time, so that the resolution of the clock does not matter. The number of iterations is
+ * calibrated during a warm-up, which also brings caches and branch predictors into a steady state.
+ */
+class benchmark
+{
+public:
+    static constexpr std::size_t SAMPLES{20};        ///< Number of samples to take.
+    static constexpr double      SAMPLE_TIME{5.0};   ///< Minimum time of a sample in milliseconds.
+    static constexpr double      WARMUP_TIME{10.0};  ///< Minimum time to run before taking samples in milliseconds.
+
+    /// Take samples_ samples of fn_, that take at least sample_ms_ milliseconds each.
+    template<typename Fn>
+    static auto
+    measure(Fn&& fn_, std::size_t samples_ = SAMPLES, double sample_ms_ = SAMPLE_TIME) -> measurement {
+        std::size_t n{1};
+        double      warm{.0};
+        for (;;) {
+            auto const t{run(fn_, n)};
+            warm += t;
+            if (t >= sample_ms_ * 1e6 && warm >= WARMUP_TIME * 1e6) {
+                break;
+            }
+            if (t < sample_ms_ * 1e6) {
+                // Grows by the estimated factor, but not too much at once, if the first iterations were fast by chance.
+                auto const factor{t > .0 ? sample_ms_ * 1e6 / t * 1.2 : 10.0};
+                n = std::max(n + 1, static_cast<std::size_t>(static_cast<double>(n) * std::min(factor, 10.0)));
+            }
+        }
+        measurement m;
+        m.iterations(n);
+        for (std::size_t i{0}; i < samples_; ++i) {
+            m.add(run(fn_, n) / static_cast<double>(n));
+        }
+        return m;
+    }
+
+private:
+    /// Run fn_ n_ times, and get the time it took in nanoseconds.
+    template<typename Fn>
+    static auto
+    run(Fn& fn_, std::size_t n_) -> double {
+        auto const start{std::chrono::steady_clock::now()};
+        for (std::size_t i{0}; i < n_; ++i) {
+            fn_();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/**
+ * Prevent the compiler from optimizing away the computation of v_, as if its value was used.
+ *
+ * EXAMPLE:
+ * @code
+ * BENCHMARK("sum") {
+ *   do_not_optimize(std::accumulate(v.begin(), v.end(), 0));
+ * }
+ * @endcode
+ */
+template<typename T>
+inline void
+do_not_optimize(T const& v_) {
+#ifdef TPP_INTERN_SYS_UNIX
+    __asm__ __volatile__("" : : "r,m"(v_) : "memory");
+#else
+    static_cast<void>(*reinterpret_cast<char const volatile*>(&v_));
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+#endif
+}
+
+/// Prevent the compiler from optimizing away writes to memory, as if all memory was read.
+inline void
+clobber_memory() {
+#ifdef TPP_INTERN_SYS_UNIX
+    __asm__ __volatile__("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+#endif
+}
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_BENCHMARK_HPP
@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_CANCELLATION_HPP
+#define TPP_TEST_CANCELLATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+class cancellation;
+using cancellation_ptr = std::shared_ptr<cancellation>;
+
+/**
+ * Cooperative cancellation of a test run. Once cancelled, no further testcases are started, and running testcases may
+ * poll requested() to return early.
+ */
+class cancellation
+{
+public:
+    /// Cancel after max_faults_ failed, or erroneous testcases, or never if it is 0.
+    explicit cancellation(std::size_t max_faults_ = 0) : m_max_faults(max_faults_) {}
+
+    inline void
+    cancel() {
+        m_cancelled = true;
+    }
+
+    inline auto
+    cancelled() const -> bool {
+        return m_cancelled.load(std::memory_order_relaxed);
+    }
+
+    /// Count a failed, or erroneous testcase.
+    void
+    fault() {
+        if (++m_faults == m_max_faults) {
+            cancel();
+        }
+    }
+
+    /// Check whether the run of the current testcase is cancelled.
+    static auto
+    requested() -> bool {
+        auto const* c{current()};
+        return c != nullptr && c->cancelled();
+    }
+
+    /// Makes a cancellation the current one of this thread, as long as the scope exists.
+    class scope final
+    {
+    public:
+        explicit scope(cancellation const* c_) : m_prev(current()) {
+            current() = c_;
+        }
+
+        scope(scope const&)     = delete;
+        scope(scope&&) noexcept = delete;
+        ~scope() noexcept {
+            current() = m_prev;
+        }
+        auto
+        operator=(scope const&) -> scope& = delete;
+        auto
+        operator=(scope&&) noexcept -> scope& = delete;
+
+    private:
+        cancellation const* const m_prev;
+    };
+
+private:
+    static auto
+    current() -> cancellation const*& {
+        static thread_local cancellation const* c{nullptr};
+        return c;
+    }
+
+    std::size_t const        m_max_faults;
+    std::atomic<std::size_t> m_faults{0};
+    std::atomic<bool>        m_cancelled{false};
+};
+}  // namespace test
+}  // namespace intern
+
+using cancellation = intern::test::cancellation;
+}  // namespace tpp
+
+#endif  // TPP_TEST_CANCELLATION_HPP
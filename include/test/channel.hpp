@@ -0,0 +1,633 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_CHANNEL_HPP
+#define TPP_TEST_CHANNEL_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cpp_meta.hpp"
+
+#ifdef TPP_INTERN_SYS_UNIX
+#    include <fcntl.h>
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <netinet/tcp.h>
+#    include <sys/socket.h>
+#    include <sys/types.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * A message between a coordinator and its workers, that is a command followed by arguments.
+ * On the wire every message is a line of tab separated fields. Fields are escaped, so that they contain neither tab,
+ * nor newline. Numbers are sent as text, so that peers do not need to share their representation.
+ */
+class message
+{
+public:
+    message() = default;
+
+    explicit message(char const* cmd_) : m_fields{cmd_} {}
+
+    auto
+    operator<<(std::string const& str_) -> message& {
+        m_fields.push_back(str_);
+        return *this;
+    }
+
+    auto
+    operator<<(char const* str_) -> message& {
+        m_fields.emplace_back(str_);
+        return *this;
+    }
+
+    template<typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    auto
+    operator<<(T v_) -> message& {
+        std::ostringstream oss;
+        oss << std::setprecision(std::numeric_limits<double>::max_digits10) << v_;
+        m_fields.push_back(oss.str());
+        return *this;
+    }
+
+    inline auto
+    command() const -> std::string const& {
+        static std::string const none;
+        return m_fields.empty() ? none : m_fields.front();
+    }
+
+    /// Get the number of arguments.
+    inline auto
+    size() const -> std::size_t {
+        return m_fields.empty() ? 0 : m_fields.size() - 1;
+    }
+
+    /// Get the argument at i_, counting from 0 after the command.
+    auto
+    str(std::size_t i_) const -> std::string const& {
+        if (i_ + 1 >= m_fields.size()) {
+            throw std::runtime_error("malformed message " + command());
+        }
+        return m_fields[i_ + 1];
+    }
+
+    /// Get the argument at i_ as number. Integers are parsed exactly, and must fit into T.
+    template<typename T>
+    auto
+    num(std::size_t i_) const -> T {
+        auto const& s{str(i_)};
+        char*       end{nullptr};
+        T           v{};
+        errno = 0;
+        bool const fits{parse(s.c_str(), &end, v)};
+        if (s.empty() || *end != '\0' || errno == ERANGE || !fits) {
+            throw std::runtime_error("malformed message " + command());
+        }
+        return v;
+    }
+
+    auto
+    encode() const -> std::string {
+        std::string line;
+        for (std::size_t i{0}; i < m_fields.size(); ++i) {
+            if (i > 0) {
+                line.push_back('\t');
+            }
+            std::for_each(m_fields[i].cbegin(), m_fields[i].cend(), [&](char c_) {
+                switch (c_) {
+                    case '\\': line.append("\\\\"); break;
+                    case '\t': line.append("\\t"); break;
+                    case '\n': line.append("\\n"); break;
+                    case '\r': line.append("\\r"); break;
+                    default: line.push_back(c_); break;
+                }
+            });
+        }
+        line.push_back('\n');
+        return line;
+    }
+
+    /// Decode a line without its newline.
+    static auto
+    decode(std::string const& line_) -> message {
+        message m;
+        m.m_fields.emplace_back();
+        for (std::size_t i{0}; i < line_.size(); ++i) {
+            char const c{line_[i]};
+            if (c == '\t') {
+                m.m_fields.emplace_back();
+            } else if (c == '\\' && i + 1 < line_.size()) {
+                char const e{line_[++i]};
+                m.m_fields.back().push_back(e == 't' ? '\t' : e == 'n' ? '\n' : e == 'r' ? '\r' : e);
+            } else {
+                m.m_fields.back().push_back(c);
+            }
+        }
+        return m;
+    }
+
+private:
+    template<typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type* = nullptr>
+    static auto
+    parse(char const* str_, char** end_, T& v_) -> bool {
+        long long const v{std::strtoll(str_, end_, 10)};
+        v_ = static_cast<T>(v);
+        return v >= static_cast<long long>(std::numeric_limits<T>::min()) &&
+               v <= static_cast<long long>(std::numeric_limits<T>::max());
+    }
+
+    /// Negative numbers are rejected, as strtoull would wrap them around.
+    template<typename T,
+             typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type* = nullptr>
+    static auto
+    parse(char const* str_, char** end_, T& v_) -> bool {
+        unsigned long long const v{std::strtoull(str_, end_, 10)};
+        v_ = static_cast<T>(v);
+        return *str_ != '-' && v <= static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    }
+
+    template<typename T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
+    static auto
+    parse(char const* str_, char** end_, T& v_) -> bool {
+        v_ = static_cast<T>(std::strtod(str_, end_));
+        return true;
+    }
+
+    std::vector<std::string> m_fields;
+};
+
+/**
+ * Exchanges messages with a peer over a socket, that is owned by the channel. Receiving is buffered, so that several
+ * channels can be polled for messages at once.
+ */
+class channel
+{
+public:
+    explicit channel(int fd_) : m_fd(fd_) {}
+
+    channel(channel const&)     = delete;
+    channel(channel&&) noexcept = delete;
+    ~channel() noexcept {
+        close();
+    }
+    auto
+    operator=(channel const&) -> channel& = delete;
+    auto
+    operator=(channel&&) noexcept -> channel& = delete;
+
+    /// Send a message. A lost peer does not raise SIGPIPE, but an exception.
+    void
+    send(message const& msg_) {
+#ifdef TPP_INTERN_SYS_UNIX
+#    ifdef MSG_NOSIGNAL
+        int const flags{MSG_NOSIGNAL};
+#    else
+        int const flags{0};
+#    endif
+        auto const data{msg_.encode()};
+        for (std::size_t n{0}; n < data.size();) {
+            auto const w{::send(m_fd, data.data() + n, data.size() - n, flags)};
+            if (w < 0 && errno != EINTR) {
+                throw std::runtime_error("connection to peer was lost");
+            }
+            n += w > 0 ? static_cast<std::size_t>(w) : 0;
+        }
+#else
+        static_cast<void>(msg_);
+        throw std::runtime_error("channels are not supported on this system");
+#endif
+    }
+
+    /// Read what is available, after the socket was polled readable. Return false, once the peer is gone.
+    auto
+    fill() -> bool {
+#ifdef TPP_INTERN_SYS_UNIX
+        char buf[4096];
+        for (;;) {
+            auto const r{::read(m_fd, buf, sizeof(buf))};
+            if (r > 0) {
+                m_buf.append(buf, static_cast<std::size_t>(r));
+                return true;
+            }
+            if (r == 0 || errno != EINTR) {
+                return false;
+            }
+        }
+#else
+        return false;
+#endif
+    }
+
+    /// Take the next complete message from the buffer, if there is one.
+    auto
+    next(message& msg_) -> bool {
+        auto const e{m_buf.find('\n', m_pos)};
+        if (e == std::string::npos) {
+            m_buf.erase(0, m_pos);
+            m_pos = 0;
+            return false;
+        }
+        msg_  = message::decode(m_buf.substr(m_pos, e - m_pos));
+        m_pos = e + 1;
+        return true;
+    }
+
+    /// Wait for the next message. Return false, once the peer is gone.
+    auto
+    receive(message& msg_) -> bool {
+        while (!next(msg_)) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline auto
+    fd() const -> int {
+        return m_fd;
+    }
+
+    void
+    close() {
+#ifdef TPP_INTERN_SYS_UNIX
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+#endif
+    }
+
+private:
+    int         m_fd;
+    std::string m_buf;
+    std::size_t m_pos{0};
+};
+
+/// A worker, that is connected by a channel, and its process, if it was spawned by this one.
+class connection
+{
+public:
+    explicit connection(int fd_, long pid_ = -1) : m_channel(fd_), m_pid(pid_) {}
+
+    connection(connection const&)     = delete;
+    connection(connection&&) noexcept = delete;
+    ~connection() noexcept {
+        m_channel.close();
+        wait();
+    }
+    auto
+    operator=(connection const&) -> connection& = delete;
+    auto
+    operator=(connection&&) noexcept -> connection& = delete;
+
+    inline auto
+    chan() -> channel& {
+        return m_channel;
+    }
+
+    /**
+     * Wait for the spawned process to exit, and describe how it did. The description is empty, if the worker is no
+     * child of this process.
+     */
+    auto
+    wait() -> std::string {
+#ifdef TPP_INTERN_SYS_UNIX
+        if (m_pid > 0) {
+            int status{0};
+            while (::waitpid(static_cast<pid_t>(m_pid), &status, 0) < 0 && errno == EINTR) {
+            }
+            m_pid = -1;
+            if (WIFSIGNALED(status)) {
+                m_exit = "killed by signal " + std::to_string(WTERMSIG(status)) + " (" + ::strsignal(WTERMSIG(status)) +
+                         ")";
+            } else {
+                m_exit = "exited with code " + std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+            }
+        }
+#endif
+        return m_exit;
+    }
+
+    /**
+     * Spawn the executable at exe_ with args_ as worker. The worker gets one end of a socket pair, whose descriptor
+     * replaces every "{fd}" in args_. Its standard input and output are discarded, so that nothing but messages are
+     * exchanged.
+     */
+    static auto
+    spawn(std::string const& exe_, std::vector<std::string> const& args_) -> std::unique_ptr<connection> {
+#ifdef TPP_INTERN_SYS_UNIX
+        int sv[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            throw std::runtime_error("could not create socket for worker");
+        }
+        ::fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(sv[1], F_SETFD, FD_CLOEXEC);
+        std::vector<std::string> args{exe_};
+        std::for_each(args_.cbegin(), args_.cend(), [&](std::string a_) {
+            auto const p{a_.find("{fd}")};
+            if (p != std::string::npos) {
+                a_.replace(p, 4, std::to_string(sv[1]));
+            }
+            args.push_back(std::move(a_));
+        });
+        std::vector<char*> argv;
+        std::for_each(args.begin(), args.end(), [&](std::string& a_) { argv.push_back(&a_[0]); });
+        argv.push_back(nullptr);
+        std::fflush(nullptr);
+        pid_t const pid{::fork()};
+        if (pid == 0) {
+            int const null{::open("/dev/null", O_RDWR)};
+            if (null >= 0) {
+                ::dup2(null, 0);
+                ::dup2(null, 1);
+            }
+            ::fcntl(sv[1], F_SETFD, 0);
+            ::execv(exe_.c_str(), argv.data());
+            ::_exit(127);
+        }
+        ::close(sv[1]);
+        if (pid < 0) {
+            ::close(sv[0]);
+            throw std::runtime_error("could not spawn worker process");
+        }
+        return std::unique_ptr<connection>(new connection(sv[0], static_cast<long>(pid)));
+#else
+        static_cast<void>(exe_);
+        static_cast<void>(args_);
+        throw std::runtime_error("worker processes are not supported on this system");
+#endif
+    }
+
+    /**
+     * Connect to the coordinator at addr_, which is "fd:<n>" for a descriptor inherited from it, or "<host>:<port>"
+     * for TCP. Connecting over TCP is retried for a few seconds, as the coordinator may not be listening yet.
+     */
+    static auto
+    open(std::string const& addr_) -> std::unique_ptr<connection> {
+        if (addr_.compare(0, 3, "fd:") == 0) {
+            char*      end{nullptr};
+            long const fd{std::strtol(addr_.c_str() + 3, &end, 10)};
+            if (addr_.size() > 3 && *end == '\0' && fd >= 0) {
+                return std::unique_ptr<connection>(new connection(static_cast<int>(fd)));
+            }
+            throw std::runtime_error(addr_ + " is not a valid worker address!");
+        }
+#ifdef TPP_INTERN_SYS_UNIX
+        std::string host;
+        std::string port;
+        if (!split_address(addr_, host, port) || host.empty()) {
+            throw std::runtime_error(addr_ + " is not a valid worker address!");
+        }
+        addrinfo hints{};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        for (int attempt{0}; attempt < 100; ++attempt) {
+            addrinfo* res{nullptr};
+            if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+                throw std::runtime_error("cannot resolve " + addr_);
+            }
+            int fd{-1};
+            for (auto const* ai{res}; ai && fd < 0; ai = ai->ai_next) {
+                fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            ::freeaddrinfo(res);
+            if (fd >= 0) {
+                return std::unique_ptr<connection>(new connection(tcp(fd)));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        throw std::runtime_error("cannot connect to " + addr_);
+#else
+        throw std::runtime_error("workers are not supported on this system");
+#endif
+    }
+
+    /// Split addr_ of the form [<host>:]<port> at the last colon. Hosts may be IPv6 addresses in brackets.
+    static auto
+    split_address(std::string const& addr_, std::string& host_, std::string& port_) -> bool {
+        auto const colon{addr_.rfind(':')};
+        host_ = colon == std::string::npos ? "" : addr_.substr(0, colon);
+        port_ = colon == std::string::npos ? addr_ : addr_.substr(colon + 1);
+        if (host_.size() > 1 && host_.front() == '[' && host_.back() == ']') {
+            host_ = host_.substr(1, host_.size() - 2);
+        }
+        return !port_.empty() &&
+               std::all_of(port_.cbegin(), port_.cend(), [](char c_) { return c_ >= '0' && c_ <= '9'; });
+    }
+
+    /// Seconds, that a TCP connection may be silent, before its peer is probed.
+    static constexpr int KEEPALIVE_IDLE = 10;
+    /// Seconds between probes, of which KEEPALIVE_PROBES may be unanswered, before the peer is considered lost.
+    static constexpr int KEEPALIVE_INTERVAL = 5;
+    static constexpr int KEEPALIVE_PROBES   = 3;
+
+    /**
+     * Prepare a connected TCP socket for messages, which are sent without delay, and not inherited by children. A peer,
+     * that does not answer keepalive probes, or acknowledge sent data, is lost after about half a minute, so that
+     * waiting for a crashed host, or over a broken network, does not block forever.
+     */
+    static auto
+    tcp(int fd_) -> int {
+#ifdef TPP_INTERN_SYS_UNIX
+        int const on{1};
+        int const idle{KEEPALIVE_IDLE};
+        int const interval{KEEPALIVE_INTERVAL};
+        int const probes{KEEPALIVE_PROBES};
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        ::setsockopt(fd_, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+#    if defined(TCP_KEEPIDLE)
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+#    elif defined(TCP_KEEPALIVE)
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle));
+#    endif
+#    ifdef TCP_KEEPINTVL
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+#    endif
+#    ifdef TCP_KEEPCNT
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
+#    endif
+#    ifdef TCP_USER_TIMEOUT
+        unsigned const unacked{static_cast<unsigned>(idle + interval * probes) * 1000U};
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_USER_TIMEOUT, &unacked, sizeof(unacked));
+#    endif
+        static_cast<void>(idle);
+        static_cast<void>(interval);
+        static_cast<void>(probes);
+        ::fcntl(fd_, F_SETFD, FD_CLOEXEC);
+#endif
+        return fd_;
+    }
+
+    /// Get the path of the running executable, or fallback_ if it cannot be determined.
+    static auto
+    self(std::string const& fallback_) -> std::string {
+#ifdef TPP_INTERN_SYS_UNIX
+        if (::access("/proc/self/exe", X_OK) == 0) {
+            return "/proc/self/exe";
+        }
+#endif
+        return fallback_;
+    }
+
+private:
+    channel     m_channel;
+    long        m_pid;
+    std::string m_exit;
+};
+
+/**
+ * A TCP socket, that workers on other hosts connect to, at an address of the form [<host>:]<port>. Without a host, it
+ * only listens at the loopback interface, so that listening at all interfaces, e.g. by "0.0.0.0:<port>", is explicit.
+ */
+class listener
+{
+public:
+    explicit listener(std::string const& addr_) {
+#ifdef TPP_INTERN_SYS_UNIX
+        std::string host;
+        std::string port;
+        if (!connection::split_address(addr_, host, port)) {
+            throw std::runtime_error(addr_ + " is not a valid address to listen at!");
+        }
+        addrinfo hints{};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags    = AI_PASSIVE;
+        addrinfo* res{nullptr};
+        if (::getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &res) != 0) {
+            throw std::runtime_error("cannot resolve " + addr_);
+        }
+        for (auto const* ai{res}; ai && m_fd < 0; ai = ai->ai_next) {
+            int const fd{::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)};
+            int const on{1};
+            if (fd >= 0 && ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == 0 &&
+                ::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0) {
+                m_fd = fd;
+            } else if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        ::freeaddrinfo(res);
+        if (m_fd < 0) {
+            throw std::runtime_error("cannot listen at " + addr_);
+        }
+        ::fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+#else
+        static_cast<void>(addr_);
+        throw std::runtime_error("workers are not supported on this system");
+#endif
+    }
+
+    listener(listener const&)     = delete;
+    listener(listener&&) noexcept = delete;
+    ~listener() noexcept {
+#ifdef TPP_INTERN_SYS_UNIX
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+#endif
+    }
+    auto
+    operator=(listener const&) -> listener& = delete;
+    auto
+    operator=(listener&&) noexcept -> listener& = delete;
+
+    inline auto
+    fd() const -> int {
+        return m_fd;
+    }
+
+    /// Get the port, that is listened at. It is chosen by the system, if 0 was given.
+    auto
+    port() const -> int {
+#ifdef TPP_INTERN_SYS_UNIX
+        sockaddr_storage addr{};
+        socklen_t        len{sizeof(addr)};
+        if (::getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+            return ntohs(addr.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6 const&>(addr).sin6_port :
+                                                      reinterpret_cast<sockaddr_in const&>(addr).sin_port);
+        }
+#endif
+        return -1;
+    }
+
+    /// Get the numeric address of the host, that is listened at.
+    auto
+    host() const -> std::string {
+#ifdef TPP_INTERN_SYS_UNIX
+        sockaddr_storage addr{};
+        socklen_t        len{sizeof(addr)};
+        char             buf[NI_MAXHOST];
+        if (::getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0 &&
+            ::getnameinfo(reinterpret_cast<sockaddr const*>(&addr), len, buf, sizeof(buf), nullptr, 0, NI_NUMERICHOST) ==
+                0) {
+            return buf;
+        }
+#endif
+        return "";
+    }
+
+    /// Accept a worker, after the socket was polled readable. Returns nullptr, if it is gone already.
+    auto
+    accept() -> std::unique_ptr<connection> {
+#ifdef TPP_INTERN_SYS_UNIX
+        int const fd{::accept(m_fd, nullptr, nullptr)};
+        if (fd >= 0) {
+            return std::unique_ptr<connection>(new connection(connection::tcp(fd)));
+        }
+#endif
+        return nullptr;
+    }
+
+private:
+    int m_fd{-1};
+};
+
+using listener_ptr = std::shared_ptr<listener>;
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_CHANNEL_HPP
@@ -0,0 +1,666 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_DISTRIBUTOR_HPP
+#define TPP_TEST_DISTRIBUTOR_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/cancellation.hpp"
+#include "test/channel.hpp"
+#include "test/resources.hpp"
+#include "test/suite_graph.hpp"
+#include "test/testsuite.hpp"
+#include "test/worker.hpp"
+
+#include "version.hpp"
+
+#ifdef TPP_INTERN_SYS_UNIX
+#    include <poll.h>
+#endif
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Distributes the testcases of testsuites over workers, and takes over their results, as described by worker.
+ * Parts of testsuites are handed out one at a time to every idle worker in the given order of testsuites, so that
+ * workers, which got short parts, take more of them. Testsuites start only after all their dependencies passed,
+ * exclusive parts only after all other parts of their testsuite, and parts, that hold resources, only within their
+ * limits. Every worker runs SETUP of a testsuite before its first part of it, and TEARDOWN once all parts of the
+ * testsuite are done.
+ * If a worker is lost, the testcase it was running had an error, and the rest of its part is handed out again.
+ * Workers belong to groups, like the binaries they were spawned from, and get only parts of testsuites of their group.
+ * Workers can be spawned on demand within a limit, so that they are shared among groups as parts of them are waiting.
+ * Workers on other hosts may also connect at any time over TCP, and take over parts of lost workers.
+ */
+class distributor
+{
+public:
+    using done_function  = std::function<void(std::size_t, std::exception_ptr const&)>;
+    using spawn_function = std::function<std::unique_ptr<connection>(std::size_t)>;
+
+    /**
+     * Prepare the distribution of suites_, which workers know by the indices in ids_. Testsuites are started in
+     * order_, as far as graph_ permits. done_ is called with the index of every testsuite, when it is done.
+     */
+    distributor(std::vector<testsuite_ptr> const& suites_, std::vector<std::size_t> const& ids_,
+                suite_graph const& graph_, std::vector<std::size_t> const& order_, done_function&& done_)
+        : m_suites(suites_),
+          m_ids(ids_),
+          m_groups(suites_.size(), 0),
+          m_graph(graph_),
+          m_done(std::move(done_)),
+          m_states(suites_.size()),
+          m_nth(suites_.size()) {
+        for (std::size_t s{0}; s < m_suites.size(); ++s) {
+            std::map<std::string, std::size_t> seen;
+            std::for_each(m_suites[s]->testcases().cbegin(), m_suites[s]->testcases().cend(),
+                          [&](testcase const& tc_) { m_nth[s].push_back(seen[tc_.name()]++); });
+        }
+        std::for_each(order_.cbegin(), order_.cend(), [&](std::size_t s_) {
+            auto const parts{m_suites[s_]->parts()};
+            std::for_each(parts.cbegin(), parts.cend(), [&](testsuite::part const& p_) {
+                m_queue.push_back(add_part(s_, p_.tests, p_.last));
+            });
+        });
+    }
+
+    /// Let the testsuite at every index be run only by workers of the group at the same index. By default it is 0.
+    void
+    group_by(std::vector<std::size_t> const& groups_) {
+        m_groups  = groups_;
+        m_ngroups = groups_.empty() ? 1 : *std::max_element(groups_.cbegin(), groups_.cend()) + 1;
+    }
+
+    /// Add a connected worker of group_. It is ready to run testcases, after it introduced itself.
+    void
+    add(std::unique_ptr<connection>&& conn_, std::size_t group_ = 0) {
+        m_peers.emplace_back(std::move(conn_), group_, m_suites.size());
+    }
+
+    /**
+     * Spawn a worker of a group by fn_ for every part of it, that is waiting for one, while less than max_ workers are
+     * connected. Spawned workers quit, as soon as no more parts of their group are waiting.
+     */
+    void
+    spawn_by(spawn_function&& fn_, std::size_t max_) {
+        m_spawn = std::move(fn_);
+        m_max   = max_;
+    }
+
+    /// Add workers of group 0, that connect to l_ while testcases are run. Then runs wait for workers, if none is left.
+    void
+    accept_from(listener_ptr const& l_) {
+        m_listener = l_;
+    }
+
+    /// Send cfg_ to every worker, before it gets any testcases.
+    void
+    configure(message const& cfg_) {
+        m_config = cfg_;
+    }
+
+    void
+    cancel_by(cancellation_ptr const& c_) {
+        m_cancel = c_;
+    }
+
+    void
+    limit_by(resources_ptr const& r_) {
+        m_resources = r_;
+    }
+
+    /// Run all testsuites, until they are done. Workers are told to quit afterwards.
+    void
+    run() {
+        m_remaining = m_suites.size();
+        for (std::size_t s{0}; s < m_suites.size(); ++s) {
+            m_states[s].deps = m_graph.empty() ? 0 : m_graph.dependencies(s).size();
+        }
+        for (std::size_t s{0}; s < m_suites.size(); ++s) {
+            if (m_states[s].deps == 0 && !m_states[s].ready && !m_states[s].done) {
+                ready(s);
+            }
+        }
+        while (m_remaining > 0) {
+            dispatch();
+            bool const retired{retire()};
+            // Dropped workers may be replaced, before waiting for any.
+            if (!reap() && !retired && m_remaining > 0) {
+                wait();
+            }
+        }
+        std::for_each(m_peers.begin(), m_peers.end(), [](peer& p_) {
+            if (p_.conn) {
+                try {
+                    p_.conn->chan().send(message("QUIT"));
+                } catch (std::runtime_error const&) {
+                }
+            }
+        });
+        m_peers.clear();
+    }
+
+private:
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    struct part_state
+    {
+        std::size_t              suite;
+        std::vector<std::size_t> tests;
+        std::vector<resource>    res;  ///< All resources held by its testcases, at the lowest limit.
+        bool                     last;
+        bool                     exclusive;  ///< Whether it contains a benchmark, and runs alone.
+    };
+
+    struct suite_state
+    {
+        std::size_t                           deps{0};     ///< Dependencies, that are not done.
+        std::size_t                           parts{0};    ///< Parts, that are not done.
+        std::size_t                           closing{0};  ///< Workers, that run TEARDOWN.
+        bool                                  ready{false};
+        bool                                  started{false};
+        bool                                  done{false};
+        bool                                  ok{false};
+        std::chrono::steady_clock::time_point start;
+        std::string                           error;
+    };
+
+    struct peer
+    {
+        peer(std::unique_ptr<connection>&& conn_, std::size_t group_, std::size_t n_)
+            : conn(std::move(conn_)), group(group_), open(n_, 0), closing(n_, 0) {}
+
+        std::unique_ptr<connection> conn;
+        std::size_t                 group;
+        bool                        ready{false};
+        bool                        spawned{false};
+        bool                        broken{false};  ///< Sending to it failed, so that it is to be dropped.
+        std::size_t                 part{NONE};
+        std::size_t                 results{0};  ///< Testcases of the part, that are done.
+        std::vector<char>           open;        ///< Testsuites, that were set up.
+        std::vector<char>           closing;     ///< Testsuites, whose TEARDOWN is awaited.
+    };
+
+    auto
+    add_part(std::size_t s_, std::vector<std::size_t> const& tests_, bool last_) -> std::size_t {
+        part_state p{s_, tests_, {}, last_, false};
+        std::for_each(tests_.cbegin(), tests_.cend(), [&](std::size_t t_) {
+            auto const& res{m_suites[s_]->testcases()[t_].attributes().resources};
+            p.exclusive = p.exclusive || m_suites[s_]->testcases()[t_].attributes().benchmark;
+            std::for_each(res.cbegin(), res.cend(), [&](resource const& r_) {
+                auto it{std::find_if(p.res.begin(), p.res.end(),
+                                     [&](resource const& h_) { return std::strcmp(h_.name, r_.name) == 0; })};
+                if (it == p.res.end()) {
+                    p.res.push_back(r_);
+                } else {
+                    it->limit = std::min(it->limit, r_.limit);
+                }
+            });
+        });
+        m_parts.push_back(std::move(p));
+        ++m_states[s_].parts;
+        return m_parts.size() - 1;
+    }
+
+    /**
+     * Hand out parts to idle workers of their group, and spawn workers for parts, that find none. Drop all parts, if
+     * the run is cancelled.
+     */
+    void
+    dispatch() {
+        if (m_cancel && m_cancel->cancelled()) {
+            std::deque<std::size_t> dropped;
+            dropped.swap(m_queue);
+            std::for_each(dropped.cbegin(), dropped.cend(), [&](std::size_t p_) { part_done(p_); });
+            return;
+        }
+        std::size_t idle{0};
+        std::size_t alive{0};
+        std::for_each(m_peers.cbegin(), m_peers.cend(), [&](peer const& w_) {
+            alive += w_.conn ? 1 : 0;
+            idle += available(w_) ? 1 : 0;
+        });
+        std::vector<std::size_t> waiting(m_ngroups, 0);
+        for (auto it{m_queue.begin()}; it != m_queue.end() && (idle > 0 || (m_spawn && alive < m_max));) {
+            auto const  p{*it};
+            auto const& part{m_parts[p]};
+            auto const& st{m_states[part.suite]};
+            if (!st.ready || (part.last && st.parts > 1)) {
+                ++it;
+                continue;
+            }
+            if (m_resources && !m_resources->try_acquire(part.res, part.exclusive)) {
+                // Later parts must not keep a benchmark from running alone.
+                if (part.exclusive) {
+                    break;
+                }
+                ++it;
+                continue;
+            }
+            auto const g{m_groups[part.suite]};
+            auto const w{std::find_if(m_peers.begin(), m_peers.end(),
+                                      [&](peer const& w_) { return w_.group == g && available(w_); })};
+            if (w == m_peers.end()) {
+                if (m_resources) {
+                    m_resources->release(part.res, part.exclusive);
+                }
+                if (m_spawn && alive < m_max && ++waiting[g] > starting(g)) {
+                    m_peers.emplace_back(m_spawn(g), g, m_suites.size());
+                    m_peers.back().spawned = true;
+                    ++alive;
+                }
+                ++it;
+                continue;
+            }
+            it = m_queue.erase(it);
+            --idle;
+            start(*w, p);
+        }
+    }
+
+    static auto
+    available(peer const& w_) -> bool {
+        return w_.conn && w_.ready && !w_.broken && w_.part == NONE;
+    }
+
+    /// Count the workers of group g_, that did not introduce themselves yet.
+    auto
+    starting(std::size_t g_) const -> std::size_t {
+        return static_cast<std::size_t>(std::count_if(m_peers.cbegin(), m_peers.cend(), [&](peer const& w_) {
+            return w_.conn && w_.group == g_ && !w_.ready;
+        }));
+    }
+
+    /// Let idle spawned workers quit, if no parts of their group are waiting, so that others can be spawned instead.
+    auto
+    retire() -> bool {
+        if (!m_spawn) {
+            return false;
+        }
+        bool              any{false};
+        std::vector<char> waiting;
+        for (auto& w : m_peers) {
+            if (!available(w) || !w.spawned || std::find(w.open.cbegin(), w.open.cend(), 1) != w.open.cend() ||
+                std::find(w.closing.cbegin(), w.closing.cend(), 1) != w.closing.cend()) {
+                continue;
+            }
+            if (waiting.empty()) {
+                waiting.resize(m_ngroups, 0);
+                std::for_each(m_queue.cbegin(), m_queue.cend(),
+                              [&](std::size_t p_) { waiting[m_groups[m_parts[p_].suite]] = 1; });
+            }
+            if (!waiting[w.group]) {
+                send(w, message("QUIT"));
+                w.conn.reset();
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    /// Drop workers, that were found to be gone while sending to them, and forget all dropped ones.
+    auto
+    reap() -> bool {
+        bool any{false};
+        for (auto& w : m_peers) {
+            if (w.conn && w.broken) {
+                lost(w);
+                any = true;
+            }
+        }
+        m_peers.erase(std::remove_if(m_peers.begin(), m_peers.end(), [](peer const& w_) { return !w_.conn; }),
+                      m_peers.end());
+        return any;
+    }
+
+    void
+    start(peer& w_, std::size_t p_) {
+        auto const& p{m_parts[p_]};
+        auto&       st{m_states[p.suite]};
+        auto const& ts{*m_suites[p.suite]};
+        if (!st.started) {
+            st.started = true;
+            st.start   = std::chrono::steady_clock::now();
+        }
+        message msg("RUN");
+        msg << p_ << m_ids[p.suite] << ts.name();
+        std::for_each(p.tests.cbegin(), p.tests.cend(),
+                      [&](std::size_t t_) { msg << ts.testcases()[t_].name() << m_nth[p.suite][t_]; });
+        w_.part          = p_;
+        w_.results       = 0;
+        w_.open[p.suite] = 1;
+        send(w_, msg);
+    }
+
+    /// Wait for messages from any worker, and handle them.
+    void
+    wait() {
+#ifdef TPP_INTERN_SYS_UNIX
+        if (!m_listener &&
+            std::none_of(m_peers.cbegin(), m_peers.cend(), [](peer const& p_) { return p_.conn != nullptr; })) {
+            throw std::runtime_error("no worker left to run testcases" +
+                                     (m_lost.empty() ? "" : ", the last one " + m_lost));
+        }
+        std::vector<pollfd> fds;
+        std::vector<peer*>  polled;
+        for (auto& w : m_peers) {
+            if (w.conn) {
+                fds.push_back(pollfd{w.conn->chan().fd(), POLLIN, 0});
+                polled.push_back(&w);
+            }
+        }
+        if (m_listener) {
+            fds.push_back(pollfd{m_listener->fd(), POLLIN, 0});
+        }
+        if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0) {
+            if (errno == EINTR) {
+                return;
+            }
+            throw std::runtime_error("could not wait for workers");
+        }
+        for (std::size_t i{0}; i < polled.size(); ++i) {
+            if (fds[i].revents != 0) {
+                receive(*polled[i]);
+            }
+        }
+        if (m_listener && fds.back().revents != 0) {
+            auto conn{m_listener->accept()};
+            if (conn) {
+                add(std::move(conn));
+            }
+        }
+#else
+        throw std::runtime_error("workers are not supported on this system");
+#endif
+    }
+
+    void
+    receive(peer& w_) {
+        if (!w_.conn->chan().fill()) {
+            lost(w_);
+            return;
+        }
+        message msg;
+        try {
+            while (w_.conn && w_.conn->chan().next(msg)) {
+                handle(w_, msg);
+            }
+        } catch (std::runtime_error const&) {
+            if (w_.conn) {
+                lost(w_);
+            }
+        }
+    }
+
+    void
+    handle(peer& w_, message const& msg_) {
+        auto const& cmd{msg_.command()};
+        if (cmd == "HELLO") {
+            if (msg_.str(0) != TPP_VERSION) {
+                throw std::runtime_error("worker of version " + msg_.str(0));
+            }
+            w_.ready = true;
+            if (!m_config.command().empty()) {
+                send(w_, m_config);
+            }
+        } else if (cmd == "RESULT") {
+            auto const& p{current(w_, msg_)};
+            auto const  n{msg_.num<std::size_t>(1)};
+            if (n != w_.results || n >= p.tests.size()) {
+                throw std::runtime_error("unexpected result");
+            }
+            m_suites[p.suite]->complete(p.tests[n], [&](testcase& tc_) { worker::apply(msg_, tc_); });
+            ++w_.results;
+        } else if (cmd == "DONE" || cmd == "ERROR") {
+            auto const p{w_.part};
+            current(w_, msg_);
+            w_.part = NONE;
+            if (cmd == "ERROR") {
+                fail(m_parts[p].suite, msg_.str(1));
+            }
+            finish_part(p);
+        } else if (cmd == "CLOSED") {
+            auto const  s{msg_.num<std::size_t>(0)};
+            std::size_t idx{0};
+            while (idx < m_ids.size() && !(m_ids[idx] == s && w_.closing[idx])) {
+                ++idx;
+            }
+            if (idx == m_ids.size()) {
+                throw std::runtime_error("unexpected message");
+            }
+            w_.closing[idx] = 0;
+            if (msg_.size() > 1) {
+                fail(idx, msg_.str(1));
+            }
+            closed(idx);
+        }
+    }
+
+    auto
+    current(peer const& w_, message const& msg_) const -> part_state const& {
+        if (w_.part == NONE || msg_.num<std::size_t>(0) != w_.part) {
+            throw std::runtime_error("unexpected message");
+        }
+        return m_parts[w_.part];
+    }
+
+    /// Send a message to a worker. If it is gone, it is dropped by reap(), as others may be iterated meanwhile.
+    void
+    send(peer& w_, message const& msg_) {
+        if (w_.broken) {
+            return;
+        }
+        try {
+            w_.conn->chan().send(msg_);
+        } catch (std::runtime_error const&) {
+            w_.broken = true;
+        }
+    }
+
+    /**
+     * Drop a worker. The testcase, that it was running, had an error, and the rest of its part is handed out again.
+     * Testsuites, that it was tearing down, are treated as closed.
+     */
+    void
+    lost(peer& w_) {
+        auto conn{std::move(w_.conn)};
+        conn->chan().close();
+        auto const why{conn->wait()};
+        m_lost = why.empty() ? "was disconnected" : why;
+        if (w_.spawned && !w_.ready) {
+            throw std::runtime_error("could not start a worker, it " + m_lost);
+        }
+        if (w_.part != NONE) {
+            auto const p{w_.part};
+            w_.part = NONE;
+            // Copied, as adding a part may move the others.
+            auto const part{m_parts[p]};
+            if (w_.results < part.tests.size()) {
+                m_suites[part.suite]->complete(part.tests[w_.results], [&](testcase& tc_) {
+                    tc_.result(testcase::HAD_ERROR, .0, "worker process " + m_lost + " while running the testcase");
+                });
+                if (w_.results + 1 < part.tests.size()) {
+                    m_queue.push_front(add_part(
+                        part.suite,
+                        std::vector<std::size_t>(part.tests.cbegin() + static_cast<std::ptrdiff_t>(w_.results) + 1,
+                                                 part.tests.cend()),
+                        part.last));
+                }
+            }
+            finish_part(p);
+        }
+        for (std::size_t s{0}; s < w_.closing.size(); ++s) {
+            if (w_.closing[s]) {
+                w_.closing[s] = 0;
+                closed(s);
+            }
+        }
+    }
+
+    void
+    fail(std::size_t s_, std::string const& msg_) {
+        auto& st{m_states[s_]};
+        if (st.error.empty()) {
+            st.error = msg_;
+            // Further parts would fail the same way.
+            auto const it{std::remove_if(m_queue.begin(), m_queue.end(), [&](std::size_t p_) {
+                if (m_parts[p_].suite != s_) {
+                    return false;
+                }
+                --st.parts;
+                return true;
+            })};
+            m_queue.erase(it, m_queue.end());
+        }
+    }
+
+    void
+    finish_part(std::size_t p_) {
+        if (m_resources) {
+            m_resources->release(m_parts[p_].res, m_parts[p_].exclusive);
+        }
+        part_done(p_);
+    }
+
+    void
+    part_done(std::size_t p_) {
+        auto const s{m_parts[p_].suite};
+        if (--m_states[s].parts == 0 && m_states[s].ready) {
+            close(s);
+        }
+    }
+
+    void
+    ready(std::size_t s_) {
+        m_states[s_].ready = true;
+        if (m_states[s_].parts == 0) {
+            close(s_);
+        }
+    }
+
+    /// Let all workers, that set up a testsuite, tear it down.
+    void
+    close(std::size_t s_) {
+        auto& st{m_states[s_]};
+        for (auto& w : m_peers) {
+            if (w.conn && w.open[s_]) {
+                w.open[s_]    = 0;
+                w.closing[s_] = 1;
+                ++st.closing;
+                send(w, message("CLOSE") << m_ids[s_]);
+            }
+        }
+        if (st.closing == 0) {
+            done(s_);
+        }
+    }
+
+    void
+    closed(std::size_t s_) {
+        if (--m_states[s_].closing == 0) {
+            done(s_);
+        }
+    }
+
+    /// Mark a testsuite as done, and make its dependents ready, or skip them, if it did not pass.
+    void
+    done(std::size_t s_) {
+        auto& st{m_states[s_]};
+        if (st.done) {
+            return;
+        }
+        st.done = true;
+        --m_remaining;
+        auto& ts{*m_suites[s_]};
+        ts.finish(st.started ? std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - st.start)
+                                   .count() :
+                               .0);
+        st.ok = st.error.empty() && ts.statistics().successes() == ts.statistics().tests();
+        m_done(s_, st.error.empty() ?
+                       nullptr :
+                       std::make_exception_ptr(std::runtime_error(std::string(">") + ts.name() + "< " + st.error)));
+        if (m_graph.empty()) {
+            return;
+        }
+        std::for_each(m_graph.dependents(s_).cbegin(), m_graph.dependents(s_).cend(), [&](std::size_t t_) {
+            if (--m_states[t_].deps > 0) {
+                return;
+            }
+            auto const& deps{m_graph.dependencies(t_)};
+            if (std::all_of(deps.cbegin(), deps.cend(), [&](std::size_t d_) { return m_states[d_].ok; })) {
+                ready(t_);
+            } else {
+                skip(t_);
+            }
+        });
+    }
+
+    void
+    skip(std::size_t s_) {
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                     [&](std::size_t p_) { return m_parts[p_].suite == s_; }),
+                      m_queue.end());
+        m_suites[s_]->skip();
+        m_states[s_].parts = 0;
+        done(s_);
+    }
+
+    std::vector<testsuite_ptr> const&     m_suites;
+    std::vector<std::size_t> const&       m_ids;
+    std::vector<std::size_t>              m_groups;
+    std::size_t                           m_ngroups{1};
+    suite_graph const&                    m_graph;
+    done_function                         m_done;
+    std::vector<suite_state>              m_states;
+    std::vector<std::vector<std::size_t>> m_nth;  ///< Occurrences of the names of testcases in their testsuite.
+    std::vector<part_state>               m_parts;
+    std::deque<std::size_t>               m_queue;  ///< Parts, that were not handed out yet, in order.
+    std::deque<peer>                      m_peers;
+    std::size_t                           m_remaining{0};
+    std::string                           m_lost;  ///< How the last lost worker was lost.
+    spawn_function                        m_spawn;
+    std::size_t                           m_max{0};  ///< Workers, that may be connected at once, if spawned.
+    message                               m_config;
+    listener_ptr                          m_listener;
+    cancellation_ptr                      m_cancel;
+    resources_ptr                         m_resources;
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_DISTRIBUTOR_HPP
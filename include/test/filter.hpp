@@ -0,0 +1,343 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_FILTER_HPP
+#define TPP_TEST_FILTER_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/selection.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * A glob pattern, compiled into a sequence of tokens.
+ * Supports * for any text, ? for any character, and [...] for any character of a set, which may contain ranges like
+ * a-z, and is negated by a leading !.
+ */
+class glob
+{
+public:
+    explicit glob(std::string const& pattern_) {
+        for (std::size_t i{0}; i < pattern_.size(); ++i) {
+            switch (pattern_[i]) {
+                case '*':
+                    if (m_tokens.empty() || m_tokens.back().type != STAR) {
+                        m_tokens.push_back(token{STAR, {}, {}});
+                    }
+                    break;
+                case '?': m_tokens.push_back(token{ANY, {}, {}}); break;
+                case '[': i = parse_set(pattern_, i); break;
+                default:
+                    if (m_tokens.empty() || m_tokens.back().type != LITERAL) {
+                        m_tokens.push_back(token{LITERAL, {}, {}});
+                    }
+                    m_tokens.back().text.push_back(pattern_[i]);
+                    break;
+            }
+        }
+        if (!m_tokens.empty() && m_tokens.front().type == LITERAL) {
+            m_prefix = m_tokens.front().text;
+        }
+    }
+
+    /// Match the whole str_. A single star is backtracked at most, hence this takes linear time in most cases.
+    auto
+    match(char const* str_) const -> bool {
+        auto const  n{std::strlen(str_)};
+        std::size_t ti{0};
+        std::size_t si{0};
+        std::size_t star_ti{NONE};
+        std::size_t star_si{0};
+        while (ti < m_tokens.size() || si < n) {
+            if (ti < m_tokens.size()) {
+                auto const& tok{m_tokens[ti]};
+                if (tok.type == STAR) {
+                    star_ti = ti++;
+                    star_si = si;
+                    continue;
+                }
+                if (step(tok, str_, n, si)) {
+                    ++ti;
+                    continue;
+                }
+            }
+            if (star_ti == NONE || star_si >= n) {
+                return false;
+            }
+            ti = star_ti + 1;
+            si = ++star_si;
+        }
+        return true;
+    }
+
+    /// Get the text, that every match starts with.
+    inline auto
+    prefix() const -> std::string const& {
+        return m_prefix;
+    }
+
+private:
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    enum token_type
+    {
+        LITERAL,
+        ANY,
+        STAR,
+        SET
+    };
+
+    struct token
+    {
+        token_type       type;
+        std::string      text;
+        std::bitset<256> set;
+    };
+
+    auto
+    parse_set(std::string const& pattern_, std::size_t i_) -> std::size_t {
+        token      tok{SET, {}, {}};
+        auto       i{i_ + 1};
+        bool const negated{i < pattern_.size() && pattern_[i] == '!'};
+        if (negated) {
+            ++i;
+        }
+        for (auto first{i}; i < pattern_.size() && (pattern_[i] != ']' || i == first); ++i) {
+            auto const lo{static_cast<unsigned char>(pattern_[i])};
+            auto       hi{lo};
+            if (i + 2 < pattern_.size() && pattern_[i + 1] == '-' && pattern_[i + 2] != ']') {
+                hi = static_cast<unsigned char>(pattern_[i + 2]);
+                i += 2;
+            }
+            for (unsigned c{lo}; c <= hi; ++c) {
+                tok.set.set(c);
+            }
+        }
+        if (i >= pattern_.size()) {
+            throw std::runtime_error(pattern_ + " is not a valid pattern!");
+        }
+        if (negated) {
+            tok.set.flip();
+        }
+        m_tokens.push_back(std::move(tok));
+        return i;
+    }
+
+    static auto
+    step(token const& tok_, char const* str_, std::size_t n_, std::size_t& si_) -> bool {
+        switch (tok_.type) {
+            case LITERAL:
+                if (n_ - si_ < tok_.text.size() ||
+                    tok_.text.compare(0, tok_.text.size(), str_ + si_, tok_.text.size()) != 0) {
+                    return false;
+                }
+                si_ += tok_.text.size();
+                return true;
+            case SET:
+                if (si_ >= n_ || !tok_.set.test(static_cast<unsigned char>(str_[si_]))) {
+                    return false;
+                }
+                ++si_;
+                return true;
+            default /*ANY*/:
+                if (si_ >= n_) {
+                    return false;
+                }
+                ++si_;
+                return true;
+        }
+    }
+
+    std::vector<token> m_tokens;
+    std::string        m_prefix;
+};
+
+/**
+ * Selects testsuites and testcases by patterns.
+ * A pattern is a glob for the names of testsuites, a path suite/test with globs for the names of testsuites and their
+ * testcases, or @tag with a glob for tags of testcases. Literal prefixes of all testsuite globs are stored in a trie, so
+ * that only patterns whose prefix matches are checked against a testsuite name at all.
+ */
+class filter
+{
+public:
+    /// Compile and add pattern_, or throw if it is not valid.
+    void
+    add(std::string const& pattern_) {
+        if (pattern_.empty() || (pattern_[0] == '@' && pattern_.size() == 1)) {
+            throw std::runtime_error("empty pattern is not valid!");
+        }
+        if (pattern_[0] == '@') {
+            m_tags.emplace_back(pattern_.substr(1));
+        } else {
+            auto const sep{pattern_.find('/')};
+            if (sep == std::string::npos) {
+                m_rules.push_back(rule{glob(pattern_), glob("*"), true});
+            } else if (pattern_.find('/', sep + 1) != std::string::npos) {
+                throw std::runtime_error(pattern_ + " is not a valid pattern!");
+            } else {
+                m_rules.push_back(rule{glob(pattern_.substr(0, sep)), glob(pattern_.substr(sep + 1)), false});
+            }
+            insert(m_rules.back().suite.prefix(), m_rules.size() - 1);
+        }
+        ++m_size;
+    }
+
+    inline auto
+    size() const -> std::size_t {
+        return m_size;
+    }
+
+    inline auto
+    empty() const -> bool {
+        return m_size == 0;
+    }
+
+    /**
+     * Keep only testsuites and testcases, that match any pattern if include_ is set, or that match none otherwise.
+     * Testsuites without any selected testcases are removed, but empty ones are kept when excluding.
+     */
+    void
+    apply(std::vector<selection>& sel_, bool include_) const {
+        std::vector<rule const*> cand;
+        std::vector<selection>   kept;
+        std::for_each(sel_.begin(), sel_.end(), [&](selection& s_) {
+            if (keeps(s_, include_, cand)) {
+                kept.push_back(std::move(s_));
+            }
+        });
+        sel_.swap(kept);
+    }
+
+    /// Apply the patterns like above to testsuites, that exist already.
+    void
+    apply(std::vector<testsuite_ptr>& suites_, bool include_) const {
+        std::vector<selection> sel(suites_.cbegin(), suites_.cend());
+        apply(sel, include_);
+        suites_.clear();
+        std::for_each(sel.cbegin(), sel.cend(), [&](selection const& s_) { suites_.push_back(s_.instantiate()); });
+    }
+
+private:
+    struct rule
+    {
+        glob suite;
+        glob test;
+        bool whole_suite;
+    };
+
+    struct node
+    {
+        std::vector<std::pair<char, std::size_t>> children;
+        std::vector<std::size_t>                  rules;
+    };
+
+    void
+    insert(std::string const& prefix_, std::size_t rule_) {
+        std::size_t n{0};
+        for (char c : prefix_) {
+            auto const& ch{m_trie[n].children};
+            auto const  it{std::find_if(ch.cbegin(), ch.cend(),
+                                       [c](std::pair<char, std::size_t> const& p_) { return p_.first == c; })};
+            if (it != ch.cend()) {
+                n = it->second;
+            } else {
+                m_trie.emplace_back();
+                m_trie[n].children.emplace_back(c, m_trie.size() - 1);
+                n = m_trie.size() - 1;
+            }
+        }
+        m_trie[n].rules.push_back(rule_);
+    }
+
+    /// Collect all rules, whose testsuite glob matches name_.
+    void
+    candidates(char const* name_, std::vector<rule const*>& cand_) const {
+        cand_.clear();
+        std::size_t n{0};
+        for (char const* c{name_};; ++c) {
+            std::for_each(m_trie[n].rules.cbegin(), m_trie[n].rules.cend(), [&](std::size_t r_) {
+                if (m_rules[r_].suite.match(name_)) {
+                    cand_.push_back(&m_rules[r_]);
+                }
+            });
+            if (*c == '\0') {
+                return;
+            }
+            auto const& ch{m_trie[n].children};
+            auto const  it{std::find_if(ch.cbegin(), ch.cend(),
+                                       [c](std::pair<char, std::size_t> const& p_) { return p_.first == *c; })};
+            if (it == ch.cend()) {
+                return;
+            }
+            n = it->second;
+        }
+    }
+
+    /// Select the testcases of s_, and check whether the testsuite is kept at all.
+    auto
+    keeps(selection& s_, bool include_, std::vector<rule const*>& cand_) const -> bool {
+        candidates(s_.name(), cand_);
+        if (std::any_of(cand_.cbegin(), cand_.cend(), [](rule const* r_) { return r_->whole_suite; })) {
+            return include_;
+        }
+        if (cand_.empty() && m_tags.empty()) {
+            return !include_;
+        }
+        if (s_.tests().empty()) {
+            return !include_;
+        }
+        auto& keep{s_.keep()};
+        for (std::size_t i{0}; i < keep.size(); ++i) {
+            keep[i] = keep[i] != 0 && matches(cand_, s_.tests()[i]) == include_;
+        }
+        return s_.any();
+    }
+
+    auto
+    matches(std::vector<rule const*> const& cand_, test_spec const& spec_) const -> bool {
+        return std::any_of(cand_.cbegin(), cand_.cend(), [&](rule const* r_) { return r_->test.match(spec_.name); }) ||
+               std::any_of(m_tags.cbegin(), m_tags.cend(), [&](glob const& g_) {
+                   return std::any_of(spec_.attrs.tags.cbegin(), spec_.attrs.tags.cend(),
+                                      [&](char const* t_) { return g_.match(t_); });
+               });
+    }
+
+    std::vector<rule> m_rules;
+    std::vector<glob> m_tags;
+    std::vector<node> m_trie = std::vector<node>(1);
+    std::size_t       m_size{0};
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_FILTER_HPP
@@ -0,0 +1,417 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_FIXTURE_HPP
+#define TPP_TEST_FIXTURE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+class fixture;
+using fixture_ptr = std::unique_ptr<fixture>;
+
+/// How many instances of a testsuite class are created, and which of them a testcase runs on.
+enum class instancing
+{
+    per_suite,    ///< One instance for all testcases.
+    per_worker,   ///< One instance for every worker of a parallel testsuite.
+    per_testcase  ///< A new instance for every run of a testcase.
+};
+
+/**
+ * The instances of a testsuite class, that testcases and hooks run on. They are only created while their testsuite is
+ * run, so that testsuites, which are not selected, never construct their members.
+ * Every instance is initialized by the thread setup hook after construction, and finalized by the thread teardown hook
+ * before destruction.
+ */
+class fixture
+{
+public:
+    using make_function    = void* (*)();
+    using destroy_function = void (*)(void*);
+    using hook_function    = void (*)(void*);
+
+    fixture(make_function make_, destroy_function destroy_, instancing inst_ = instancing::per_suite)
+        : m_make(make_), m_destroy(destroy_), m_inst(inst_) {}
+
+    fixture(fixture const&)     = delete;
+    fixture(fixture&&) noexcept = delete;
+    ~fixture() noexcept {
+        discard();
+    }
+    auto
+    operator=(fixture const&) -> fixture& = delete;
+    auto
+    operator=(fixture&&) noexcept -> fixture& = delete;
+
+    void
+    thread_setup(hook_function fn_) {
+        m_init = fn_;
+    }
+
+    void
+    thread_teardown(hook_function fn_) {
+        m_fini = fn_;
+    }
+
+    /**
+     * Prepare instances for a run with workers_ workers. Instances per worker are created by the worker, when it first
+     * runs a testcase.
+     */
+    void
+    acquire(std::size_t workers_) {
+        if (m_inst == instancing::per_worker) {
+            m_workers.assign(std::max<std::size_t>(workers_, 1), nullptr);
+        } else if (m_inst == instancing::per_suite) {
+            shared();
+        }
+    }
+
+    /// Finalize and destroy all instances. If a thread teardown hook throws, the remaining ones are discarded.
+    void
+    release() {
+        std::for_each(m_workers.begin(), m_workers.end(), [&](void*& obj_) { finalize(obj_); });
+        finalize(m_obj);
+        m_workers.clear();
+    }
+
+    /// Get the number of instances of workers, that were created, and are not destroyed yet.
+    auto
+    workers() const -> std::size_t {
+        return static_cast<std::size_t>(
+            std::count_if(m_workers.cbegin(), m_workers.cend(), [](void const* obj_) { return obj_ != nullptr; }));
+    }
+
+    /// Check whether the instance of worker w_ was created, and is not destroyed yet.
+    inline auto
+    has_worker(std::size_t w_) const -> bool {
+        return w_ < m_workers.size() && m_workers[w_];
+    }
+
+    /// Finalize and destroy the instance of worker w_, if it exists. This is meant to be called by the worker itself.
+    void
+    release(std::size_t w_) {
+        if (w_ < m_workers.size()) {
+            finalize(m_workers[w_]);
+        }
+    }
+
+    /// Get the instance, that the calling thread runs testcases and hooks on.
+    auto
+    get() -> void* {
+        auto& t{current_testcase()};
+        if (t.fix == this) {
+            return create(t.obj);
+        }
+        auto const& w{current()};
+        if (w.fix == this && w.index < m_workers.size()) {
+            return create(m_workers[w.index]);
+        }
+        return shared();
+    }
+
+    /// Makes the calling thread run testcases and hooks on the instance of a worker, as long as the scope exists.
+    class worker_scope final
+    {
+    public:
+        worker_scope(fixture const* f_, std::size_t w_) : m_prev_fix(current().fix), m_prev_index(current().index) {
+            current() = worker{f_, w_};
+        }
+
+        worker_scope(worker_scope const&)     = delete;
+        worker_scope(worker_scope&&) noexcept = delete;
+        ~worker_scope() noexcept {
+            current() = worker{m_prev_fix, m_prev_index};
+        }
+        auto
+        operator=(worker_scope const&) -> worker_scope& = delete;
+        auto
+        operator=(worker_scope&&) noexcept -> worker_scope& = delete;
+
+    private:
+        fixture const* const m_prev_fix;
+        std::size_t const    m_prev_index;
+    };
+
+    /**
+     * Makes the calling thread run a testcase and its hooks on a new instance, as long as the scope exists. This only
+     * applies to fixtures with an instance per testcase.
+     */
+    class testcase_scope final
+    {
+    public:
+        explicit testcase_scope(fixture* f_) : m_fix(f_ && f_->m_inst == instancing::per_testcase ? f_ : nullptr) {
+            if (m_fix) {
+                m_prev_fix         = current_testcase().fix;
+                m_prev_obj         = current_testcase().obj;
+                current_testcase() = instance{m_fix, nullptr};
+            }
+        }
+
+        testcase_scope(testcase_scope const&)     = delete;
+        testcase_scope(testcase_scope&&) noexcept = delete;
+        ~testcase_scope() noexcept {
+            if (m_fix) {
+                if (current_testcase().obj) {
+                    m_fix->m_destroy(current_testcase().obj);
+                }
+                current_testcase() = instance{m_prev_fix, m_prev_obj};
+            }
+        }
+        auto
+        operator=(testcase_scope const&) -> testcase_scope& = delete;
+        auto
+        operator=(testcase_scope&&) noexcept -> testcase_scope& = delete;
+
+        /// Finalize and destroy the instance, if it was created.
+        void
+        release() {
+            if (m_fix) {
+                m_fix->finalize(current_testcase().obj);
+            }
+        }
+
+    private:
+        fixture* const m_fix;
+        fixture const* m_prev_fix{nullptr};
+        void*          m_prev_obj{nullptr};
+    };
+
+    /// Holds the instances of a fixture, as long as the scope exists. Instances left on exit are discarded.
+    class scope final
+    {
+    public:
+        scope(fixture* f_, std::size_t workers_) : m_fix(f_) {
+            if (m_fix) {
+                m_fix->acquire(workers_);
+            }
+        }
+
+        scope(scope const&)     = delete;
+        scope(scope&&) noexcept = delete;
+        ~scope() noexcept {
+            if (m_fix) {
+                m_fix->discard();
+            }
+        }
+        auto
+        operator=(scope const&) -> scope& = delete;
+        auto
+        operator=(scope&&) noexcept -> scope& = delete;
+
+        /// Finalize and destroy all instances.
+        void
+        release() {
+            if (m_fix) {
+                m_fix->release();
+            }
+        }
+
+    private:
+        fixture* const m_fix;
+    };
+
+private:
+    struct worker
+    {
+        fixture const* fix;
+        std::size_t    index;
+    };
+
+    struct instance
+    {
+        fixture const* fix;
+        void*          obj;
+    };
+
+    static auto
+    current() -> worker& {
+        static thread_local worker w{nullptr, 0};
+        return w;
+    }
+
+    static auto
+    current_testcase() -> instance& {
+        static thread_local instance i{nullptr, nullptr};
+        return i;
+    }
+
+    inline auto
+    shared() -> void* {
+        return create(m_obj);
+    }
+
+    auto
+    create(void*& obj_) -> void* {
+        if (!obj_) {
+            void* const obj{m_make()};
+            if (m_init) {
+                try {
+                    m_init(obj);
+                } catch (...) {
+                    m_destroy(obj);
+                    throw;
+                }
+            }
+            obj_ = obj;
+        }
+        return obj_;
+    }
+
+    void
+    finalize(void*& obj_) {
+        if (obj_) {
+            void* const obj{obj_};
+            obj_ = nullptr;
+            if (m_fini) {
+                try {
+                    m_fini(obj);
+                } catch (...) {
+                    m_destroy(obj);
+                    throw;
+                }
+            }
+            m_destroy(obj);
+        }
+    }
+
+    /// Destroy all instances without finalizing them.
+    void
+    discard() noexcept {
+        std::for_each(m_workers.begin(), m_workers.end(), [&](void*& obj_) {
+            if (obj_) {
+                m_destroy(obj_);
+            }
+        });
+        m_workers.clear();
+        if (m_obj) {
+            m_destroy(m_obj);
+            m_obj = nullptr;
+        }
+    }
+
+    make_function const    m_make;
+    destroy_function const m_destroy;
+    instancing const       m_inst;
+    hook_function          m_init{nullptr};
+    hook_function          m_fini{nullptr};
+    void*                  m_obj{nullptr};
+    std::vector<void*>     m_workers;
+};
+
+template<typename T>
+auto
+make_module() -> void* {
+    return new T();
+}
+
+template<typename T>
+void
+destroy_module(void* mod_) {
+    delete static_cast<T*>(mod_);
+}
+
+/**
+ * Keeps the memory of destroyed instances of T for reuse by the same thread, as testsuites with an instance per
+ * testcase create them at a high rate.
+ */
+template<typename T>
+class recycler
+{
+public:
+    static auto
+    allocate() -> void* {
+        auto& blocks{free_blocks()};
+        if (blocks.empty()) {
+            return ::operator new(sizeof(T));
+        }
+        void* const b{blocks.back()};
+        blocks.pop_back();
+        return b;
+    }
+
+    static void
+    deallocate(void* b_) noexcept {
+        auto& blocks{free_blocks()};
+        if (blocks.size() < MAX_BLOCKS) {
+            blocks.push_back(b_);
+        } else {
+            ::operator delete(b_);
+        }
+    }
+
+private:
+    static constexpr std::size_t MAX_BLOCKS = 4;
+
+    struct free_list final
+    {
+        free_list() {
+            blocks.reserve(MAX_BLOCKS);
+        }
+        free_list(free_list const&)     = delete;
+        free_list(free_list&&) noexcept = delete;
+        ~free_list() noexcept {
+            std::for_each(blocks.begin(), blocks.end(), [](void* b_) { ::operator delete(b_); });
+        }
+        auto
+        operator=(free_list const&) -> free_list& = delete;
+        auto
+        operator=(free_list&&) noexcept -> free_list& = delete;
+
+        std::vector<void*> blocks;
+    };
+
+    static auto
+    free_blocks() -> std::vector<void*>& {
+        static thread_local free_list l;
+        return l.blocks;
+    }
+};
+
+template<typename T>
+auto
+make_recycled_module() -> void* {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "testsuite class is over-aligned");
+    void* const mem{recycler<T>::allocate()};
+    try {
+        return new (mem) T();
+    } catch (...) {
+        recycler<T>::deallocate(mem);
+        throw;
+    }
+}
+
+template<typename T>
+void
+destroy_recycled_module(void* mod_) {
+    static_cast<T*>(mod_)->~T();
+    recycler<T>::deallocate(mod_);
+}
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_FIXTURE_HPP
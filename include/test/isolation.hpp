@@ -0,0 +1,312 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_ISOLATION_HPP
+#define TPP_TEST_ISOLATION_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "test/testcase.hpp"
+#include "test/watchdog.hpp"
+
+#include "cpp_meta.hpp"
+#include "duration.hpp"
+
+#ifdef TPP_INTERN_SYS_UNIX
+#    include <csignal>
+#    include <execinfo.h>
+#    include <sys/types.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Runs testcases in forked child processes, so that crashes do not take down the whole test binary.
+ * The result, time, and captured output of a testcase are sent back through a pipe. If a child is killed by a signal,
+ * or exits before sending the result, the testcase is recorded as erroneous. Exceptions from hooks in the child are
+ * rethrown in the parent. As every child gets a copy of the process, side effects of testcases are not visible to
+ * others.
+ * If a child is not done in time, the watchdog sends SIGQUIT to it, upon which the child sends its stack trace and
+ * exits. If it does not exit anyway, it is killed after KILL_DELAY. A child without timeout is stopped this way after
+ * MAX_TIME, as a child forked from a multithreaded process may deadlock on a lock, that another thread held during
+ * fork(), and would block the parent forever.
+ */
+class process_isolation
+{
+public:
+#ifdef TPP_INTERN_SYS_UNIX
+    static constexpr bool SUPPORTED = true;
+#else
+    static constexpr bool SUPPORTED = false;
+#endif
+    /// Grace period in milliseconds, that a timed out child gets to send its stack trace.
+    static constexpr double KILL_DELAY = 1000.0;
+    /// Time in milliseconds, after which a child without timeout is stopped.
+    static constexpr double MAX_TIME = 600000.0;
+
+    /**
+     * Run fn_, which is expected to run tc_, in a child process and take over the result of tc_.
+     * If timeout_ is greater than 0, the child is stopped after as many milliseconds, otherwise after MAX_TIME.
+     */
+    template<typename Fn>
+    static void
+    run(testcase& tc_, Fn&& fn_, double timeout_ = .0) {
+#ifdef TPP_INTERN_SYS_UNIX
+        duration d;
+        int      fds[2];
+        pid_t    pid{-1};
+        {
+            // Forking is serialized, so that no other child inherits the write end of the pipe, as this would delay EOF.
+            static std::mutex            fork_mutex;
+            std::unique_lock<std::mutex> lk(fork_mutex);
+            if (::pipe(fds) != 0) {
+                throw std::runtime_error("could not create pipe for child process");
+            }
+            // Output of other threads, e.g. the reporter, must not end up in the buffers inherited by the child.
+            ::flockfile(stdout);
+            ::flockfile(stderr);
+            std::fflush(nullptr);
+            pid = ::fork();
+            ::funlockfile(stderr);
+            ::funlockfile(stdout);
+            if (pid == 0) {
+                // The child never leaves this scope, but may isolate testcases itself.
+                lk.unlock();
+                ::close(fds[0]);
+                child(fds[1], tc_, fn_);
+            }
+            ::close(fds[1]);
+        }
+        if (pid < 0) {
+            ::close(fds[0]);
+            throw std::runtime_error("could not fork child process");
+        }
+        double limit{MAX_TIME};
+        if (timeout_ > .0) {
+            limit = timeout_;
+        }
+        std::unique_ptr<watchdog::guard> dump_guard(new watchdog::guard(limit, [pid] { ::kill(pid, SIGQUIT); }));
+        std::unique_ptr<watchdog::guard> kill_guard(
+            new watchdog::guard(limit + KILL_DELAY, [pid] { ::kill(pid, SIGKILL); }));
+        std::string const rec{read_all(fds[0])};
+        ::close(fds[0]);
+        bool const timed_out{dump_guard->expired()};
+        // The guards must be gone before the child is reaped, as its pid may be reused afterwards.
+        dump_guard.reset();
+        kill_guard.reset();
+        int status{0};
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        if (timed_out) {
+            std::ostringstream msg;
+            msg << "timed out after " << limit << "ms";
+            if (!rec.empty() && rec[0] == TRACE) {
+                msg << ", stack trace:\n" << rec.substr(1);
+            }
+            tc_.result(testcase::HAD_ERROR, d.get(), msg.str());
+            return;
+        }
+        if (WIFSIGNALED(status)) {
+            tc_.result(testcase::HAD_ERROR, d.get(),
+                       "killed by signal " + std::to_string(WTERMSIG(status)) + " (" + ::strsignal(WTERMSIG(status)) +
+                           ")");
+            return;
+        }
+        std::size_t pos{0};
+        char        kind{0};
+        if (get(rec, pos, kind) && kind == HOOK_ERROR) {
+            std::string msg;
+            get(rec, pos, msg);
+            throw std::runtime_error(msg);
+        }
+        int         res{testcase::IS_UNDONE};
+        double      t{.0};
+        std::string reason;
+        std::string out;
+        std::string err;
+        if (kind != RESULT || !get(rec, pos, res) || !get(rec, pos, t) || !get(rec, pos, reason) ||
+            !get(rec, pos, out) || !get(rec, pos, err)) {
+            tc_.result(testcase::HAD_ERROR, d.get(),
+                       "exited with code " + std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1) +
+                           " before the testcase was done");
+            return;
+        }
+        tc_.result(static_cast<testcase::results>(res), t, reason);
+        tc_.cout(out);
+        tc_.cerr(err);
+        std::size_t iterations{0};
+        std::size_t samples{0};
+        if (get(rec, pos, iterations) && get(rec, pos, samples)) {
+            measurement bench;
+            bench.iterations(iterations);
+            double s{.0};
+            for (std::size_t i{0}; i < samples && get(rec, pos, s); ++i) {
+                bench.add(s);
+            }
+            tc_.measured(std::move(bench));
+        }
+#else
+        static_cast<void>(tc_);
+        static_cast<void>(fn_);
+        static_cast<void>(timeout_);
+        throw std::runtime_error("process isolation is not supported on this system");
+#endif
+    }
+
+private:
+    enum : char
+    {
+        RESULT     = 1,
+        HOOK_ERROR = 2,
+        TRACE      = 3
+    };
+
+#ifdef TPP_INTERN_SYS_UNIX
+    template<typename Fn>
+    [[noreturn]] static void
+    child(int fd_, testcase& tc_, Fn&& fn_) {
+        trace_fd() = fd_;
+        void* frame{nullptr};
+        // Loads everything needed in advance, as this is not safe in a signal handler.
+        ::backtrace(&frame, 1);
+        struct sigaction sa
+        {};
+        sa.sa_handler = &send_trace;
+        sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGQUIT, &sa, nullptr);
+        std::string rec;
+        try {
+            fn_();
+            put(rec, static_cast<char>(RESULT));
+            put(rec, static_cast<int>(tc_.result()));
+            put(rec, tc_.elapsed_time());
+            put(rec, tc_.reason());
+            put(rec, tc_.cout());
+            put(rec, tc_.cerr());
+            auto const& bench{tc_.measured()};
+            put(rec, bench.iterations());
+            put(rec, bench.samples().size());
+            std::for_each(bench.samples().cbegin(), bench.samples().cend(), [&](double s_) { put(rec, s_); });
+        } catch (std::exception const& e) {
+            rec.clear();
+            put(rec, static_cast<char>(HOOK_ERROR));
+            put(rec, std::string(e.what()));
+        } catch (...) {
+            rec.clear();
+            put(rec, static_cast<char>(HOOK_ERROR));
+            put(rec, std::string("unknown error"));
+        }
+        std::fflush(nullptr);
+        for (std::size_t n{0}; n < rec.size();) {
+            auto const w{::write(fd_, rec.data() + n, rec.size() - n)};
+            if (w < 0 && errno != EINTR) {
+                break;
+            }
+            n += w > 0 ? static_cast<std::size_t>(w) : 0;
+        }
+        ::_exit(0);
+    }
+
+    static auto
+    trace_fd() -> int& {
+        static int fd{-1};
+        return fd;
+    }
+
+    static void
+    send_trace(int) {
+        // Terminates the child, if sending the trace hangs.
+        ::alarm(1);
+        char const kind{TRACE};
+        if (::write(trace_fd(), &kind, 1) == 1) {
+            void*     frames[64];
+            int const n{::backtrace(frames, 64)};
+            ::backtrace_symbols_fd(frames, n, trace_fd());
+        }
+        ::_exit(1);
+    }
+
+    static auto
+    read_all(int fd_) -> std::string {
+        std::string rec;
+        char        buf[4096];
+        for (;;) {
+            auto const r{::read(fd_, buf, sizeof(buf))};
+            if (r > 0) {
+                rec.append(buf, static_cast<std::size_t>(r));
+            } else if (r == 0 || errno != EINTR) {
+                return rec;
+            }
+        }
+    }
+#endif
+
+    /// Values are stored in native representation, as they are only exchanged with a copy of the same process.
+    template<typename T>
+    static void
+    put(std::string& rec_, T const& v_) {
+        rec_.append(reinterpret_cast<char const*>(&v_), sizeof(T));
+    }
+
+    static void
+    put(std::string& rec_, std::string const& str_) {
+        put(rec_, str_.size());
+        rec_.append(str_);
+    }
+
+    template<typename T>
+    static auto
+    get(std::string const& rec_, std::size_t& pos_, T& v_) -> bool {
+        if (rec_.size() - pos_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&v_, rec_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    static auto
+    get(std::string const& rec_, std::size_t& pos_, std::string& str_) -> bool {
+        std::size_t n{0};
+        if (!get(rec_, pos_, n) || rec_.size() - pos_ < n) {
+            return false;
+        }
+        str_.assign(rec_, pos_, n);
+        pos_ += n;
+        return true;
+    }
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_ISOLATION_HPP
@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_MANIFEST_HPP
+#define TPP_TEST_MANIFEST_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "test/run_cache.hpp"
+#include "test/testsuite.hpp"
+
+#include "stringify.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * A listing of testsuites and their testcases, including tags and last known times, without running anything.
+ * Times are taken from a run_cache, and omitted if unknown.
+ */
+class manifest
+{
+public:
+    manifest(std::vector<testsuite_ptr> const& suites_, run_cache const& cache_) : m_suites(suites_), m_cache(cache_) {}
+
+    /// Write one line per testsuite, followed by one indented line per testcase.
+    void
+    text(std::ostream& out_) const {
+        std::size_t n{0};
+        std::for_each(m_suites.cbegin(), m_suites.cend(), [&](testsuite_ptr const& ts_) {
+            out_ << ts_->name();
+            time(out_, m_cache.time(*ts_), " (", "ms)");
+            out_ << '\n';
+            std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(), [&](testcase const& tc_) {
+                out_ << "  " << tc_.name();
+                std::for_each(tc_.attributes().tags.cbegin(), tc_.attributes().tags.cend(),
+                              [&](char const* t_) { out_ << " @" << t_; });
+                time(out_, m_cache.time(tc_), " (", "ms)");
+                out_ << '\n';
+            });
+            n += ts_->testcases().size();
+        });
+        out_ << m_suites.size() << " testsuites, " << n << " testcases" << std::endl;
+    }
+
+    /// Write a single JSON object, with one line per testsuite.
+    void
+    json(std::ostream& out_) const {
+        std::size_t n{0};
+        out_ << "{\"testsuites\":[";
+        for (std::size_t s{0}; s < m_suites.size(); ++s) {
+            auto const& ts{*m_suites[s]};
+            out_ << (s > 0 ? "," : "") << "\n{\"name\":\"" << escaped_string(ts.name()) << '"';
+            time(out_, m_cache.time(ts), ",\"time\":", "");
+            out_ << ",\"tests\":[";
+            for (std::size_t t{0}; t < ts.testcases().size(); ++t) {
+                auto const& tc{ts.testcases()[t]};
+                out_ << (t > 0 ? "," : "") << "{\"name\":\"" << escaped_string(tc.name()) << "\",\"tags\":[";
+                auto const& tags{tc.attributes().tags};
+                for (std::size_t i{0}; i < tags.size(); ++i) {
+                    out_ << (i > 0 ? "," : "") << '"' << escaped_string(tags[i]) << '"';
+                }
+                out_ << ']';
+                time(out_, m_cache.time(tc), ",\"time\":", "");
+                out_ << '}';
+            }
+            out_ << "]}";
+            n += ts.testcases().size();
+        }
+        out_ << "\n],\"count\":" << n << '}' << std::endl;
+    }
+
+private:
+    static void
+    time(std::ostream& out_, double t_, char const* pre_, char const* post_) {
+        if (!std::isinf(t_)) {
+            out_ << pre_ << t_ << post_;
+        }
+    }
+
+    std::vector<testsuite_ptr> const& m_suites;
+    run_cache const&                  m_cache;
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_MANIFEST_HPP
@@ -0,0 +1,259 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_REGISTRY_HPP
+#define TPP_TEST_REGISTRY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/fixture.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+class suite_record;
+
+enum class member_kind
+{
+    testcase,
+    setup,
+    teardown,
+    before_each,
+    after_each,
+    thread_setup,
+    thread_teardown
+};
+
+/**
+ * A testcase, or hook, as defined in a testsuite by the API. Records are static objects, that link themselves into the
+ * record of their testsuite, so registering them allocates nothing.
+ */
+struct member_record
+{
+    using spec_function = test_spec (*)();
+    using run_function  = void (*)(void*);
+
+    member_record(suite_record& suite_, member_kind kind_, int line_, spec_function spec_, run_function run_);
+
+    member_kind const   kind;
+    int const           line;  ///< Orders members as they are defined.
+    spec_function const spec;  ///< Creates name and attributes of a testcase, only when it is instantiated.
+    run_function const  run;   ///< Runs the member on an instance of its testsuite.
+    member_record*      next{nullptr};
+};
+
+/**
+ * A testsuite, as defined by the API. Its factories, and the list of its members are known at compile time, so that
+ * records are initialized before any code runs. Testsuites, and their name and attributes, are only created by
+ * instantiate().
+ */
+class suite_record
+{
+public:
+    using spec_function    = suite_spec (*)();
+    using create_function  = testsuite_ptr (*)(char const*);
+    using make_function    = fixture::make_function;
+    using destroy_function = fixture::destroy_function;
+
+    constexpr suite_record(spec_function spec_, create_function create_, make_function make_, destroy_function destroy_,
+                           instancing inst_ = instancing::per_suite)
+        : m_spec(spec_), m_create(create_), m_make(make_), m_destroy(destroy_), m_inst(inst_) {}
+
+    void
+    add(member_record* m_) {
+        m_->next  = m_members;
+        m_members = m_;
+    }
+
+    /**
+     * Create the testsuite with all its testcases and hooks. They run on an instance of the testsuite class, which is
+     * only created when the testsuite is run.
+     */
+    auto
+    instantiate() const -> testsuite_ptr {
+        return build([](std::size_t) { return true; });
+    }
+
+    /// Create the testsuite like instantiate(), but only with the testcases, whose index in tests() is set in keep_.
+    auto
+    instantiate(std::vector<char> const& keep_) const -> testsuite_ptr {
+        return build([&](std::size_t i_) { return i_ < keep_.size() && keep_[i_] != 0; });
+    }
+
+    /// Get name and attributes of the testsuite, without creating it.
+    inline auto
+    spec() const -> suite_spec {
+        return m_spec();
+    }
+
+    /// Get names and attributes of all testcases in the order of their definition, without creating them.
+    auto
+    tests() const -> std::vector<test_spec> {
+        std::vector<test_spec> specs;
+        auto const             members{sorted()};
+        std::for_each(members.cbegin(), members.cend(), [&](member_record const* m_) {
+            if (m_->kind == member_kind::testcase) {
+                specs.push_back(m_->spec());
+            }
+        });
+        return specs;
+    }
+
+    inline auto
+    next() const -> suite_record const* {
+        return m_next;
+    }
+
+private:
+    friend class registry;
+
+    /// Get all members in the order of their definition.
+    auto
+    sorted() const -> std::vector<member_record const*> {
+        std::vector<member_record const*> members;
+        for (auto const* m{m_members}; m; m = m->next) {
+            members.push_back(m);
+        }
+        std::stable_sort(members.begin(), members.end(),
+                         [](member_record const* l_, member_record const* r_) { return l_->line < r_->line; });
+        return members;
+    }
+
+    /// Create the testsuite with all hooks, and the testcases, whose index satisfies keep_.
+    template<typename Fn>
+    auto
+    build(Fn&& keep_) const -> testsuite_ptr {
+        auto const     spec{m_spec()};
+        auto           ts{m_create(spec.name)};
+        fixture_ptr    fix{new fixture(m_make, m_destroy, m_inst)};
+        fixture* const raw{fix.get()};
+        auto const     members{sorted()};
+        std::size_t    tc{0};
+        std::for_each(members.cbegin(), members.cend(), [&](member_record const* m_) {
+            if (m_->kind == member_kind::testcase && !keep_(tc++)) {
+                return;
+            }
+            auto const run{m_->run};
+            // Fits into the local storage of std::function, hence nothing is allocated per member.
+            testsuite::hook_function fn{[raw, run] { run(raw->get()); }};
+            switch (m_->kind) {
+                case member_kind::testcase: ts->test(m_->spec(), std::move(fn)); break;
+                case member_kind::setup: ts->setup(std::move(fn)); break;
+                case member_kind::teardown: ts->teardown(std::move(fn)); break;
+                case member_kind::before_each: ts->before_each(std::move(fn)); break;
+                case member_kind::after_each: ts->after_each(std::move(fn)); break;
+                case member_kind::thread_setup: raw->thread_setup(run); break;
+                case member_kind::thread_teardown: raw->thread_teardown(run); break;
+            }
+        });
+        ts->fixture(std::move(fix));
+        std::for_each(spec.attrs.depends.cbegin(), spec.attrs.depends.cend(),
+                      [&](char const* d_) { ts->depends_on(d_); });
+        return ts;
+    }
+
+    spec_function const    m_spec;
+    create_function const  m_create;
+    make_function const    m_make;
+    destroy_function const m_destroy;
+    instancing const       m_inst;
+    member_record*         m_members{nullptr};
+    suite_record*          m_next{nullptr};
+};
+
+inline member_record::member_record(suite_record& suite_, member_kind kind_, int line_, spec_function spec_,
+                                    run_function run_)
+    : kind(kind_), line(line_), spec(spec_), run(run_) {
+    suite_.add(this);
+}
+
+/// All testsuites defined by the API, in the order of their definition.
+class registry
+{
+public:
+    void
+    add(suite_record* s_) {
+        (m_tail ? m_tail->m_next : m_head) = s_;
+        m_tail                             = s_;
+    }
+
+    auto
+    instantiate() const -> std::vector<testsuite_ptr> {
+        std::vector<testsuite_ptr> suites;
+        for (auto const* s{m_head}; s; s = s->next()) {
+            suites.push_back(s->instantiate());
+        }
+        return suites;
+    }
+
+    /// Get the record of the first testsuite, the others follow by next().
+    inline auto
+    front() const -> suite_record const* {
+        return m_head;
+    }
+
+    inline auto
+    empty() const -> bool {
+        return m_head == nullptr;
+    }
+
+    /// Get the process wide registry, that the API defines testsuites in.
+    static auto
+    instance() -> registry& {
+        static registry r;
+        return r;
+    }
+
+private:
+    suite_record* m_head{nullptr};
+    suite_record* m_tail{nullptr};
+};
+
+/// Adds a suite record to the registry during static initialization.
+struct suite_registrar
+{
+    explicit suite_registrar(suite_record& s_) {
+        registry::instance().add(&s_);
+    }
+};
+
+/**
+ * Holds the record of a member M of a testsuite. M is a type, that is defined by the API for every testcase and hook.
+ * Referring to the record instantiates it, and thereby links it into the record of its testsuite.
+ */
+template<typename M>
+struct member_registrar
+{
+    static member_record record;
+};
+
+template<typename M>
+member_record member_registrar<M>::record(M::suite(), M::KIND, M::LINE, &M::spec, &M::run);
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_REGISTRY_HPP
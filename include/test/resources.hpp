@@ -0,0 +1,195 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_RESOURCES_HPP
+#define TPP_TEST_RESOURCES_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test/attributes.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+class resources;
+using resources_ptr = std::shared_ptr<resources>;
+
+/**
+ * Limits how many testcases hold a named resource at the same time, across all testsuites of a run.
+ * Every name has a single limit for the whole run, which is the one it was first declared with. All resources of a
+ * testcase are acquired at once, so that testcases never wait for each other in a cycle. A name, that is given more than
+ * once, is held once with its lowest limit.
+ * Every testcase of the run is a holder, so that an exclusive holder, like a benchmark, runs only while no other
+ * testcase of the whole run does. Once it waits, no other holder starts before it.
+ */
+class resources
+{
+public:
+    /// Register the limits of all given resources. Throws, if a name was declared with another limit before.
+    void
+    declare(std::vector<resource> const& res_) {
+        auto const                  res{unique(res_)};
+        std::lock_guard<std::mutex> lk(m_mutex);
+        register_limits(res);
+    }
+
+    /// Wait until all given resources are available, and hold them, alone if exclusive_ is set.
+    void
+    acquire(std::vector<resource> const& res_, bool exclusive_ = false) {
+        auto const                   res{unique(res_)};
+        std::unique_lock<std::mutex> lk(m_mutex);
+        register_limits(res);
+        if (!admissible(res, exclusive_)) {
+            ++m_waiting;
+            m_exclusive_waiting += exclusive_ ? 1 : 0;
+            m_cv.wait(lk, [&] { return admissible(res, exclusive_); });
+            m_exclusive_waiting -= exclusive_ ? 1 : 0;
+            --m_waiting;
+        }
+        take(res, exclusive_);
+    }
+
+    /// Hold all given resources, alone if exclusive_ is set, if they are available right now. Return whether they are.
+    auto
+    try_acquire(std::vector<resource> const& res_, bool exclusive_ = false) -> bool {
+        auto const                  res{unique(res_)};
+        std::lock_guard<std::mutex> lk(m_mutex);
+        register_limits(res);
+        if (!admissible(res, exclusive_)) {
+            return false;
+        }
+        take(res, exclusive_);
+        return true;
+    }
+
+    void
+    release(std::vector<resource> const& res_, bool exclusive_ = false) {
+        auto const res{unique(res_)};
+        bool       waiting{false};
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            std::for_each(res.cbegin(), res.cend(), [&](resource const& r_) { --m_holders[r_.name]; });
+            --m_running;
+            m_exclusive = m_exclusive && !exclusive_;
+            waiting     = m_waiting > 0;
+        }
+        if (waiting) {
+            m_cv.notify_all();
+        }
+    }
+
+    /// Holds resources, as long as the scope exists.
+    class hold final
+    {
+    public:
+        hold(resources* r_, std::vector<resource> const& res_, bool exclusive_ = false)
+            : m_res(r_), m_held(res_), m_exclusive(exclusive_) {
+            if (m_res) {
+                m_res->acquire(m_held, m_exclusive);
+            }
+        }
+
+        hold(hold const&)     = delete;
+        hold(hold&&) noexcept = delete;
+        ~hold() noexcept {
+            if (m_res) {
+                m_res->release(m_held, m_exclusive);
+            }
+        }
+        auto
+        operator=(hold const&) -> hold& = delete;
+        auto
+        operator=(hold&&) noexcept -> hold& = delete;
+
+    private:
+        resources* const             m_res;
+        std::vector<resource> const& m_held;
+        bool const                   m_exclusive;
+    };
+
+    /// Get every name in res_ once, in order of their first occurrence, with its lowest limit.
+    static auto
+    unique(std::vector<resource> const& res_) -> std::vector<resource> {
+        std::vector<resource> res;
+        std::for_each(res_.cbegin(), res_.cend(), [&](resource const& r_) {
+            auto it{std::find_if(res.begin(), res.end(),
+                                 [&](resource const& h_) { return std::strcmp(h_.name, r_.name) == 0; })};
+            if (it == res.end()) {
+                res.push_back(r_);
+            } else {
+                it->limit = std::min(it->limit, r_.limit);
+            }
+        });
+        return res;
+    }
+
+private:
+    void
+    register_limits(std::vector<resource> const& res_) {
+        std::for_each(res_.cbegin(), res_.cend(), [&](resource const& r_) {
+            auto const l{m_limits.emplace(r_.name, r_.limit).first};
+            if (l->second != r_.limit) {
+                throw std::runtime_error("resource " + l->first + " is declared with limits " +
+                                         std::to_string(l->second) + " and " + std::to_string(r_.limit) + "!");
+            }
+        });
+    }
+
+    auto
+    available(std::vector<resource> const& res_) -> bool {
+        return std::all_of(res_.cbegin(), res_.cend(),
+                           [&](resource const& r_) { return m_holders[r_.name] < m_limits[r_.name]; });
+    }
+
+    auto
+    admissible(std::vector<resource> const& res_, bool exclusive_) -> bool {
+        return !m_exclusive && (exclusive_ ? m_running == 0 : m_exclusive_waiting == 0) && available(res_);
+    }
+
+    void
+    take(std::vector<resource> const& res_, bool exclusive_) {
+        std::for_each(res_.cbegin(), res_.cend(), [&](resource const& r_) { ++m_holders[r_.name]; });
+        ++m_running;
+        m_exclusive = exclusive_;
+    }
+
+    std::mutex                         m_mutex;
+    std::condition_variable            m_cv;
+    std::map<std::string, std::size_t> m_holders;
+    std::map<std::string, std::size_t> m_limits;
+    std::size_t                        m_running{0};            ///< Holders of the whole run.
+    std::size_t                        m_waiting{0};            ///< Holders waiting in acquire().
+    std::size_t                        m_exclusive_waiting{0};  ///< Exclusive holders waiting in acquire().
+    bool                               m_exclusive{false};      ///< Whether an exclusive holder runs.
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_RESOURCES_HPP
@@ -0,0 +1,237 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_RUN_CACHE_HPP
+#define TPP_TEST_RUN_CACHE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test/testsuite.hpp"
+
+#include "stringify.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Knowledge about previous runs, that is persisted in a file.
+ * Every line holds a record for either a testsuite, a testcase, or a testcase that failed, or had an error when it was
+ * run last, with tab separated fields.
+ *   S <time> <testsuite>
+ *   T <time> <testsuite> <testcase>
+ *   F <testsuite> <testcase>
+ * Names are stored escaped, so that they do not contain any tab, or newline.
+ */
+class run_cache
+{
+public:
+    /// Load all records from a file. A missing file is treated as empty cache.
+    void
+    load(std::string const& fname_) {
+        std::ifstream in(fname_);
+        std::string   line;
+        while (std::getline(in, line)) {
+            auto const fields{split(line)};
+            if (fields.size() < 3) {
+                continue;
+            }
+            if (fields[0] == "F") {
+                m_failed.insert(key(fields[1], fields[2]));
+                continue;
+            }
+            double t{.0};
+            if (!(std::istringstream(fields[1]) >> t)) {
+                continue;
+            }
+            if (fields[0] == "S") {
+                m_suites[fields[2]] = t;
+            } else if (fields[0] == "T" && fields.size() > 3) {
+                m_tests[key(fields[2], fields[3])] = t;
+            }
+        }
+    }
+
+    void
+    save(std::string const& fname_) const {
+        std::ofstream out(fname_, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("could not open file for cache");
+        }
+        for (auto const& s : m_suites) {
+            out << "S\t" << s.second << '\t' << s.first << '\n';
+        }
+        for (auto const& t : m_tests) {
+            out << "T\t" << t.second << '\t' << t.first << '\n';
+        }
+        for (auto const& f : m_failed) {
+            out << "F\t" << f << '\n';
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("could not write cache");
+        }
+    }
+
+    /// Record the times of a testsuite and all its testcases, that were run.
+    void
+    update(testsuite const& ts_) {
+        if (ts_.statistics().tests() == 0) {
+            return;
+        }
+        m_suites[escaped_string(ts_.name())] = ts_.statistics().elapsed_time();
+        std::for_each(ts_.testcases().cbegin(), ts_.testcases().cend(), [&](testcase const& tc_) {
+            if (tc_.result() != testcase::IS_UNDONE) {
+                auto k{key(tc_)};
+                m_tests[k] = tc_.elapsed_time();
+                if (tc_.result() == testcase::HAS_FAILED || tc_.result() == testcase::HAD_ERROR) {
+                    m_failed.insert(std::move(k));
+                } else {
+                    m_failed.erase(k);
+                }
+            }
+        });
+    }
+
+    /// Get the last known time of a testcase, or infinity if it is unknown.
+    auto
+    time(testcase const& tc_) const -> double {
+        return time(tc_.suite_name(), tc_.name());
+    }
+
+    /// Get the last known time of a testcase by its name, and the name of its testsuite, or infinity if it is unknown.
+    auto
+    time(char const* ts_, char const* tc_) const -> double {
+        auto const it{m_tests.find(key(escaped_string(ts_), escaped_string(tc_)))};
+        return it != m_tests.cend() ? it->second : std::numeric_limits<double>::infinity();
+    }
+
+    /// Get the last known time of a testsuite, or infinity if it is unknown.
+    auto
+    time(testsuite const& ts_) const -> double {
+        auto const it{m_suites.find(escaped_string(ts_.name()))};
+        return it != m_suites.cend() ? it->second : std::numeric_limits<double>::infinity();
+    }
+
+    /// Check whether a testcase failed, or had an error, when it was run last.
+    auto
+    failed(testcase const& tc_) const -> bool {
+        return failed(tc_.suite_name(), tc_.name());
+    }
+
+    /// Check whether a testcase failed, or had an error, by its name, and the name of its testsuite.
+    auto
+    failed(char const* ts_, char const* tc_) const -> bool {
+        return m_failed.count(key(escaped_string(ts_), escaped_string(tc_))) > 0;
+    }
+
+    /// Check whether any testcase of a testsuite failed, or had an error, when it was run last.
+    auto
+    failed(testsuite const& ts_) const -> bool {
+        auto const prefix{key(escaped_string(ts_.name()), "")};
+        auto const it{m_failed.lower_bound(prefix)};
+        return it != m_failed.cend() && it->compare(0, prefix.size(), prefix) == 0;
+    }
+
+    /// Let schedule() put everything that failed when it was run last in front of all others.
+    void
+    failed_first() {
+        m_failed_first = true;
+    }
+
+    /**
+     * Get the indices of all testcases in a testsuite, ordered by their last known time - longest first.
+     * Unknown testcases are put in front, as they could take arbitrary long.
+     */
+    auto
+    schedule(testsuite const& ts_) const -> std::vector<std::size_t> {
+        return longest_first(
+            ts_.testcases().size(), [&](std::size_t i_) { return time(ts_.testcases()[i_]); },
+            [&](std::size_t i_) { return m_failed_first && failed(ts_.testcases()[i_]); });
+    }
+
+    /// Get the indices of all testsuites, ordered by their last known time - longest first.
+    auto
+    schedule(std::vector<testsuite_ptr> const& suites_) const -> std::vector<std::size_t> {
+        return longest_first(
+            suites_.size(), [&](std::size_t i_) { return time(*suites_[i_]); },
+            [&](std::size_t i_) { return m_failed_first && failed(*suites_[i_]); });
+    }
+
+private:
+    /// Order by priority first, and by time - longest first - afterwards.
+    template<typename Fn, typename Prio>
+    static auto
+    longest_first(std::size_t n_, Fn&& time_fn_, Prio&& prio_fn_) -> std::vector<std::size_t> {
+        std::vector<double> times(n_);
+        std::vector<bool>   prios(n_);
+        for (std::size_t i{0}; i < n_; ++i) {
+            times[i] = time_fn_(i);
+            prios[i] = prio_fn_(i);
+        }
+        std::vector<std::size_t> order(n_);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t l_, std::size_t r_) {
+            return prios[l_] != prios[r_] ? prios[l_] : times[l_] > times[r_];
+        });
+        return order;
+    }
+
+    static auto
+    key(std::string const& ts_, std::string const& tc_) -> std::string {
+        return ts_ + '\t' + tc_;
+    }
+
+    static auto
+    key(testcase const& tc_) -> std::string {
+        return key(escaped_string(tc_.suite_name()), escaped_string(tc_.name()));
+    }
+
+    static auto
+    split(std::string const& line_) -> std::vector<std::string> {
+        std::vector<std::string> fields;
+        std::size_t              b{0};
+        std::size_t              e{0};
+        while ((e = line_.find('\t', b)) != std::string::npos) {
+            fields.push_back(line_.substr(b, e - b));
+            b = e + 1;
+        }
+        fields.push_back(line_.substr(b));
+        return fields;
+    }
+
+    std::map<std::string, double> m_suites;
+    std::map<std::string, double> m_tests;   ///< Keyed by testsuite and testcase name.
+    std::set<std::string>         m_failed;  ///< Keys of testcases, that failed when they were run last.
+    bool                          m_failed_first{false};
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_RUN_CACHE_HPP
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_SELECTION_HPP
+#define TPP_TEST_SELECTION_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/registry.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * The testcases of a testsuite, that are selected to run, by their names and attributes. A testsuite defined by the API
+ * is selected by its record, so that neither the testsuite, nor any of its testcases is created, unless it is selected.
+ */
+class selection
+{
+public:
+    explicit selection(suite_record const& rec_)
+        : m_record(&rec_), m_name(rec_.spec().name), m_tests(rec_.tests()), m_keep(m_tests.size(), 1) {}
+
+    explicit selection(testsuite_ptr const& ts_) : m_suite(ts_), m_name(ts_->name()) {
+        std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(), [&](testcase const& tc_) {
+            test_spec spec(tc_.name());
+            spec.attrs = tc_.attributes();
+            m_tests.push_back(std::move(spec));
+        });
+        m_keep.assign(m_tests.size(), 1);
+    }
+
+    /**
+     * Create the testsuite with the selected testcases only. A testsuite, that was given already, gets all other
+     * testcases removed instead.
+     */
+    auto
+    instantiate() const -> testsuite_ptr {
+        if (m_record) {
+            return m_record->instantiate(m_keep);
+        }
+        m_suite->keep(m_keep);
+        return m_suite;
+    }
+
+    /// Check whether any testcase is selected.
+    auto
+    any() const -> bool {
+        return std::any_of(m_keep.cbegin(), m_keep.cend(), [](char k_) { return k_ != 0; });
+    }
+
+    inline auto
+    name() const -> char const* {
+        return m_name;
+    }
+
+    /// Get names and attributes of all testcases, including the ones, that are not selected.
+    inline auto
+    tests() const -> std::vector<test_spec> const& {
+        return m_tests;
+    }
+
+    /// Get whether each testcase is selected, by its index in tests().
+    inline auto
+    keep() -> std::vector<char>& {
+        return m_keep;
+    }
+
+    /// Get the record, that the testsuite is created from, or nullptr if it was given already.
+    inline auto
+    record() const -> suite_record const* {
+        return m_record;
+    }
+
+private:
+    suite_record const*    m_record{nullptr};
+    testsuite_ptr          m_suite;
+    char const*            m_name;
+    std::vector<test_spec> m_tests;
+    std::vector<char>      m_keep;
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_SELECTION_HPP
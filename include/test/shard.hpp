@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_SHARD_HPP
+#define TPP_TEST_SHARD_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "test/run_cache.hpp"
+#include "test/selection.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/// FNV-1a, as it must not differ between platforms or processes.
+inline auto
+stable_hash(std::string const& str_) -> std::uint64_t {
+    std::uint64_t h{14695981039346656037ULL};
+    for (char c : str_) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * A deterministic partition of all testcases, so that multiple processes with the same testcases, but different shard
+ * indices, run every testcase exactly once.
+ * Testcases with a known time are distributed greedily longest first to the shard with the least total time. All others
+ * are assigned by a stable hash of their names. Hence all shards must use the same cache, if any.
+ */
+struct shard
+{
+    shard() = default;
+    shard(std::size_t index_, std::size_t count_) : index(index_), count(count_) {}
+
+    /// Keep only the selected testcases, that belong to this shard.
+    void
+    apply(std::vector<selection>& sel_, run_cache const& cache_) const {
+        if (count <= 1) {
+            return;
+        }
+        struct item
+        {
+            std::size_t ts;
+            std::size_t tc;
+            double      time;
+        };
+        std::vector<item> known;
+        for (std::size_t s{0}; s < sel_.size(); ++s) {
+            auto const& tests{sel_[s].tests()};
+            auto&       keep{sel_[s].keep()};
+            for (std::size_t t{0}; t < tests.size(); ++t) {
+                if (keep[t] == 0) {
+                    continue;
+                }
+                auto const time{cache_.time(sel_[s].name(), tests[t].name)};
+                if (std::isinf(time)) {
+                    keep[t] = stable_hash(std::string(sel_[s].name()) + '\t' + tests[t].name) % count == index;
+                } else {
+                    known.push_back(item{s, t, time});
+                }
+            }
+        }
+        std::stable_sort(known.begin(), known.end(), [](item const& l_, item const& r_) { return l_.time > r_.time; });
+        std::vector<double> loads(count, .0);
+        std::for_each(known.cbegin(), known.cend(), [&](item const& i_) {
+            auto const least{static_cast<std::size_t>(std::min_element(loads.cbegin(), loads.cend()) - loads.cbegin())};
+            loads[least] += i_.time;
+            sel_[i_.ts].keep()[i_.tc] = least == index;
+        });
+    }
+
+    /// Keep only the testcases of this shard in the given testsuites.
+    void
+    apply(std::vector<testsuite_ptr> const& suites_, run_cache const& cache_) const {
+        std::vector<selection> sel(suites_.cbegin(), suites_.cend());
+        apply(sel, cache_);
+        std::for_each(sel.cbegin(), sel.cend(), [](selection const& s_) { s_.instantiate(); });
+    }
+
+    std::size_t index{0};
+    std::size_t count{1};
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_SHARD_HPP
@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_SHUFFLE_HPP
+#define TPP_TEST_SHUFFLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test/shard.hpp"
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * A random order of testsuites and testcases, that is reproducible from its seed on every platform.
+ * Every testsuite and testcase is sorted by a key, that only depends on the seed and its own name, so that filtering
+ * does not change the relative order of the remaining ones.
+ */
+struct shuffle
+{
+    /// Shuffle the testsuites, and schedule their testcases in random order.
+    void
+    apply(std::vector<testsuite_ptr>& suites_) const {
+        std::vector<std::string> ts_names;
+        ts_names.reserve(suites_.size());
+        std::for_each(suites_.cbegin(), suites_.cend(),
+                      [&](testsuite_ptr const& ts_) { ts_names.emplace_back(ts_->name()); });
+        auto const                 ts_order{order(ts_names)};
+        std::vector<testsuite_ptr> shuffled;
+        shuffled.reserve(suites_.size());
+        std::for_each(ts_order.cbegin(), ts_order.cend(), [&](std::size_t i_) { shuffled.push_back(suites_[i_]); });
+        suites_ = std::move(shuffled);
+        std::for_each(suites_.begin(), suites_.end(), [&](testsuite_ptr& ts_) {
+            std::vector<std::string> tc_names;
+            tc_names.reserve(ts_->testcases().size());
+            std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(), [&](testcase const& tc_) {
+                tc_names.push_back(std::string(tc_.suite_name()) + '\t' + tc_.name());
+            });
+            ts_->schedule(order(tc_names));
+        });
+    }
+
+    /**
+     * Get a permutation of the indices of names_, where every name is sorted by a hash of the seed, the name, and how
+     * often it occurred before, as names of testcases need not be unique.
+     */
+    auto
+    order(std::vector<std::string> const& names_) const -> std::vector<std::size_t> {
+        std::vector<std::pair<std::uint64_t, std::size_t>> keyed;
+        std::map<std::string, std::size_t>                 seen;
+        keyed.reserve(names_.size());
+        for (std::size_t i{0}; i < names_.size(); ++i) {
+            auto const occurrence{seen[names_[i]]++};
+            keyed.emplace_back(
+                stable_hash(std::to_string(seed) + '\t' + names_[i] + '\t' + std::to_string(occurrence)), i);
+        }
+        std::sort(keyed.begin(), keyed.end());
+        std::vector<std::size_t> o;
+        o.reserve(keyed.size());
+        std::for_each(keyed.cbegin(), keyed.cend(),
+                      [&](std::pair<std::uint64_t, std::size_t> const& k_) { o.push_back(k_.second); });
+        return o;
+    }
+
+    static auto
+    random_seed() -> std::uint64_t {
+        std::random_device rd;
+        return (static_cast<std::uint64_t>(rd()) << 32U) ^ rd();
+    }
+
+    bool          enabled{false};
+    std::uint64_t seed{0};
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_SHUFFLE_HPP
@@ -18,7 +18,10 @@
 #ifndef TPP_TEST_STATISTICS_HPP
 #define TPP_TEST_STATISTICS_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <vector>
 
 namespace tpp
 {
@@ -36,7 +39,7 @@ public:
 
     inline auto
     successes() const -> std::size_t {
-        return m_num_tests - m_num_errs - m_num_fails;
+        return m_num_tests - m_num_errs - m_num_fails - m_num_skips;
     }
 
     inline auto
@@ -49,6 +52,12 @@ public:
         return m_num_errs;
     }
 
+    /// Get the number of testcases, that were not run, e.g. due to cancellation.
+    inline auto
+    skipped() const -> std::size_t {
+        return m_num_skips;
+    }
+
     inline auto
     elapsed_time() const -> double {
         return m_elapsed_t;
@@ -61,8 +70,144 @@ private:
     std::size_t m_num_tests{0};
     std::size_t m_num_fails{0};
     std::size_t m_num_errs{0};
+    std::size_t m_num_skips{0};
     double      m_elapsed_t{.0};
 };
+
+/// Statistics of all runs of a testcase, that was run repeatedly.
+class repetition
+{
+public:
+    void
+    add(double elapsed_t_, bool failed_) {
+        m_times.push_back(elapsed_t_);
+        m_num_fails += failed_ ? 1 : 0;
+    }
+
+    inline auto
+    runs() const -> std::size_t {
+        return m_times.size();
+    }
+
+    /// Get the number of runs, that failed, or had an error.
+    inline auto
+    failures() const -> std::size_t {
+        return m_num_fails;
+    }
+
+    inline auto
+    min() const -> double {
+        return percentile(0);
+    }
+
+    inline auto
+    median() const -> double {
+        return percentile(50);
+    }
+
+    inline auto
+    p99() const -> double {
+        return percentile(99);
+    }
+
+    /// Get the times of all runs in the order of their occurrence.
+    inline auto
+    times() const -> std::vector<double> const& {
+        return m_times;
+    }
+
+    /// Get the time, that p_ percent of all runs took at most, by nearest rank. Returns 0 if there was no run.
+    auto
+    percentile(double p_) const -> double {
+        if (m_times.empty()) {
+            return .0;
+        }
+        auto const rank{static_cast<std::size_t>(std::ceil(p_ / 100.0 * static_cast<double>(m_times.size())))};
+        auto const idx{rank > 0 ? std::min(rank, m_times.size()) - 1 : 0};
+        std::vector<double> t(m_times);
+        std::nth_element(t.begin(), t.begin() + static_cast<std::ptrdiff_t>(idx), t.end());
+        return t[idx];
+    }
+
+private:
+    std::vector<double> m_times;
+    std::size_t         m_num_fails{0};
+};
+
+/// Statistics of a benchmark, as samples of the time in nanoseconds, that one iteration took on average.
+class measurement
+{
+public:
+    void
+    add(double ns_) {
+        m_samples.push_back(ns_);
+    }
+
+    /// Set the number of iterations, that every sample was taken over.
+    inline void
+    iterations(std::size_t n_) {
+        m_iterations = n_;
+    }
+
+    inline auto
+    iterations() const -> std::size_t {
+        return m_iterations;
+    }
+
+    /// Get all samples in the order, they were taken.
+    inline auto
+    samples() const -> std::vector<double> const& {
+        return m_samples;
+    }
+
+    auto
+    mean() const -> double {
+        if (m_samples.empty()) {
+            return .0;
+        }
+        double sum{.0};
+        std::for_each(m_samples.cbegin(), m_samples.cend(), [&](double s_) { sum += s_; });
+        return sum / static_cast<double>(m_samples.size());
+    }
+
+    /// Get the median of all samples, which is the mean of both middle samples for an even number of them.
+    auto
+    median() const -> double {
+        if (m_samples.empty()) {
+            return .0;
+        }
+        std::vector<double> s(m_samples);
+        std::sort(s.begin(), s.end());
+        auto const mid{s.size() / 2};
+        return s.size() % 2 == 0 ? (s[mid - 1] + s[mid]) / 2.0 : s[mid];
+    }
+
+    /// Get the sample standard deviation, or 0 if there are less than two samples.
+    auto
+    stddev() const -> double {
+        if (m_samples.size() < 2) {
+            return .0;
+        }
+        auto const m{mean()};
+        double     sq{.0};
+        std::for_each(m_samples.cbegin(), m_samples.cend(), [&](double s_) { sq += (s_ - m) * (s_ - m); });
+        return std::sqrt(sq / static_cast<double>(m_samples.size() - 1));
+    }
+
+    auto
+    min() const -> double {
+        return m_samples.empty() ? .0 : *std::min_element(m_samples.cbegin(), m_samples.cend());
+    }
+
+    auto
+    max() const -> double {
+        return m_samples.empty() ? .0 : *std::max_element(m_samples.cbegin(), m_samples.cend());
+    }
+
+private:
+    std::vector<double> m_samples;
+    std::size_t         m_iterations{0};
+};
 }  // namespace test
 }  // namespace intern
 }  // namespace tpp
@@ -20,13 +20,14 @@
 #ifndef TPP_TEST_STREAMBUF_PROXY_HPP
 #define TPP_TEST_STREAMBUF_PROXY_HPP
 
+#include <cstddef>
+#include <iostream>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <sstream>
 #include <streambuf>
-#include <vector>
-
-#include "omp.hpp"
+#include <string>
 
 namespace tpp
 {
@@ -34,6 +35,13 @@ namespace intern
 {
 namespace test
 {
+/// Buffers holding the captured output of the testcase, that is currently executed by a thread.
+struct capture_buffers final
+{
+    std::stringbuf out;
+    std::stringbuf err;
+};
+
 class streambuf_proxy : public std::streambuf
 {
 public:
@@ -44,99 +52,129 @@ public:
     auto
     operator=(streambuf_proxy&&) noexcept -> streambuf_proxy& = delete;
 
-    explicit streambuf_proxy(std::ostream& stream_) : m_orig_buf(stream_.rdbuf(this)), m_orig_stream(stream_) {}
+    streambuf_proxy(std::ostream& stream_, std::stringbuf capture_buffers::*buf_)
+        : m_orig_buf(stream_.rdbuf(this)), m_orig_stream(stream_), m_buf(buf_) {}
 
     ~streambuf_proxy() noexcept override {
         m_orig_stream.flush();
         m_orig_stream.rdbuf(m_orig_buf);
     }
 
-    virtual auto
-    str() -> std::string = 0;
-
-protected:
-    template<typename T>
-    class clearer
-    {
-        T* m_buf;
+    /// Get the capture buffers of the calling thread, or nullptr if it does not capture anything.
+    static auto
+    current() -> capture_buffers*& {
+        static thread_local capture_buffers* bufs{nullptr};
+        return bufs;
+    }
 
-    public:
-        clearer(clearer const&)     = delete;
-        clearer(clearer&&) noexcept = delete;
-        auto
-        operator=(clearer const&) -> clearer& = delete;
-        auto
-        operator=(clearer&&) noexcept -> clearer& = delete;
+private:
+    auto
+    overflow(int_type c_) -> int_type override {
+        if (traits_type::eq_int_type(c_, traits_type::eof())) {
+            return traits_type::not_eof(c_);
+        }
+        auto const ch{traits_type::to_char_type(c_)};
+        auto*      bufs{current()};
+        return bufs ? (bufs->*m_buf).sputc(ch) : m_orig_buf->sputc(ch);
+    }
 
-        explicit clearer(T* b_) : m_buf(b_) {}
+    auto
+    xsputn(char const* s_, std::streamsize n_) -> std::streamsize override {
+        auto* bufs{current()};
+        return bufs ? (bufs->*m_buf).sputn(s_, n_) : m_orig_buf->sputn(s_, n_);
+    }
 
-        ~clearer() noexcept {
-            m_buf->str("");
-        }
-    };
+    auto
+    sync() -> int override {
+        return current() ? 0 : m_orig_buf->pubsync();
+    }
 
     std::streambuf* m_orig_buf;
     std::ostream&   m_orig_stream;
+    std::stringbuf capture_buffers::*m_buf;
 };
 
-class streambuf_proxy_single : public streambuf_proxy
+/**
+ * Redirects stdout and stderr into thread specific buffers, as long as any instance is alive.
+ * The proxies are installed by the first, and removed by the last instance, hence this can be nested and shared across
+ * threads. Threads that do not capture at the moment write through to the original streams.
+ */
+class output_capture final
 {
 public:
-    explicit streambuf_proxy_single(std::ostream& stream_) : streambuf_proxy(stream_) {}
-
+    output_capture(output_capture const&)     = delete;
+    output_capture(output_capture&&) noexcept = delete;
     auto
-    str() -> std::string override {
-        clearer<std::stringbuf> _(&m_buffer);
-        m_orig_stream.flush();
-        return m_buffer.str();
-    }
-
-private:
+    operator=(output_capture const&) -> output_capture& = delete;
     auto
-    overflow(int_type c_) -> int_type override {
-        std::lock_guard<std::mutex> lk(m_mutex);
-        return m_buffer.sputc(std::stringbuf::traits_type::to_char_type(c_));
+    operator=(output_capture&&) noexcept -> output_capture& = delete;
+
+    output_capture() {
+        auto&                       s{state()};
+        std::lock_guard<std::mutex> lk(s.mutex);
+        if (s.refs++ == 0) {
+            s.cout.reset(new streambuf_proxy(std::cout, &capture_buffers::out));
+            s.cerr.reset(new streambuf_proxy(std::cerr, &capture_buffers::err));
+        }
     }
 
-    auto
-    xsputn(char const* s_, std::streamsize n_) -> std::streamsize override {
-        std::lock_guard<std::mutex> lk(m_mutex);
-        return m_buffer.sputn(s_, n_);
+    ~output_capture() noexcept {
+        auto&                       s{state()};
+        std::lock_guard<std::mutex> lk(s.mutex);
+        if (--s.refs == 0) {
+            s.cout.reset();
+            s.cerr.reset();
+        }
     }
 
-    std::stringbuf m_buffer;
-    std::mutex mutable m_mutex;
+private:
+    struct shared_state
+    {
+        std::mutex                       mutex;
+        std::size_t                      refs{0};
+        std::unique_ptr<streambuf_proxy> cout;
+        std::unique_ptr<streambuf_proxy> cerr;
+    };
+
+    static auto
+    state() -> shared_state& {
+        static shared_state s;
+        return s;
+    }
 };
 
-class streambuf_proxy_omp : public streambuf_proxy
+/// Captures the output of the calling thread into own buffers, as long as it is alive.
+class capture_scope final
 {
-#define TPP_INTERN_CURRENT_THREAD_BUFFER() (m_thd_buffers[static_cast<std::size_t>(omp_get_thread_num())])
-
 public:
-    explicit streambuf_proxy_omp(std::ostream& stream_)
-        : streambuf_proxy(stream_), m_thd_buffers(static_cast<std::size_t>(omp_get_max_threads())) {}
-
+    capture_scope(capture_scope const&)     = delete;
+    capture_scope(capture_scope&&) noexcept = delete;
+    auto
+    operator=(capture_scope const&) -> capture_scope& = delete;
     auto
-    str() -> std::string override {
-        auto&                   buf = TPP_INTERN_CURRENT_THREAD_BUFFER();
-        clearer<std::stringbuf> _(&buf);
-        return buf.str();
+    operator=(capture_scope&&) noexcept -> capture_scope& = delete;
+
+    capture_scope() : m_prev(streambuf_proxy::current()) {
+        streambuf_proxy::current() = &m_bufs;
     }
 
-private:
-    auto
-    overflow(int_type c_) -> int_type override {
-        return TPP_INTERN_CURRENT_THREAD_BUFFER().sputc(std::stringbuf::traits_type::to_char_type(c_));
+    ~capture_scope() noexcept {
+        streambuf_proxy::current() = m_prev;
     }
 
-    auto
-    xsputn(char const* s_, std::streamsize n_) -> std::streamsize override {
-        return TPP_INTERN_CURRENT_THREAD_BUFFER().sputn(s_, n_);
+    inline auto
+    out() const -> std::string {
+        return m_bufs.out.str();
     }
 
-    std::vector<std::stringbuf> m_thd_buffers;
+    inline auto
+    err() const -> std::string {
+        return m_bufs.err.str();
+    }
 
-#undef TPP_INTERN_CURRENT_THREAD_BUFFER
+private:
+    capture_buffers  m_bufs;
+    capture_buffers* m_prev;
 };
 }  // namespace test
 }  // namespace intern
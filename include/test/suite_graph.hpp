@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_SUITE_GRAPH_HPP
+#define TPP_TEST_SUITE_GRAPH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test/testsuite.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * The dependencies between testsuites, as declared by depends_on. Dependencies on testsuites, which are not part of
+ * the run, are ignored.
+ */
+class suite_graph
+{
+public:
+    using time_function = std::function<double(testsuite const&)>;
+
+    /// Build the graph, and throw if the dependencies contain a cycle. Unknown times are taken as 1ms.
+    suite_graph(std::vector<testsuite_ptr> const& suites_, time_function const& time_fn_)
+        : m_deps(suites_.size()), m_dependents(suites_.size()), m_prio(suites_.size(), .0) {
+        std::multimap<std::string, std::size_t> by_name;
+        for (std::size_t i{0}; i < suites_.size(); ++i) {
+            by_name.emplace(suites_[i]->name(), i);
+        }
+        for (std::size_t i{0}; i < suites_.size(); ++i) {
+            auto const& deps{suites_[i]->dependencies()};
+            std::for_each(deps.cbegin(), deps.cend(), [&](char const* d_) {
+                auto const range{by_name.equal_range(d_)};
+                for (auto it{range.first}; it != range.second; ++it) {
+                    m_deps[i].push_back(it->second);
+                    m_dependents[it->second].push_back(i);
+                }
+            });
+        }
+        sort();
+        if (m_order.size() != suites_.size()) {
+            throw std::runtime_error("dependencies of testsuites contain a cycle");
+        }
+        for (auto it{m_order.crbegin()}; it != m_order.crend(); ++it) {
+            auto const t{time_fn_(*suites_[*it])};
+            double     longest{.0};
+            std::for_each(m_dependents[*it].cbegin(), m_dependents[*it].cend(),
+                          [&](std::size_t d_) { longest = std::max(longest, m_prio[d_]); });
+            m_prio[*it] = (std::isinf(t) ? 1.0 : t) + longest;
+        }
+    }
+
+    /// Check whether no testsuite depends on another.
+    inline auto
+    empty() const -> bool {
+        return std::all_of(m_deps.cbegin(), m_deps.cend(),
+                           [](std::vector<std::size_t> const& d_) { return d_.empty(); });
+    }
+
+    /// Get an order of all testsuites, where every testsuite follows its dependencies, but is otherwise kept in place.
+    inline auto
+    order() const -> std::vector<std::size_t> const& {
+        return m_order;
+    }
+
+    inline auto
+    dependencies(std::size_t i_) const -> std::vector<std::size_t> const& {
+        return m_deps[i_];
+    }
+
+    inline auto
+    dependents(std::size_t i_) const -> std::vector<std::size_t> const& {
+        return m_dependents[i_];
+    }
+
+    /// Get the time of the longest path from a testsuite through its dependents, which is the critical path.
+    inline auto
+    priority(std::size_t i_) const -> double {
+        return m_prio[i_];
+    }
+
+private:
+    /// Sort topologically, always taking the first ready testsuite.
+    void
+    sort() {
+        std::vector<std::size_t> pending(m_deps.size());
+        std::vector<std::size_t> ready;
+        for (std::size_t i{0}; i < m_deps.size(); ++i) {
+            pending[i] = m_deps[i].size();
+            if (pending[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+        auto const later{[](std::size_t l_, std::size_t r_) { return l_ > r_; }};
+        std::make_heap(ready.begin(), ready.end(), later);
+        while (!ready.empty()) {
+            std::pop_heap(ready.begin(), ready.end(), later);
+            auto const i{ready.back()};
+            ready.pop_back();
+            m_order.push_back(i);
+            std::for_each(m_dependents[i].cbegin(), m_dependents[i].cend(), [&](std::size_t d_) {
+                if (--pending[d_] == 0) {
+                    ready.push_back(d_);
+                    std::push_heap(ready.begin(), ready.end(), later);
+                }
+            });
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> m_deps;
+    std::vector<std::vector<std::size_t>> m_dependents;
+    std::vector<double>                   m_prio;
+    std::vector<std::size_t>              m_order;
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_SUITE_GRAPH_HPP
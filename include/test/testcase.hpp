@@ -23,6 +23,9 @@
 #include <utility>
 
 #include "assert/assertion_failure.hpp"
+#include "test/attributes.hpp"
+#include "test/benchmark.hpp"
+#include "test/statistic.hpp"
 
 #include "duration.hpp"
 
@@ -48,24 +51,34 @@ public:
     auto
     operator=(testcase const&) -> testcase& = delete;
 
-    testcase(test_context&& ctx_, test_function&& fn_)
-        : m_name(ctx_.tc_name), m_suite_name(ctx_.ts_name), m_test_fn(std::move(fn_)) {}
+    testcase(test_context&& ctx_, test_function&& fn_, test_attributes const& attrs_ = test_attributes())
+        : m_name(ctx_.tc_name), m_suite_name(ctx_.ts_name), m_attrs(attrs_), m_test_fn(std::move(fn_)) {}
 
     testcase(testcase&& other_) noexcept
         : m_name(other_.m_name),
           m_suite_name(other_.m_suite_name),
+          m_attrs(std::move(other_.m_attrs)),
           m_result(other_.m_result),
           m_elapsed_t(other_.m_elapsed_t),
           m_err_msg(std::move(other_.m_err_msg)),
+          m_cout(std::move(other_.m_cout)),
+          m_cerr(std::move(other_.m_cerr)),
+          m_reps(std::move(other_.m_reps)),
+          m_bench(std::move(other_.m_bench)),
           m_test_fn(std::move(other_.m_test_fn)) {}
 
     auto
     operator=(testcase&& other_) noexcept -> testcase& {
         m_name       = other_.m_name;
         m_suite_name = other_.m_suite_name;
+        m_attrs      = std::move(other_.m_attrs);
         m_result     = other_.m_result;
         m_elapsed_t  = other_.m_elapsed_t;
         m_err_msg    = std::move(other_.m_err_msg);
+        m_cout       = std::move(other_.m_cout);
+        m_cerr       = std::move(other_.m_cerr);
+        m_reps       = std::move(other_.m_reps);
+        m_bench      = std::move(other_.m_bench);
         m_test_fn    = std::move(other_.m_test_fn);
         return *this;
     }
@@ -85,7 +98,11 @@ public:
         }
         class duration dur;
         try {
-            m_test_fn();
+            if (m_attrs.benchmark) {
+                m_bench = benchmark::measure(m_test_fn);
+            } else {
+                m_test_fn();
+            }
             pass();
         } catch (assert::assertion_failure const& e) {
             fail(e.what());
@@ -102,6 +119,47 @@ public:
         return m_result;
     }
 
+    /// Take over the result of this testcase, as it was run elsewhere.
+    inline void
+    result(results res_, double elapsed_t_, std::string const& reason_) {
+        m_result    = res_;
+        m_elapsed_t = elapsed_t_;
+        m_err_msg   = reason_;
+    }
+
+    /// Forget the result of this testcase, so that it can be run again.
+    void
+    reset() {
+        m_result    = IS_UNDONE;
+        m_elapsed_t = .0;
+        m_err_msg.clear();
+        m_cout.clear();
+        m_cerr.clear();
+        m_bench = measurement();
+    }
+
+    /// Get the statistics of all runs, if this testcase was run repeatedly.
+    inline auto
+    repetitions() const -> repetition const& {
+        return m_reps;
+    }
+
+    inline void
+    repetitions(repetition&& reps_) {
+        m_reps = std::move(reps_);
+    }
+
+    /// Get the statistics of the measurement, if this testcase is a benchmark.
+    inline auto
+    measured() const -> measurement const& {
+        return m_bench;
+    }
+
+    inline void
+    measured(measurement&& bench_) {
+        m_bench = std::move(bench_);
+    }
+
     inline auto
     elapsed_time() const -> double {
         return m_elapsed_t;
@@ -122,6 +180,11 @@ public:
         return m_suite_name;
     }
 
+    inline auto
+    attributes() const -> test_attributes const& {
+        return m_attrs;
+    }
+
     inline void
     cout(std::string const& str_) {
         m_cout = str_;
@@ -160,14 +223,17 @@ private:
         m_err_msg = msg_;
     }
 
-    char const*   m_name;
-    char const*   m_suite_name;
-    results       m_result{IS_UNDONE};
-    double        m_elapsed_t{.0};
-    std::string   m_err_msg;
-    std::string   m_cout;
-    std::string   m_cerr;
-    test_function m_test_fn;
+    char const*     m_name;
+    char const*     m_suite_name;
+    test_attributes m_attrs;
+    results         m_result{IS_UNDONE};
+    double          m_elapsed_t{.0};
+    std::string     m_err_msg;
+    std::string     m_cout;
+    std::string     m_cerr;
+    repetition      m_reps;
+    measurement     m_bench;
+    test_function   m_test_fn;
 };
 }  // namespace test
 }  // namespace intern
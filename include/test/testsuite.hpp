@@ -20,12 +20,26 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "exec/executor.hpp"
+#include "exec/thread_pool.hpp"
+#include "test/attributes.hpp"
+#include "test/baseline.hpp"
+#include "test/cancellation.hpp"
+#include "test/fixture.hpp"
+#include "test/isolation.hpp"
+#include "test/resources.hpp"
 #include "test/statistic.hpp"
 #include "test/streambuf_proxy.hpp"
 #include "test/testcase.hpp"
@@ -36,13 +50,6 @@ namespace intern
 {
 namespace test
 {
-template<typename T>
-struct streambuf_proxies
-{
-    T cout{std::cout};
-    T cerr{std::cerr};
-};
-
 class testsuite;
 using testsuite_ptr = std::shared_ptr<testsuite>;
 
@@ -55,6 +62,7 @@ protected:
 
 public:
     using hook_function = std::function<void()>;
+    using done_function = std::function<void(std::size_t)>;
 
     testsuite(testsuite const&)     = delete;
     testsuite(testsuite&&) noexcept = delete;
@@ -69,39 +77,263 @@ public:
         return std::make_shared<testsuite>(enable{}, name_);
     }
 
-    virtual void
+    /// Run all undone testcases with the shared thread pool.
+    void
     run() {
+        run(exec::thread_pool::shared());
+    }
+
+    /**
+     * Run all undone testcases in order. Adjacent testcases, that are parallel safe, are run concurrently by the given
+     * executor.
+     */
+    virtual void
+    run(exec::executor& exec_) {
         if (m_state != IS_DONE) {
             duration d;
+            prepare();
             m_stats.m_num_tests = m_testcases.size();
-            streambuf_proxies<streambuf_proxy_single> bufs;
-            m_setup_fn();
-            std::for_each(m_testcases.begin(), m_testcases.end(), [&](testcase& tc_) {
-                if (tc_.result() == testcase::IS_UNDONE) {
-                    m_pretest_fn();
-                    tc_();
-                    switch (tc_.result()) {
-                        case testcase::HAS_FAILED: ++m_stats.m_num_fails; break;
-                        case testcase::HAD_ERROR: ++m_stats.m_num_errs; break;
-                        default: break;
+            if (!cancelled()) {
+                output_capture       cap;
+                test::fixture::scope fix(m_fixture.get(), 1);
+                m_setup_fn();
+                std::size_t i{0};
+                while (i < m_testcases.size()) {
+                    auto const n{parallel_safe(i)};
+                    if (n > 1) {
+                        std::vector<std::size_t> batch(n);
+                        std::iota(batch.begin(), batch.end(), i);
+                        auto const        tasks{chains(batch)};
+                        std::vector<char> ran(n, 0);
+                        exec_.parallel_for(tasks.size(), [&](std::size_t t_, std::size_t) {
+                            std::for_each(tasks[t_].cbegin(), tasks[t_].cend(),
+                                          [&](std::size_t idx_) { ran[idx_ - i] = run_undone(idx_); });
+                        });
+                        for (std::size_t j{0}; j < n; ++j) {
+                            if (ran[j]) {
+                                count(m_testcases[i + j]);
+                            }
+                        }
+                    } else if (run_undone(i)) {
+                        count(m_testcases[i]);
                     }
-                    m_posttest_fn();
-                    tc_.cout(bufs.cout.str());
-                    tc_.cerr(bufs.cerr.str());
+                    i += n;
                 }
-            });
-            m_teardown_fn();
+                m_teardown_fn();
+                fix.release();
+            }
+            count_skips();
             m_state = IS_DONE;
             m_stats.m_elapsed_t += d.get();
         }
     }
 
+    /// Testcases of a testsuite, that may run apart from all others, e.g. in another process. See parts().
+    struct part
+    {
+        std::vector<std::size_t> tests;
+        bool                     last;  ///< Runs only after all other parts are done.
+    };
+
+    /// Check whether testcases of this testsuite run concurrently to each other.
+    virtual auto
+    parallel() const -> bool {
+        return false;
+    }
+
+    /**
+     * Split all undone testcases into parts, that may run concurrently in different processes. Testcases of a
+     * sequential testsuite may depend on each other, so they form a single part.
+     */
+    virtual auto
+    parts() const -> std::vector<part> {
+        part p{{}, false};
+        for (std::size_t i{0}; i < m_testcases.size(); ++i) {
+            if (m_testcases[i].result() == testcase::IS_UNDONE) {
+                p.tests.push_back(i);
+            }
+        }
+        return p.tests.empty() ? std::vector<part>() : std::vector<part>{std::move(p)};
+    }
+
+    /**
+     * Run the testcases at idxs_ one after another, and call fn_ with every index, after it was run. This is how
+     * workers run the parts of a testsuite, that they were given. SETUP runs before the first part, and TEARDOWN only
+     * by finish_parts(). Exceptions from hooks are thrown.
+     */
+    template<typename Fn>
+    void
+    run_part(std::vector<std::size_t> const& idxs_, Fn&& fn_) {
+        prepare();
+        if (!m_session) {
+            std::unique_ptr<test::fixture::scope> fix(new test::fixture::scope(m_fixture.get(), 1));
+            m_setup_fn();
+            m_session = std::move(fix);
+        }
+        std::for_each(idxs_.cbegin(), idxs_.cend(), [&](std::size_t i_) {
+            run_undone(i_);
+            fn_(i_);
+        });
+    }
+
+    /// Run TEARDOWN after all parts, that were given to a worker, are done.
+    void
+    finish_parts() {
+        if (m_session) {
+            std::unique_ptr<test::fixture::scope> fix(std::move(m_session));
+            m_teardown_fn();
+            fix->release();
+        }
+    }
+
+    /**
+     * Take over the outcome of the testcase at i_, after it was run elsewhere. It is set by fn_, which is called with
+     * the testcase. Benchmarks are compared to the baseline, and faults count at the cancellation as usual.
+     */
+    template<typename Fn>
+    void
+    complete(std::size_t i_, Fn&& fn_) {
+        auto& tc{m_testcases[i_]};
+        fn_(tc);
+        if (m_baseline) {
+            m_baseline->compare(tc);
+        }
+        count(tc);
+        if (m_cancel && failed(tc)) {
+            m_cancel->fault();
+        }
+        notify_done(i_);
+    }
+
+    /// Mark this testsuite as done, after its testcases were run elsewhere within elapsed_ milliseconds.
+    void
+    finish(double elapsed_) {
+        if (m_state != IS_DONE) {
+            m_stats.m_num_tests = m_testcases.size();
+            count_skips();
+            m_state = IS_DONE;
+            m_stats.m_elapsed_t += elapsed_;
+        }
+    }
+
     void
     test(char const* name_, hook_function&& fn_) {
         m_testcases.emplace_back(test_context{name_, m_name}, std::move(fn_));
         m_state = IS_PENDING;
     }
 
+    void
+    test(test_spec&& spec_, hook_function&& fn_) {
+        m_testcases.emplace_back(test_context{spec_.name, m_name}, std::move(fn_), spec_.attrs);
+        m_state = IS_PENDING;
+    }
+
+    /**
+     * Set the order, in which testcases are started, as indices into testcases().
+     * This is only respected by testsuites that run testcases concurrently. Reports keep the registration order.
+     */
+    void
+    schedule(std::vector<std::size_t>&& order_) {
+        m_order = std::move(order_);
+    }
+
+    /// Remove all testcases, that do not satisfy pred_. They are neither run, nor reported.
+    template<typename Fn>
+    void
+    select(Fn&& pred_) {
+        m_testcases.erase(std::remove_if(m_testcases.begin(), m_testcases.end(),
+                                         [&](testcase const& tc_) { return !pred_(tc_); }),
+                          m_testcases.end());
+        m_order.clear();
+    }
+
+    /// Remove all testcases, whose index is not set in keep_. They are neither run, nor reported.
+    void
+    keep(std::vector<char> const& keep_) {
+        std::vector<testcase> kept;
+        for (std::size_t i{0}; i < m_testcases.size() && i < keep_.size(); ++i) {
+            if (keep_[i] != 0) {
+                kept.push_back(std::move(m_testcases[i]));
+            }
+        }
+        m_testcases.swap(kept);
+        m_order.clear();
+    }
+
+    /// Run every testcase, including the hooks around it, in a child process. See process_isolation.
+    void
+    isolate() {
+        m_isolated = true;
+    }
+
+    /// Stop starting testcases, as soon as c_ is cancelled. Testcases count their faults at c_.
+    void
+    cancel_by(cancellation_ptr const& c_) {
+        m_cancel = c_;
+    }
+
+    /**
+     * Set the timeout in milliseconds for all testcases, that do not have their own.
+     * It is only enforced for isolated testcases. Others are checked after they are done.
+     */
+    void
+    timeout(double ms_) {
+        m_timeout = ms_;
+    }
+
+    /**
+     * Run every testcase n_ times, but stop after its first failed run if until_fail_ is set. Repeated testcases report
+     * the first failed run, or the last one, with the time of all runs.
+     */
+    void
+    repeat(std::size_t n_, bool until_fail_) {
+        m_repeat     = n_;
+        m_until_fail = until_fail_;
+    }
+
+    /// Let this testsuite run only after all testsuites named name_ passed.
+    void
+    depends_on(char const* name_) {
+        m_depends.push_back(name_);
+    }
+
+    /**
+     * Skip all undone testcases without running them, because a testsuite, that this one depends on, did not pass.
+     * They are reported as skipped.
+     */
+    void
+    skip() {
+        if (m_state != IS_DONE) {
+            m_stats.m_num_tests = m_testcases.size();
+            count_skips();
+            m_state = IS_DONE;
+        }
+    }
+
+    /// Fail benchmarks, that regressed against b_, as soon as they are done.
+    void
+    compare_by(baseline_ptr const& b_) {
+        m_baseline = b_;
+    }
+
+    /// Limit testcases, that hold resources, by r_. Otherwise the limits only apply within this testsuite.
+    void
+    limit_by(resources_ptr const& r_) {
+        m_resources = r_;
+    }
+
+    /// Call fn_ with the index of every testcase, as soon as it was run, from the thread that ran it.
+    void
+    on_done(done_function&& fn_) {
+        m_done_fn = std::move(fn_);
+    }
+
+    /// Set the object, that testcases and hooks of this testsuite run on. It exists only while this testsuite is run.
+    void
+    fixture(fixture_ptr&& fix_) {
+        m_fixture = std::move(fix_);
+    }
+
     void
     setup(hook_function&& fn_) {
         m_setup_fn.fn = std::move(fn_);
@@ -142,6 +374,12 @@ public:
         return m_testcases;
     }
 
+    /// Get the names of all testsuites, that must pass before this one runs.
+    inline auto
+    dependencies() const -> std::vector<char const*> const& {
+        return m_depends;
+    }
+
     testsuite(enable, char const* name_) : m_name(name_), m_create_time(std::chrono::system_clock::now()) {}
 
 protected:
@@ -157,6 +395,208 @@ protected:
         hook_function fn;
     };
 
+    /// Run a single testcase as often as set by repeat(), and count a fault at the cancellation if it failed.
+    void
+    run_testcase(testcase& tc_) {
+        resources::hold res(m_resources.get(), tc_.attributes().resources, tc_.attributes().benchmark);
+        run_once(tc_);
+        if (m_repeat > 1) {
+            run_repeated(tc_);
+        }
+        if (m_baseline) {
+            m_baseline->compare(tc_);
+        }
+        if (m_cancel && failed(tc_)) {
+            m_cancel->fault();
+        }
+    }
+
+    /// Run a testcase again, after it was run once, and record the statistics of all runs.
+    void
+    run_repeated(testcase& tc_) {
+        struct outcome
+        {
+            testcase::results result;
+            std::string       reason;
+            std::string       out;
+            std::string       err;
+        } kept{tc_.result(), tc_.reason(), tc_.cout(), tc_.cerr()};
+        repetition reps;
+        double     total{tc_.elapsed_time()};
+        reps.add(tc_.elapsed_time(), failed(tc_));
+        while (reps.runs() < m_repeat && !(m_until_fail && reps.failures() > 0) && !cancelled()) {
+            tc_.reset();
+            run_once(tc_);
+            total += tc_.elapsed_time();
+            reps.add(tc_.elapsed_time(), failed(tc_));
+            if (reps.failures() == 0 || (failed(tc_) && reps.failures() == 1)) {
+                kept = outcome{tc_.result(), tc_.reason(), tc_.cout(), tc_.cerr()};
+            }
+        }
+        tc_.result(kept.result, total, kept.reason);
+        tc_.cout(kept.out);
+        tc_.cerr(kept.err);
+        tc_.repetitions(std::move(reps));
+    }
+
+    /**
+     * Run a single testcase including the hooks around it, while capturing its output. A timeout is only enforced in a
+     * child process, which is killed with its stack reported. Otherwise the time is checked after the testcase is done.
+     */
+    void
+    run_once(testcase& tc_) {
+        auto const timeout{tc_.attributes().timeout > .0 ? tc_.attributes().timeout : m_timeout};
+        if (m_isolated || (tc_.attributes().isolated && process_isolation::SUPPORTED)) {
+            process_isolation::run(tc_, [&] { run_captured(tc_); }, timeout);
+        } else {
+            run_captured(tc_);
+            if (timeout > .0 && tc_.elapsed_time() > timeout) {
+                std::ostringstream msg;
+                msg << "timed out after " << timeout << "ms";
+                tc_.result(testcase::HAD_ERROR, tc_.elapsed_time(), msg.str());
+            }
+        }
+    }
+
+    /// Run the testcase at i_, if it is undone and the run is not cancelled. Return whether it was run.
+    auto
+    run_undone(std::size_t i_) -> bool {
+        auto& tc{m_testcases[i_]};
+        if (tc.result() == testcase::IS_UNDONE && !cancelled()) {
+            run_testcase(tc);
+            notify_done(i_);
+            return true;
+        }
+        return false;
+    }
+
+    void
+    prepare() {
+        if (!m_resources) {
+            m_resources = std::make_shared<resources>();
+            std::for_each(m_testcases.cbegin(), m_testcases.cend(),
+                          [&](testcase const& tc_) { m_resources->declare(tc_.attributes().resources); });
+        }
+    }
+
+    /**
+     * Split the testcases at idxs_ into chains, which run their testcases one after another. Testcases, that hold the
+     * same resources, are spread over as many chains, as may hold them at the same time, so that they do not block
+     * workers by waiting for each other. All other testcases get a chain of their own.
+     * The testcases at serial_ form a chain, that runs alongside, so it takes one of the chains of every resource, that
+     * any of them holds.
+     */
+    auto
+    chains(std::vector<std::size_t> const& idxs_, std::vector<std::size_t> const& serial_ = {}) const
+        -> std::vector<std::vector<std::size_t>> {
+        struct lanes
+        {
+            std::size_t first;
+            std::size_t count;
+            std::size_t next;
+        };
+        std::vector<std::vector<std::size_t>> result;
+        std::map<std::string, lanes>          shared;
+        std::set<std::string>                 taken;
+        std::for_each(serial_.cbegin(), serial_.cend(), [&](std::size_t idx_) {
+            auto const& res{m_testcases[idx_].attributes().resources};
+            std::for_each(res.cbegin(), res.cend(), [&](resource const& r_) { taken.insert(r_.name); });
+        });
+        std::vector<std::size_t> chained(serial_);
+        if (!chained.empty()) {
+            result.push_back(std::move(chained));
+        }
+        std::for_each(idxs_.cbegin(), idxs_.cend(), [&](std::size_t idx_) {
+            auto const res{resources::unique(m_testcases[idx_].attributes().resources)};
+            if (res.empty()) {
+                result.push_back({idx_});
+                return;
+            }
+            std::vector<std::string> names;
+            std::size_t              limit{res.front().limit};
+            bool                     busy{false};
+            std::for_each(res.cbegin(), res.cend(), [&](resource const& r_) {
+                names.emplace_back(r_.name);
+                limit = std::min(limit, r_.limit);
+                busy  = busy || taken.count(r_.name) > 0;
+            });
+            if (busy && limit > 1) {
+                --limit;
+            }
+            std::sort(names.begin(), names.end());
+            std::string key;
+            std::for_each(names.cbegin(), names.cend(), [&](std::string const& n_) { key.append(n_).push_back('\0'); });
+            auto l{shared.find(key)};
+            if (l == shared.end()) {
+                l = shared.emplace(key, lanes{result.size(), limit, 0}).first;
+                result.resize(result.size() + limit);
+            }
+            result[l->second.first + l->second.next].push_back(idx_);
+            l->second.next = (l->second.next + 1) % l->second.count;
+        });
+        result.erase(std::remove_if(result.begin(), result.end(),
+                                    [](std::vector<std::size_t> const& c_) { return c_.empty(); }),
+                     result.end());
+        return result;
+    }
+
+    /// Get the number of adjacent parallel safe testcases, starting at i_, but at least 1.
+    auto
+    parallel_safe(std::size_t i_) const -> std::size_t {
+        std::size_t n{0};
+        while (i_ + n < m_testcases.size() && m_testcases[i_ + n].attributes().mode == concurrency::PARALLEL) {
+            ++n;
+        }
+        return std::max<std::size_t>(n, 1);
+    }
+
+    void
+    count(testcase const& tc_) {
+        switch (tc_.result()) {
+            case testcase::HAS_FAILED: ++m_stats.m_num_fails; break;
+            case testcase::HAD_ERROR: ++m_stats.m_num_errs; break;
+            default: break;
+        }
+    }
+
+    static inline auto
+    failed(testcase const& tc_) -> bool {
+        return tc_.result() == testcase::HAS_FAILED || tc_.result() == testcase::HAD_ERROR;
+    }
+
+    void
+    run_captured(testcase& tc_) {
+        cancellation::scope           cs(m_cancel.get());
+        capture_scope                 cap;
+        test::fixture::testcase_scope fix(m_fixture.get());
+        m_pretest_fn();
+        tc_();
+        m_posttest_fn();
+        fix.release();
+        tc_.cout(cap.out());
+        tc_.cerr(cap.err());
+    }
+
+    inline void
+    notify_done(std::size_t i_) const {
+        if (m_done_fn) {
+            m_done_fn(i_);
+        }
+    }
+
+    inline auto
+    cancelled() const -> bool {
+        return m_cancel && m_cancel->cancelled();
+    }
+
+    /// Count all testcases, that were not run, as skipped.
+    void
+    count_skips() {
+        m_stats.m_num_skips = static_cast<std::size_t>(
+            std::count_if(m_testcases.cbegin(), m_testcases.cend(),
+                          [](testcase const& tc_) { return tc_.result() == testcase::IS_UNDONE; }));
+    }
+
     enum states
     {
         IS_PENDING,
@@ -166,9 +606,22 @@ protected:
     char const* const                           m_name;
     std::chrono::system_clock::time_point const m_create_time;
 
-    statistic             m_stats;
-    std::vector<testcase> m_testcases;
-    states                m_state{IS_PENDING};
+    statistic                m_stats;
+    std::vector<testcase>    m_testcases;
+    std::vector<std::size_t> m_order;
+    std::vector<char const*> m_depends;
+    states                   m_state{IS_PENDING};
+    bool                     m_isolated{false};
+    double                   m_timeout{.0};
+    std::size_t              m_repeat{1};
+    bool                     m_until_fail{false};
+    cancellation_ptr         m_cancel;
+    resources_ptr            m_resources;
+    baseline_ptr             m_baseline;
+    done_function            m_done_fn;
+    fixture_ptr              m_fixture;
+
+    std::unique_ptr<test::fixture::scope> m_session;  ///< Holds the instances, while parts are run by a worker.
 
     optional_functor m_setup_fn;
     optional_functor m_teardown_fn;
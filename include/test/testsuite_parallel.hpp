@@ -18,10 +18,12 @@
 #ifndef TPP_TEST_TESTSUITE_PARALLEL_HPP
 #define TPP_TEST_TESTSUITE_PARALLEL_HPP
 
-#include <cstdint>
-#include <limits>
-#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
 
+#include "exec/executor.hpp"
 #include "test/testsuite.hpp"
 
 namespace tpp
@@ -38,51 +40,141 @@ public:
         return std::make_shared<testsuite_parallel>(enable{}, name_);
     }
 
+    using testsuite::run;
+
+    /**
+     * Run all undone testcases concurrently by the given executor. Serial testcases run one after another, but
+     * concurrently to the others. Exclusive testcases run one after another, after all others are done. Testcases,
+     * that hold resources, are chained as described by chains(), including the chain of serial testcases.
+     */
     void
-    run() override {
+    run(exec::executor& exec_) override {
         if (m_state != IS_DONE) {
             duration d;
-            if (m_testcases.size() > static_cast<std::size_t>(std::numeric_limits<std::int64_t>::max())) {
-                throw std::overflow_error("Too many testcases! Size would overflow loop variant.");
-            }
-            auto const tc_size{static_cast<std::int64_t>(m_testcases.size())};
+            prepare();
             m_stats.m_num_tests = m_testcases.size();
-            streambuf_proxies<streambuf_proxy_omp> bufs;
-            m_setup_fn();
-#pragma omp parallel default(shared)
-            {  // BEGIN parallel section
-                std::size_t fails{0};
-                std::size_t errs{0};
-                // OpenMP 2 compatible - MSVC not supporting higher version
-#pragma omp for schedule(dynamic)
-                for (std::int64_t i = 0; i < tc_size; ++i) {
-                    auto& tc{m_testcases[static_cast<std::size_t>(i)]};
-                    if (tc.result() == testcase::IS_UNDONE) {
-                        m_pretest_fn();
-                        tc();
+            if (m_order.size() != m_testcases.size()) {
+                m_order.resize(m_testcases.size());
+                std::iota(m_order.begin(), m_order.end(), 0);
+            }
+            if (!cancelled()) {
+                std::vector<worker_stats> stats(exec_.concurrency());
+                output_capture            cap;
+                test::fixture::scope      fix(m_fixture.get(), exec_.concurrency());
+                m_setup_fn();
+                auto const run_one{[&](std::size_t idx_, std::size_t w_) {
+                    auto& tc{m_testcases[idx_]};
+                    if (tc.result() == testcase::IS_UNDONE && !cancelled()) {
+                        test::fixture::worker_scope ws(m_fixture.get(), w_);
+                        run_testcase(tc);
                         switch (tc.result()) {
-                            case testcase::HAS_FAILED: ++fails; break;
-                            case testcase::HAD_ERROR: ++errs; break;
+                            case testcase::HAS_FAILED: ++stats[w_].fails; break;
+                            case testcase::HAD_ERROR: ++stats[w_].errs; break;
                             default: break;
                         }
-                        m_posttest_fn();
-                        tc.cout(bufs.cout.str());
-                        tc.cerr(bufs.cerr.str());
+                        notify_done(idx_);
                     }
+                }};
+                auto const run_all{[&](std::vector<std::size_t> const& idxs_, std::size_t w_) {
+                    std::for_each(idxs_.cbegin(), idxs_.cend(), [&](std::size_t idx_) { run_one(idx_, w_); });
+                }};
+                std::vector<std::size_t> shared;
+                std::vector<std::size_t> serial;
+                std::vector<std::size_t> exclusive;
+                std::for_each(m_order.cbegin(), m_order.cend(), [&](std::size_t idx_) {
+                    switch (m_testcases[idx_].attributes().mode) {
+                        case concurrency::SERIAL: serial.push_back(idx_); break;
+                        case concurrency::EXCLUSIVE: exclusive.push_back(idx_); break;
+                        default: shared.push_back(idx_); break;
+                    }
+                });
+                // Serial testcases run one after another in a single chain, which is started first.
+                auto const tasks{chains(shared, serial)};
+                exec_.parallel_for(tasks.size(), [&](std::size_t i_, std::size_t w_) { run_all(tasks[i_], w_); });
+                if (!exclusive.empty()) {
+                    exec_.parallel_for(1, [&](std::size_t, std::size_t w_) { run_all(exclusive, w_); });
                 }
-#pragma omp critical
-                {  // BEGIN critical section
-                    m_stats.m_num_fails += fails;
-                    m_stats.m_num_errs += errs;
-                }  // END critical section
-            }      // END parallel section
-            m_teardown_fn();
+                std::for_each(stats.cbegin(), stats.cend(), [&](worker_stats const& ws_) {
+                    m_stats.m_num_fails += ws_.fails;
+                    m_stats.m_num_errs += ws_.errs;
+                });
+                m_teardown_fn();
+                release_workers(exec_);
+                fix.release();
+            }
+            count_skips();
             m_state = IS_DONE;
             m_stats.m_elapsed_t += d.get();
         }
     }
 
+    auto
+    parallel() const -> bool override {
+        return true;
+    }
+
+    /**
+     * Every undone testcase is a part of its own, in the scheduled order. Serial testcases form a single part, and
+     * exclusive testcases one, that runs last.
+     */
+    auto
+    parts() const -> std::vector<part> override {
+        std::vector<std::size_t> order(m_order);
+        if (order.size() != m_testcases.size()) {
+            order.resize(m_testcases.size());
+            std::iota(order.begin(), order.end(), 0);
+        }
+        std::vector<part> result;
+        part              serial{{}, false};
+        part              exclusive{{}, true};
+        std::for_each(order.cbegin(), order.cend(), [&](std::size_t idx_) {
+            auto const& tc{m_testcases[idx_]};
+            if (tc.result() != testcase::IS_UNDONE) {
+                return;
+            }
+            switch (tc.attributes().mode) {
+                case concurrency::SERIAL: serial.tests.push_back(idx_); break;
+                case concurrency::EXCLUSIVE: exclusive.tests.push_back(idx_); break;
+                default: result.push_back(part{{idx_}, false}); break;
+            }
+        });
+        if (!serial.tests.empty()) {
+            result.insert(result.begin(), std::move(serial));
+        }
+        if (!exclusive.tests.empty()) {
+            result.push_back(std::move(exclusive));
+        }
+        return result;
+    }
+
     testsuite_parallel(enable e_, char const* name_) : testsuite(e_, name_) {}
+
+private:
+    /**
+     * Let every worker finalize and destroy its own instance, so that the thread teardown hook runs on the same thread
+     * as the thread setup hook.
+     */
+    void
+    release_workers(exec::executor& exec_) {
+        if (!m_fixture || m_fixture->workers() == 0) {
+            return;
+        }
+        std::vector<std::size_t> owners;
+        for (std::size_t w{0}; w < exec_.concurrency(); ++w) {
+            if (m_fixture->has_worker(w)) {
+                owners.push_back(w);
+            }
+        }
+        exec_.on_workers(owners, [&](std::size_t, std::size_t w_) { m_fixture->release(w_); });
+    }
+
+    /// Statistics counted by a single worker, padded to prevent false sharing between workers.
+    struct worker_stats
+    {
+        std::size_t fails{0};
+        std::size_t errs{0};
+        char        pad[exec::CACHE_LINE_SIZE - 2 * sizeof(std::size_t)];
+    };
 };
 }  // namespace test
 }  // namespace intern
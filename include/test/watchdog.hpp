@@ -0,0 +1,190 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_WATCHDOG_HPP
+#define TPP_TEST_WATCHDOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpp_meta.hpp"
+
+#ifdef TPP_INTERN_SYS_UNIX
+#    include <pthread.h>
+#endif
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * A single background thread, that executes actions when their deadline has passed.
+ * Actions are executed at most once, and never after their guard is destroyed. A forked child gets a watchdog of its
+ * own, as the thread does not exist there, its lock may be held, and the guards of other threads must not fire there.
+ */
+class watchdog
+{
+    using clock = std::chrono::steady_clock;
+
+public:
+    watchdog(watchdog const&)     = delete;
+    watchdog(watchdog&&) noexcept = delete;
+    ~watchdog() noexcept          = delete;
+    auto
+    operator=(watchdog const&) -> watchdog& = delete;
+    auto
+    operator=(watchdog&&) noexcept -> watchdog& = delete;
+
+    /// Registers fn_ to be executed by the watchdog, if the guard still exists after timeout_ milliseconds.
+    class guard final
+    {
+    public:
+        guard(double timeout_, std::function<void()>&& fn_)
+            : m_deadline(clock::now() + std::chrono::duration_cast<clock::duration>(
+                                            std::chrono::duration<double, std::milli>(timeout_))),
+              m_fn(std::move(fn_)) {
+            instance().add(this);
+        }
+
+        guard(guard const&)     = delete;
+        guard(guard&&) noexcept = delete;
+        ~guard() noexcept {
+            instance().remove(this);
+        }
+        auto
+        operator=(guard const&) -> guard& = delete;
+        auto
+        operator=(guard&&) noexcept -> guard& = delete;
+
+        inline auto
+        expired() const -> bool {
+            return m_expired.load();
+        }
+
+    private:
+        friend class watchdog;
+
+        clock::time_point const m_deadline;
+        std::function<void()>   m_fn;
+        std::atomic<bool>       m_expired{false};
+    };
+
+private:
+    watchdog() {
+        std::thread([this] { watch(); }).detach();
+    }
+
+    /**
+     * The watchdog is never destroyed, as its thread may still be waiting at exit, or does not exist in a forked child.
+     * It is created under a lock, that is held across fork(), so that a child never inherits a half created one.
+     */
+    static auto
+    instance() -> watchdog& {
+        std::lock_guard<std::mutex> lk(creation_mutex());
+        auto&                       w{current()};
+        if (!w) {
+#ifdef TPP_INTERN_SYS_UNIX
+            static bool registered{false};
+            if (!registered) {
+                ::pthread_atfork([] { creation_mutex().lock(); }, [] { creation_mutex().unlock(); },
+                                 [] {
+                                     current() = nullptr;
+                                     creation_mutex().unlock();
+                                 });
+                registered = true;
+            }
+#endif
+            w = new watchdog;
+        }
+        return *w;
+    }
+
+    /// Both are initialized constantly, so that no guard of a static initialization is inherited by a child.
+    static auto
+    current() -> watchdog*& {
+        static watchdog* w{nullptr};
+        return w;
+    }
+
+    static auto
+    creation_mutex() -> std::mutex& {
+        static std::mutex m;
+        return m;
+    }
+
+    void
+    add(guard* g_) {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_guards.push_back(g_);
+        }
+        m_cv.notify_one();
+    }
+
+    void
+    remove(guard* g_) {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        // A guard, that was created before fork(), is unknown to the watchdog of the child.
+        auto const it{std::find(m_guards.begin(), m_guards.end(), g_)};
+        if (it != m_guards.end()) {
+            m_guards.erase(it);
+        }
+    }
+
+    void
+    watch() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (;;) {
+            auto const now{clock::now()};
+            auto       next{clock::time_point::max()};
+            std::for_each(m_guards.begin(), m_guards.end(), [&](guard* g_) {
+                if (g_->expired()) {
+                    return;
+                }
+                if (g_->m_deadline <= now) {
+                    g_->m_expired = true;
+                    g_->m_fn();
+                } else {
+                    next = std::min(next, g_->m_deadline);
+                }
+            });
+            if (next == clock::time_point::max()) {
+                m_cv.wait(lk);
+            } else {
+                m_cv.wait_until(lk, next);
+            }
+        }
+    }
+
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    std::vector<guard*>     m_guards;
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_WATCHDOG_HPP
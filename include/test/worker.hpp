@@ -0,0 +1,245 @@
+/*
+    Copyright (C) 2017  Jarthianur
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TPP_TEST_WORKER_HPP
+#define TPP_TEST_WORKER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test/attributes.hpp"
+#include "test/channel.hpp"
+#include "test/streambuf_proxy.hpp"
+#include "test/testcase.hpp"
+#include "test/testsuite.hpp"
+
+#include "stringify.hpp"
+#include "version.hpp"
+
+namespace tpp
+{
+namespace intern
+{
+namespace test
+{
+/**
+ * Runs testcases of the testsuites in this process on behalf of a coordinator, that distributes them over several
+ * workers. Testsuites are known by their index, as instantiated by the same binary, and testcases by their name, and
+ * the occurrence of their name in the testsuite.
+ * The coordinator sends:
+ *   CONFIG <timeout> <repeat> <until fail> <isolated>
+ *   RUN <part> <testsuite> <name> {<testcase> <occurrence>}...
+ *   CLOSE <testsuite>
+ *   LIST
+ *   QUIT
+ * The worker sends:
+ *   HELLO <version>
+ *   RESULT <part> <n> <result> <time> <reason> <out> <err> <iterations> <samples> {<sample>}... <failures>
+ *          {<time>}...
+ *   DONE <part>
+ *   ERROR <part> <message>
+ *   CLOSED <testsuite> [<message>]
+ *   SUITE <name> <parallel> {<dependency>}...
+ *   TEST <name> <mode> <timeout> <number of tags> {<tag>}... {<resource> <limit>}...
+ *   END
+ * A RESULT is sent for the n-th testcase of a part, as soon as it was run, with the samples of its measurement, if it is
+ * a benchmark, and the times of all its repetitions.
+ * ERROR is sent instead of DONE, if a hook threw. All further parts of the testsuite fail the same way then. CLOSE runs
+ * TEARDOWN of a testsuite, as no more parts of it follow. LIST is answered by a SUITE for every testsuite, followed by
+ * a TEST for each of its testcases, and END, so that a coordinator can run testsuites, that it does not contain.
+ */
+class worker
+{
+public:
+    explicit worker(std::vector<testsuite_ptr> const& suites_) : m_suites(suites_), m_errors(suites_.size()) {}
+
+    /// Run testcases as requested through ch_, until the coordinator quits, or is gone.
+    void
+    serve(channel& ch_) {
+        output_capture cap;
+        ch_.send(message("HELLO") << TPP_VERSION);
+        message msg;
+        while (ch_.receive(msg) && msg.command() != "QUIT") {
+            if (msg.command() == "RUN") {
+                run(ch_, msg);
+            } else if (msg.command() == "CLOSE") {
+                close(ch_, msg.num<std::size_t>(0));
+            } else if (msg.command() == "CONFIG") {
+                configure(msg);
+            } else if (msg.command() == "LIST") {
+                list(ch_);
+            }
+        }
+    }
+
+    /// Create a RESULT message for the n_-th testcase of a part.
+    static auto
+    result(std::string const& part_, std::size_t n_, testcase const& tc_) -> message {
+        message msg("RESULT");
+        msg << part_ << n_ << static_cast<int>(tc_.result()) << tc_.elapsed_time() << tc_.reason() << tc_.cout()
+            << tc_.cerr();
+        auto const& samples{tc_.measured().samples()};
+        msg << tc_.measured().iterations() << samples.size();
+        std::for_each(samples.cbegin(), samples.cend(), [&](double s_) { msg << s_; });
+        msg << tc_.repetitions().failures();
+        auto const& times{tc_.repetitions().times()};
+        std::for_each(times.cbegin(), times.cend(), [&](double t_) { msg << t_; });
+        return msg;
+    }
+
+    /// Take over the outcome of a testcase from a RESULT message.
+    static void
+    apply(message const& msg_, testcase& tc_) {
+        tc_.result(static_cast<testcase::results>(msg_.num<int>(2)), msg_.num<double>(3), msg_.str(4));
+        tc_.cout(msg_.str(5));
+        tc_.cerr(msg_.str(6));
+        auto const reps_at{9 + msg_.num<std::size_t>(8)};
+        if (reps_at > 9) {
+            measurement bench;
+            bench.iterations(msg_.num<std::size_t>(7));
+            for (std::size_t i{9}; i < reps_at; ++i) {
+                bench.add(msg_.num<double>(i));
+            }
+            tc_.measured(std::move(bench));
+        }
+        if (msg_.size() > reps_at + 1) {
+            auto const fails{msg_.num<std::size_t>(reps_at)};
+            repetition reps;
+            for (auto i{reps_at + 1}; i < msg_.size(); ++i) {
+                reps.add(msg_.num<double>(i), i - reps_at - 1 < fails);
+            }
+            tc_.repetitions(std::move(reps));
+        }
+    }
+
+    /// Describe an exception, as it is reported.
+    static auto
+    describe(std::exception_ptr const& err_) -> std::string {
+        try {
+            std::rethrow_exception(err_);
+        } catch (std::exception const& e) {
+            return std::string("[") + name_for_type(e) + "] " + e.what();
+        } catch (...) {
+            return "unknown error";
+        }
+    }
+
+private:
+    void
+    run(channel& ch_, message const& msg_) {
+        auto const& part{msg_.str(0)};
+        auto const  s{msg_.num<std::size_t>(1)};
+        std::string err;
+        try {
+            if (s >= m_suites.size() || msg_.str(2) != m_suites[s]->name()) {
+                throw std::runtime_error("testsuite " + msg_.str(2) + " is unknown to the worker");
+            }
+            if (!m_errors[s].empty()) {
+                throw std::runtime_error(m_errors[s]);
+            }
+            auto&                    ts{*m_suites[s]};
+            std::vector<std::size_t> idxs;
+            for (std::size_t a{3}; a + 1 < msg_.size(); a += 2) {
+                idxs.push_back(find(ts, msg_.str(a), msg_.num<std::size_t>(a + 1)));
+            }
+            std::size_t n{0};
+            ts.run_part(idxs, [&](std::size_t i_) { ch_.send(result(part, n++, ts.testcases()[i_])); });
+        } catch (...) {
+            err = describe(std::current_exception());
+            if (s < m_suites.size() && m_errors[s].empty()) {
+                m_errors[s] = err;
+            }
+        }
+        ch_.send(err.empty() ? (message("DONE") << part) : (message("ERROR") << part << err));
+    }
+
+    void
+    close(channel& ch_, std::size_t s_) {
+        message reply("CLOSED");
+        reply << s_;
+        if (s_ < m_suites.size()) {
+            try {
+                m_suites[s_]->finish_parts();
+            } catch (...) {
+                reply << describe(std::current_exception());
+            }
+        }
+        ch_.send(reply);
+    }
+
+    void
+    list(channel& ch_) {
+        std::for_each(m_suites.cbegin(), m_suites.cend(), [&](testsuite_ptr const& ts_) {
+            message suite("SUITE");
+            suite << ts_->name() << ts_->parallel();
+            std::for_each(ts_->dependencies().cbegin(), ts_->dependencies().cend(),
+                          [&](char const* d_) { suite << d_; });
+            ch_.send(suite);
+            std::for_each(ts_->testcases().cbegin(), ts_->testcases().cend(), [&](testcase const& tc_) {
+                auto const& attrs{tc_.attributes()};
+                message     test("TEST");
+                test << tc_.name() << static_cast<int>(attrs.mode) << attrs.timeout << attrs.tags.size();
+                std::for_each(attrs.tags.cbegin(), attrs.tags.cend(), [&](char const* t_) { test << t_; });
+                std::for_each(attrs.resources.cbegin(), attrs.resources.cend(),
+                              [&](resource const& r_) { test << r_.name << r_.limit; });
+                ch_.send(test);
+            });
+        });
+        ch_.send(message("END"));
+    }
+
+    void
+    configure(message const& msg_) {
+        auto const timeout{msg_.num<double>(0)};
+        auto const repeat{msg_.num<std::size_t>(1)};
+        auto const until_fail{msg_.num<bool>(2)};
+        auto const isolated{msg_.num<bool>(3)};
+        std::for_each(m_suites.begin(), m_suites.end(), [&](testsuite_ptr const& ts_) {
+            ts_->timeout(timeout);
+            if (repeat > 0) {
+                ts_->repeat(repeat, until_fail);
+            }
+            if (isolated) {
+                ts_->isolate();
+            }
+        });
+    }
+
+    /// Find the testcase, whose name occurs for the nth_ time in a testsuite.
+    static auto
+    find(testsuite const& ts_, std::string const& name_, std::size_t nth_) -> std::size_t {
+        auto const& tcs{ts_.testcases()};
+        for (std::size_t i{0}; i < tcs.size(); ++i) {
+            if (name_ == tcs[i].name() && nth_-- == 0) {
+                return i;
+            }
+        }
+        throw std::runtime_error("testcase " + name_ + " is unknown to the worker");
+    }
+
+    std::vector<testsuite_ptr> const& m_suites;
+    std::vector<std::string>          m_errors;  ///< Errors of hooks by testsuite, that fail all further parts.
+};
+}  // namespace test
+}  // namespace intern
+}  // namespace tpp
+
+#endif  // TPP_TEST_WORKER_HPP
@@ -26,6 +26,7 @@
 #include "assert/range.hpp"
 #include "assert/regex.hpp"
 
+#include "aggregator.hpp"
 #include "api.hpp"
 #include "regex.hpp"
 #include "runner.hpp"
@@ -38,4 +39,13 @@
         return tpp::runner::instance().run(argc_, argv_); \
     }
 
+/**
+ * Define a main function, which runs all tests of the Test++ binaries given after "--" together, and reports them at
+ * once. It allows the same modifications via command line arguments as TPP_DEFAULT_MAIN.
+ */
+#define TPP_AGGREGATOR_MAIN                         \
+    auto main(int argc_, char const** argv_)->int { \
+        return tpp::aggregator().run(argc_, argv_); \
+    }
+
 #endif  // TPP_TPP_HPP
@@ -3,9 +3,11 @@ set -eo pipefail
 
 FILES="../include/version.hpp
 ../include/cpp_meta.hpp
-../include/omp.hpp
 ../include/traits.hpp
 ../include/duration.hpp
+../include/exec/executor.hpp
+../include/exec/thread_pool.hpp
+../include/exec/mpsc_queue.hpp
 ../include/regex.hpp
 ../include/stringify.hpp
 ../include/assert/loc.hpp
@@ -15,20 +17,41 @@ FILES="../include/version.hpp
 ../include/assert/equality.hpp
 ../include/assert/range.hpp
 ../include/assert/regex.hpp
+../include/test/attributes.hpp
+../include/test/statistic.hpp
+../include/test/benchmark.hpp
 ../include/test/testcase.hpp
+../include/test/baseline.hpp
+../include/test/fixture.hpp
+../include/test/cancellation.hpp
+../include/test/resources.hpp
+../include/test/watchdog.hpp
+../include/test/isolation.hpp
 ../include/test/streambuf_proxy.hpp
-../include/test/statistic.hpp
 ../include/test/testsuite.hpp
 ../include/test/testsuite_parallel.hpp
+../include/test/registry.hpp
+../include/test/selection.hpp
+../include/test/run_cache.hpp
+../include/test/shard.hpp
+../include/test/shuffle.hpp
+../include/test/suite_graph.hpp
+../include/test/filter.hpp
+../include/test/manifest.hpp
+../include/test/channel.hpp
+../include/test/worker.hpp
+../include/test/distributor.hpp
 ../include/report/reporter.hpp
 ../include/report/xml_reporter.hpp
 ../include/report/console_reporter.hpp
 ../include/report/markdown_reporter.hpp
 ../include/report/json_reporter.hpp
 ../include/report/reporter_factory.hpp
+../include/report/pipeline.hpp
 ../include/config.hpp
 ../include/cmdline_parser.hpp
 ../include/runner.hpp
+../include/aggregator.hpp
 ../include/api.hpp
 ../include/tpp.hpp"
 
@@ -15,9 +15,21 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -28,13 +40,9 @@
 #include "test_traits.hpp"
 #include "tpp.hpp"
 
-#ifdef _OPENMP
-#    include <omp.h>
-#else
-#    define omp_get_max_threads() 1
-#endif
-
 #ifdef TPP_INTERN_SYS_UNIX
+#    include <sys/socket.h>
+
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wunused-variable"
 #    pragma GCC diagnostic ignored "-Wunused-but-set-variable"
@@ -42,10 +50,15 @@
 
 using tpp::operator""_re;
 using tpp::operator""_re_i;
+using tpp::aggregator;
 using tpp::config;
 using tpp::reporter_ptr;
 using tpp::runner;
 using tpp::intern::cmdline_parser;
+using tpp::intern::exec::executor;
+using tpp::intern::exec::mpsc_queue;
+using tpp::intern::exec::sequential_executor;
+using tpp::intern::exec::thread_pool;
 using tpp::intern::to_string;
 using tpp::intern::assert::assertion_failure;
 using tpp::intern::report::console_reporter;
@@ -54,11 +67,32 @@ using tpp::intern::report::markdown_reporter;
 using tpp::intern::report::reporter_config;
 using tpp::intern::report::reporter_factory;
 using tpp::intern::report::xml_reporter;
+using tpp::intern::test::baseline;
+using tpp::intern::test::connection;
+using tpp::intern::test::distributor;
+using tpp::intern::test::filter;
+using tpp::intern::test::glob;
+using tpp::intern::test::instancing;
+using tpp::intern::test::listener;
+using tpp::intern::test::manifest;
+using tpp::intern::test::measurement;
+using tpp::intern::test::member_kind;
+using tpp::intern::test::member_record;
+using tpp::intern::test::message;
+using tpp::intern::test::registry;
+using tpp::intern::test::repetition;
+using tpp::intern::test::run_cache;
+using tpp::intern::test::shard;
+using tpp::intern::test::shuffle;
 using tpp::intern::test::statistic;
+using tpp::intern::test::suite_record;
+using tpp::intern::test::suite_spec;
+using tpp::intern::test::test_spec;
 using tpp::intern::test::testcase;
 using tpp::intern::test::testsuite;
 using tpp::intern::test::testsuite_parallel;
 using tpp::intern::test::testsuite_ptr;
+using tpp::intern::test::worker;
 
 SUITE_PAR("test_assert") {
     TEST("equals") {
@@ -439,9 +473,10 @@ SUITE("test_testsuite_parallel") {
         ts->test("", [] { std::this_thread::sleep_for(std::chrono::milliseconds(1000)); });
         ts->test("", [] { ASSERT_TRUE(false); });
         ts->test("", [] { throw std::logic_error(""); });
-        std::cout << "max threads: " << omp_get_max_threads() << std::flush;
+        auto const threads{thread_pool::shared().concurrency()};
+        std::cout << "max threads: " << threads << std::flush;
         ASSERT_RUNTIME(ts->run(), 2500);
-        if (omp_get_max_threads() == 1) {
+        if (threads == 1) {
             ASSERT(ts->statistics().elapsed_time(), GT, 2000);
             double t = 0.0;
             for (auto const& tc : ts->testcases()) {
@@ -457,9 +492,1554 @@ SUITE("test_testsuite_parallel") {
         ASSERT_EQ(stat.failures(), 1UL);
         ASSERT_EQ(stat.successes(), 2UL);
     };
+    TEST("parallel_run with thread pool") {
+        thread_pool   pool(4);
+        testsuite_ptr ts = testsuite_parallel::create("ts");
+        for (int i = 0; i < 4; ++i) {
+            ts->test("", [] { std::this_thread::sleep_for(std::chrono::milliseconds(500)); });
+        }
+        ts->test("", [] { ASSERT_TRUE(false); });
+        ts->test("", [] { throw std::logic_error(""); });
+        ASSERT_RUNTIME(ts->run(pool), 1000);
+        statistic const& stat = ts->statistics();
+        ASSERT_EQ(stat.tests(), 6UL);
+        ASSERT_EQ(stat.errors(), 1UL);
+        ASSERT_EQ(stat.failures(), 1UL);
+        ASSERT_EQ(stat.successes(), 4UL);
+    };
+    TEST("serial and exclusive testcases") {
+        thread_pool       pool(4);
+        testsuite_ptr     ts = testsuite_parallel::create("ts");
+        std::atomic<int>  active{0};
+        std::atomic<int>  active_serial{0};
+        std::atomic<bool> violated{false};
+        for (int i = 0; i < 8; ++i) {
+            ts->test("", [&] {
+                ++active;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                --active;
+            });
+            ts->test(test_spec("", serial()), [&] {
+                ++active;
+                if (++active_serial > 1) {
+                    violated = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                --active_serial;
+                --active;
+            });
+        }
+        for (int i = 0; i < 2; ++i) {
+            ts->test(test_spec("", exclusive()), [&] {
+                if (active.load() != 0) {
+                    violated = true;
+                }
+            });
+        }
+        ts->run(pool);
+        ASSERT_FALSE(violated.load());
+        ASSERT_EQ(ts->statistics().successes(), 18UL);
+    };
+    TEST("resource limits") {
+        thread_pool      pool(4);
+        std::atomic<int> db{0};
+        std::atomic<int> max_db{0};
+        std::atomic<int> other{0};
+        auto const       hold_db{[&] {
+            auto const n{++db};
+            for (auto m = max_db.load(); n > m && !max_db.compare_exchange_weak(m, n);) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            --db;
+        }};
+        std::vector<testsuite_ptr> suites{testsuite_parallel::create("ts1"), testsuite::create("ts2")};
+        for (int i = 0; i < 8; ++i) {
+            suites[0]->test(test_spec("", resource("db", 2)), hold_db);
+            suites[0]->test("", [&] { ++other; });
+            suites[1]->test(test_spec("", resource("db", 2), parallel_safe()), hold_db);
+        }
+        auto const res{std::make_shared<tpp::intern::test::resources>()};
+        suites[0]->limit_by(res);
+        suites[1]->limit_by(res);
+        pool.parallel_for(2, [&](std::size_t i_, std::size_t) { suites[i_]->run(pool); });
+        ASSERT_EQ(suites[0]->statistics().successes(), 16UL);
+        ASSERT_EQ(suites[1]->statistics().successes(), 8UL);
+        ASSERT_EQ(other.load(), 8);
+        ASSERT_LT(max_db.load(), 3);
+    };
+    TEST("one limit per resource") {
+        using resource = tpp::intern::test::resource;
+        tpp::intern::test::resources uut;
+        uut.declare({resource{"db", 1}, resource{"fs", 2}});
+        ASSERT_NOTHROW(uut.declare({resource{"db", 1}}));
+        ASSERT_THROWS(uut.declare({resource{"db", 2}}), std::runtime_error);
+        ASSERT_THROWS(uut.try_acquire({resource{"fs", 3}}), std::runtime_error);
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 1}}));
+        ASSERT_FALSE(uut.try_acquire({resource{"db", 1}}));
+        uut.release({resource{"db", 1}});
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 1}}));
+    };
+    TEST("resource declared twice") {
+        using resource = tpp::intern::test::resource;
+        tpp::intern::test::resources uut;
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 2}, resource{"db", 2}}));
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 2}}));
+        ASSERT_FALSE(uut.try_acquire({resource{"db", 2}}));
+        uut.release({resource{"db", 2}, resource{"db", 2}});
+        ASSERT_TRUE(uut.try_acquire({resource{"fs", 3}, resource{"fs", 1}}));
+        ASSERT_FALSE(uut.try_acquire({resource{"fs", 1}}));
+        test_spec const spec("", benchmark());
+        ASSERT_NOTHROW(uut.declare(spec.attrs.resources));
+        ASSERT_NOTHROW(uut.declare({resource{"benchmark", 2}}));
+    };
+    TEST("serial testcases take a chain of their resources") {
+        thread_pool       pool(4);
+        testsuite_ptr     ts = testsuite_parallel::create("ts");
+        std::atomic<int>  shared{0};
+        std::atomic<bool> violated{false};
+        ts->test(test_spec("", serial(), resource("db", 2)), [] {});
+        for (int i = 0; i < 4; ++i) {
+            ts->test(test_spec("", resource("db", 2)), [&] {
+                if (++shared > 1) {
+                    violated = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                --shared;
+            });
+        }
+        ts->run(pool);
+        ASSERT_FALSE(violated.load());
+        ASSERT_EQ(ts->statistics().successes(), 5UL);
+    };
+    TEST("exclusive holders") {
+        using resource = tpp::intern::test::resource;
+        tpp::intern::test::resources uut;
+        ASSERT_TRUE(uut.try_acquire({}));
+        ASSERT_FALSE(uut.try_acquire({}, true));
+        uut.release({});
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 2}}, true));
+        ASSERT_FALSE(uut.try_acquire({}));
+        ASSERT_FALSE(uut.try_acquire({}, true));
+        uut.release({resource{"db", 2}}, true);
+        ASSERT_TRUE(uut.try_acquire({resource{"db", 2}}));
+        uut.release({resource{"db", 2}});
+    };
+    TEST("benchmarks run alone across testsuites") {
+        thread_pool       pool(4);
+        std::atomic<int>  active{0};
+        std::atomic<bool> violated{false};
+        std::vector<testsuite_ptr> suites{testsuite_parallel::create("ts1"), testsuite::create("ts2")};
+        for (int i = 0; i < 16; ++i) {
+            suites[0]->test("", [&] {
+                ++active;
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                --active;
+            });
+        }
+        suites[1]->test(test_spec("", benchmark()), [&] {
+            if (active.load() != 0) {
+                violated = true;
+            }
+        });
+        auto const res{std::make_shared<tpp::intern::test::resources>()};
+        suites[0]->limit_by(res);
+        suites[1]->limit_by(res);
+        pool.parallel_for(2, [&](std::size_t i_, std::size_t) { suites[i_]->run(pool); });
+        ASSERT_FALSE(violated.load());
+        ASSERT_EQ(suites[0]->statistics().successes(), 16UL);
+        ASSERT_EQ(suites[1]->statistics().successes(), 1UL);
+    };
+    TEST("conflicting resource limits in runner") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        auto const ts1{testsuite::create("ts1")};
+        auto const ts2{testsuite::create("ts2")};
+        ts1->test(test_spec("", resource("db", 2)), [] {});
+        ts2->test(test_spec("", resource("db", 3)), [] {});
+        runner r;
+        r.add_testsuite(ts1);
+        r.add_testsuite(ts2);
+        ASSERT_NOT_EQ(r.run(c), 0);
+        ASSERT_EQ(ts1->testcases().at(0).result(), testcase::IS_UNDONE);
+    };
+};
+
+SUITE_PAR("test_executor") {
+    TEST("sequential") {
+        sequential_executor uut;
+        std::vector<std::size_t> order;
+        auto e = ASSERT_THROWS(uut.parallel_for(4,
+                                                [&](std::size_t i_, std::size_t w_) {
+                                                    ASSERT_EQ(w_, 0UL);
+                                                    order.push_back(i_);
+                                                    if (i_ > 1) {
+                                                        throw std::logic_error(to_string(i_));
+                                                    }
+                                                }),
+                               std::logic_error);
+        ASSERT_EQ(order, (std::vector<std::size_t>{0, 1, 2, 3}));
+        ASSERT_EQ(std::string(e.what()), "2");
+        ASSERT_EQ(uut.concurrency(), 1UL);
+    };
+    TEST("thread pool") {
+        thread_pool                   uut(3);
+        std::vector<std::atomic<int>> calls(100);
+        ASSERT_EQ(uut.concurrency(), 3UL);
+        ASSERT_NOTHROW(uut.parallel_for(calls.size(), [&](std::size_t i_, std::size_t w_) {
+            ASSERT_LT(w_, 3UL);
+            ++calls[i_];
+        }));
+        for (auto const& c : calls) {
+            ASSERT_EQ(c.load(), 1);
+        }
+        ASSERT_NOTHROW(uut.parallel_for(0, [](std::size_t, std::size_t) { throw std::logic_error(""); }));
+    };
+    TEST("thread pool error") {
+        thread_pool      uut(2);
+        std::atomic<int> calls{0};
+        ASSERT_THROWS(uut.parallel_for(10,
+                                       [&](std::size_t i_, std::size_t) {
+                                           ++calls;
+                                           if (i_ % 2 == 0) {
+                                               throw std::logic_error("");
+                                           }
+                                       }),
+                      std::logic_error);
+        ASSERT_EQ(calls.load(), 10);
+    };
+    TEST("thread pool nested") {
+        thread_pool      uut(2);
+        std::atomic<int> calls{0};
+        uut.parallel_for(8, [&](std::size_t, std::size_t) {
+            uut.parallel_for(8, [&](std::size_t, std::size_t w_) {
+                ASSERT_LT(w_, 2UL);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                ++calls;
+            });
+        });
+        ASSERT_EQ(calls.load(), 64);
+    };
+    TEST("thread pool waits only for own tasks") {
+        static thread_local int depth{0};
+        thread_pool             uut(2);
+        std::atomic<int>        seen{-1};
+        // Spawned while the first worker waits for its nested task, that the second worker stole.
+        std::thread other([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(15));
+            uut.spawn([&](std::size_t, std::size_t) { seen = depth; });
+        });
+        uut.parallel_for(2, [&](std::size_t i_, std::size_t) {
+            if (i_ == 1) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                return;
+            }
+            ++depth;
+            uut.parallel_for(2, [](std::size_t, std::size_t) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            });
+            --depth;
+        });
+        other.join();
+        while (seen.load() < 0) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(seen.load(), 0);
+    };
+    TEST("spawn") {
+        sequential_executor     seq;
+        thread_pool             pool(3);
+        std::mutex              mtx;
+        std::condition_variable cv;
+        for (executor* uut : {static_cast<executor*>(&seq), static_cast<executor*>(&pool)}) {
+            int                     calls{0};
+            executor::task_function chain;
+            chain = [&](std::size_t, std::size_t) {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (++calls < 100) {
+                    uut->spawn(chain);
+                }
+                cv.notify_all();
+                throw std::logic_error("");
+            };
+            uut->spawn(chain);
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [&] { return calls == 100; });
+        }
+    };
+    TEST("thread pool on workers") {
+        thread_pool                  uut(3);
+        std::vector<std::thread::id> ids(3);
+        uut.on_workers({0, 1, 2}, [&](std::size_t i_, std::size_t w_) {
+            ASSERT_EQ(i_, w_);
+            ids[w_] = std::this_thread::get_id();
+        });
+        ASSERT_NOT_EQ(ids[0], ids[1]);
+        ASSERT_NOT_EQ(ids[1], ids[2]);
+        ASSERT_NOT_EQ(ids[0], std::this_thread::get_id());
+        std::atomic<int> calls{0};
+        uut.parallel_for(6, [&](std::size_t, std::size_t) {
+            uut.on_workers({2, 0}, [&](std::size_t i_, std::size_t w_) {
+                ASSERT_EQ(w_, i_ == 0 ? 2UL : 0UL);
+                ASSERT_EQ(ids[w_], std::this_thread::get_id());
+                ++calls;
+            });
+        });
+        ASSERT_EQ(calls.load(), 12);
+    };
+    TEST("mpsc queue") {
+        mpsc_queue<int> uut(3);
+        int             v = 0;
+        ASSERT_TRUE(uut.empty());
+        ASSERT_FALSE(uut.pop(v));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(uut.push(i));
+        }
+        ASSERT_FALSE(uut.push(4));
+        ASSERT_TRUE(uut.pop(v));
+        ASSERT_EQ(v, 0);
+        ASSERT_TRUE(uut.push(4));
+        for (int i = 1; i < 5; ++i) {
+            ASSERT_FALSE(uut.empty());
+            ASSERT_TRUE(uut.pop(v));
+            ASSERT_EQ(v, i);
+        }
+        ASSERT_TRUE(uut.empty());
+    };
+    TEST("mpsc queue concurrent") {
+        mpsc_queue<int>          uut(16);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p) {
+            producers.emplace_back([&uut, p] {
+                for (int i = 0; i < 1000; ++i) {
+                    while (!uut.push(p * 1000 + i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::vector<int> last(4, -1);
+        for (int n = 0; n < 4000;) {
+            int v = 0;
+            if (uut.pop(v)) {
+                ASSERT_EQ(v % 1000, last[v / 1000] + 1);
+                last[v / 1000] = v % 1000;
+                ++n;
+            }
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+        ASSERT_TRUE(uut.empty());
+    };
+};
+
+SUITE_PAR("test_filter") {
+    static auto
+    make_suites() -> std::vector<testsuite_ptr> {
+        std::vector<testsuite_ptr> suites;
+        for (auto const name : {"alpha", "alpine", "beta", "empty"}) {
+            suites.push_back(testsuite::create(name));
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            suites[i]->test(test_spec("fast"), [] {});
+            suites[i]->test(test_spec("slow", tags("slow", "db")), [] {});
+        }
+        return suites;
+    }
+
+    static auto
+    names(std::vector<testsuite_ptr> const& suites_) -> std::string {
+        std::string s;
+        for (auto const& ts : suites_) {
+            s += std::string(ts->name()) + "(";
+            for (auto const& tc : ts->testcases()) {
+                s += std::string(tc.name()) + ",";
+            }
+            s += ")";
+        }
+        return s;
+    }
+
+    TEST("glob") {
+        ASSERT_TRUE(glob("").match(""));
+        ASSERT_FALSE(glob("").match("a"));
+        ASSERT_TRUE(glob("*").match(""));
+        ASSERT_TRUE(glob("*").match("abc"));
+        ASSERT_TRUE(glob("a*c").match("abbbc"));
+        ASSERT_TRUE(glob("a*b*c").match("aXbYbZc"));
+        ASSERT_FALSE(glob("a*b*c").match("aXbYbZ"));
+        ASSERT_TRUE(glob("a?c").match("abc"));
+        ASSERT_FALSE(glob("a?c").match("ac"));
+        ASSERT_TRUE(glob("[a-c]x").match("bx"));
+        ASSERT_FALSE(glob("[a-c]x").match("dx"));
+        ASSERT_TRUE(glob("[!a-c]x").match("dx"));
+        ASSERT_TRUE(glob("[]]").match("]"));
+        ASSERT_TRUE(glob("*.cpp").match("a.b.cpp"));
+        ASSERT_FALSE(glob("*.cpp").match("a.cpp.h"));
+        ASSERT_EQ(glob("ab*c").prefix(), "ab");
+        ASSERT_EQ(glob("?b").prefix(), "");
+        ASSERT_THROWS(glob("[ab"), std::runtime_error);
+    };
+    TEST("invalid patterns") {
+        filter uut;
+        ASSERT_THROWS(uut.add(""), std::runtime_error);
+        ASSERT_THROWS(uut.add("@"), std::runtime_error);
+        ASSERT_THROWS(uut.add("a/b/c"), std::runtime_error);
+        ASSERT_THROWS(uut.add("a/[b"), std::runtime_error);
+        ASSERT_TRUE(uut.empty());
+    };
+    TEST("testsuites") {
+        filter uut;
+        uut.add("alp*");
+        uut.add("beta");
+        ASSERT_EQ(uut.size(), 2UL);
+        auto suites = make_suites();
+        uut.apply(suites, true);
+        ASSERT_EQ(names(suites), "alpha(fast,slow,)alpine(fast,slow,)beta(fast,slow,)");
+        suites = make_suites();
+        uut.apply(suites, false);
+        ASSERT_EQ(names(suites), "empty()");
+    };
+    TEST("testcases") {
+        filter uut;
+        uut.add("alpha/s*");
+        uut.add("al*/f?st");
+        auto suites = make_suites();
+        uut.apply(suites, true);
+        ASSERT_EQ(names(suites), "alpha(fast,slow,)alpine(fast,)");
+        suites = make_suites();
+        uut.apply(suites, false);
+        ASSERT_EQ(names(suites), "alpine(slow,)beta(fast,slow,)empty()");
+    };
+    TEST("tags") {
+        filter uut;
+        uut.add("@d?");
+        uut.add("beta/fast");
+        auto suites = make_suites();
+        uut.apply(suites, true);
+        ASSERT_EQ(names(suites), "alpha(slow,)alpine(slow,)beta(fast,slow,)");
+        suites = make_suites();
+        uut.apply(suites, false);
+        ASSERT_EQ(names(suites), "alpha(fast,)alpine(fast,)empty()");
+    };
+    TEST("many testsuites") {
+        std::vector<testsuite_ptr> suites;
+        std::vector<std::string>   names;
+        for (int i = 0; i < 20000; ++i) {
+            names.push_back("suite" + std::to_string(i));
+        }
+        for (auto const& n : names) {
+            suites.push_back(testsuite::create(n.c_str()));
+            suites.back()->test("test", [] {});
+        }
+        filter uut;
+        for (int i = 0; i < 50; ++i) {
+            uut.add("suite" + std::to_string(i * 400) + "/test");
+        }
+        uut.apply(suites, true);
+        ASSERT_EQ(suites.size(), 50UL);
+        ASSERT_EQ(std::string(suites.at(1)->name()), "suite400");
+    };
+};
+
+SUITE_PAR("test_manifest") {
+    static auto
+    make_suites() -> std::vector<testsuite_ptr> {
+        auto ts1 = testsuite::create("ts1");
+        auto ts2 = testsuite::create("t\"s2");
+        ts1->test(test_spec("fast"), [] {});
+        ts1->test(test_spec("slow", tags("slow", "db")), [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+        ts1->setup([] { throw std::logic_error("must not be run"); });
+        return {ts1, ts2};
+    }
+
+    TEST("text") {
+        auto const         suites = make_suites();
+        std::ostringstream oss;
+        manifest(suites, run_cache()).text(oss);
+        ASSERT_EQ(oss.str(), "ts1\n  fast\n  slow @slow @db\nt\"s2\n2 testsuites, 2 testcases\n");
+    };
+    TEST("json") {
+        auto const         suites = make_suites();
+        std::ostringstream oss;
+        manifest(suites, run_cache()).json(oss);
+        ASSERT_EQ(oss.str(), "{\"testsuites\":[\n"
+                             "{\"name\":\"ts1\",\"tests\":[{\"name\":\"fast\",\"tags\":[]},"
+                             "{\"name\":\"slow\",\"tags\":[\"slow\",\"db\"]}]},\n"
+                             "{\"name\":\"t\\\"s2\",\"tests\":[]}\n"
+                             "],\"count\":2}\n");
+    };
+    TEST("known times") {
+        auto ts = testsuite::create("ts1");
+        ts->test("fast", [] {});
+        ts->run();
+        run_cache cache;
+        cache.update(*ts);
+        std::ostringstream oss;
+        manifest(make_suites(), cache).text(oss);
+        ASSERT_EQ(oss.str().find("ts1 ("), 0UL);
+        ASSERT_NOT_EQ(oss.str().find("\n  fast ("), std::string::npos);
+        ASSERT_NOT_EQ(oss.str().find("\n  slow @slow @db\n"), std::string::npos);
+    };
+};
+
+SUITE_PAR("test_shuffle") {
+    static auto
+    names(std::size_t n_) -> std::vector<std::string> {
+        std::vector<std::string> n;
+        for (std::size_t i = 0; i < n_; ++i) {
+            n.push_back("tc" + std::to_string(i));
+        }
+        return n;
+    }
+    TEST("order") {
+        shuffle uut;
+        uut.seed = 42;
+        auto const o{uut.order(names(100))};
+        ASSERT_EQ(o, uut.order(names(100)));
+        auto sorted{o};
+        std::sort(sorted.begin(), sorted.end());
+        for (std::size_t i = 0; i < sorted.size(); ++i) {
+            ASSERT_EQ(sorted[i], i);
+        }
+        uut.seed = 43;
+        ASSERT_NOT_EQ(o, uut.order(names(100)));
+        ASSERT_TRUE(uut.order({}).empty());
+        ASSERT_EQ(uut.order({"a"}), std::vector<std::size_t>{0});
+        ASSERT_EQ(uut.order(std::vector<std::string>(100, "same")).size(), 100UL);
+    };
+    TEST("filtering keeps the relative order") {
+        shuffle uut;
+        uut.seed = 42;
+        auto const               all{names(100)};
+        std::vector<std::string> kept;
+        for (std::size_t i = 0; i < all.size(); i += 3) {
+            kept.push_back(all[i]);
+        }
+        std::vector<std::string> expected;
+        for (auto const i : uut.order(all)) {
+            if (i % 3 == 0) {
+                expected.push_back(all[i]);
+            }
+        }
+        std::vector<std::string> actual;
+        for (auto const i : uut.order(kept)) {
+            actual.push_back(kept[i]);
+        }
+        ASSERT_EQ(actual, expected);
+    };
+    TEST("apply") {
+        shuffle uut;
+        uut.seed = 7;
+        std::vector<testsuite_ptr> suites;
+        for (int i = 0; i < 20; ++i) {
+            suites.push_back(testsuite_parallel::create("ts"));
+        }
+        auto const                 orig{suites};
+        std::vector<std::size_t> ran;
+        std::vector<std::string> tc_names;
+        std::mutex               mtx;
+        for (std::size_t i = 0; i < 20; ++i) {
+            suites[0]->test("test", [&, i] {
+                std::lock_guard<std::mutex> lk(mtx);
+                ran.push_back(i);
+            });
+            tc_names.push_back("ts\ttest");
+        }
+        uut.apply(suites);
+        ASSERT_NOT_EQ(suites, orig);
+        ASSERT_TRUE(std::is_permutation(suites.cbegin(), suites.cend(), orig.cbegin()));
+        sequential_executor exec;
+        orig[0]->run(exec);
+        ASSERT_EQ(ran, uut.order(tc_names));
+    };
+    TEST("seed in reports") {
+        std::ostringstream oss;
+        for (auto const fmt : {config::report_format::CNS, config::report_format::XML, config::report_format::JSON,
+                               config::report_format::MD}) {
+            config c;
+            c.report_cfg.ostream = &oss;
+            c.report_fmt         = fmt;
+            c.shuffle.enabled    = true;
+            c.shuffle.seed       = 1234567;
+            c.thd_count          = 1;
+            runner r;
+            r.add_testsuite(testsuite::create("ts"));
+            ASSERT_EQ(r.run(c), 0);
+            ASSERT_NOT_EQ(oss.str().find("1234567"), std::string::npos);
+            oss.str("");
+            c.shuffle.enabled = false;
+            ASSERT_EQ(r.run(c), 0);
+            ASSERT_EQ(oss.str().find("1234567"), std::string::npos);
+            oss.str("");
+        }
+    };
+};
+
+SUITE_PAR("test_registry") {
+    static auto
+    events() -> std::vector<std::string>& {
+        static std::vector<std::string> e;
+        return e;
+    }
+    static auto
+    make() -> void* {
+        events().push_back("make");
+        return &events();
+    }
+    static void
+    destroy(void* mod_) {
+        static_cast<std::vector<std::string>*>(mod_)->push_back("destroy");
+    }
+    static auto
+    suite_ts() -> suite_spec {
+        return suite_spec("ts");
+    }
+    static auto
+    suite_ts1() -> suite_spec {
+        return suite_spec("ts1");
+    }
+    static auto
+    suite_ts2() -> suite_spec {
+        return suite_spec("ts2", depends_on("ts1"));
+    }
+    static auto
+    spec_a() -> test_spec {
+        return test_spec("a");
+    }
+    static auto
+    spec_b() -> test_spec {
+        return test_spec("b");
+    }
+    static void
+    run_a(void* mod_) {
+        static_cast<std::vector<std::string>*>(mod_)->push_back("a");
+    }
+    static void
+    run_b(void* mod_) {
+        static_cast<std::vector<std::string>*>(mod_)->push_back("b");
+    }
+    static void
+    run_hook(void* mod_) {
+        static_cast<std::vector<std::string>*>(mod_)->push_back("hook");
+    }
+    static auto
+    created() -> std::atomic<int>& {
+        static std::atomic<int> c{0};
+        return c;
+    }
+    static auto
+    create_counted(char const* name_) -> testsuite_ptr {
+        ++created();
+        return testsuite::create(name_);
+    }
+    struct worker_mod
+    {
+        std::thread::id owner;
+    };
+    static auto
+    counter(std::size_t i_) -> std::atomic<int>& {
+        static std::atomic<int> c[4]{{0}, {0}, {0}, {0}};
+        return c[i_];
+    }
+    static auto
+    make_worker() -> void* {
+        ++counter(0);
+        return new worker_mod();
+    }
+    static void
+    destroy_worker(void* mod_) {
+        ++counter(1);
+        delete static_cast<worker_mod*>(mod_);
+    }
+    static void
+    init_worker(void* mod_) {
+        ++counter(2);
+        static_cast<worker_mod*>(mod_)->owner = std::this_thread::get_id();
+    }
+    static void
+    fini_worker(void*) {
+        ++counter(3);
+    }
+    static void
+    fini_owner(void* mod_) {
+        if (static_cast<worker_mod*>(mod_)->owner == std::this_thread::get_id()) {
+            ++counter(3);
+        }
+    }
+    static void
+    setup_worker(void* mod_) {
+        // Testcases would fail on this instance.
+        static_cast<worker_mod*>(mod_)->owner = std::thread::id();
+    }
+    static void
+    run_worker(void* mod_) {
+        auto* const mod{static_cast<worker_mod*>(mod_)};
+        if (mod->owner != std::this_thread::get_id()) {
+            throw std::logic_error("instance is shared between threads");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    struct counting_mod
+    {
+        int runs{0};
+    };
+    static void
+    before_counting(void* mod_) {
+        ++static_cast<counting_mod*>(mod_)->runs;
+    }
+    static void
+    run_counting(void* mod_) {
+        if (++static_cast<counting_mod*>(mod_)->runs != 2) {
+            throw std::logic_error("instance is reused");
+        }
+    }
+
+    TEST("instantiate") {
+        events().clear();
+        suite_record  rec(&suite_ts, &testsuite::create, &make, &destroy);
+        member_record b(rec, member_kind::testcase, 20, &spec_b, &run_b);
+        member_record a(rec, member_kind::testcase, 10, &spec_a, &run_a);
+        member_record s(rec, member_kind::setup, 30, nullptr, &run_hook);
+        member_record e(rec, member_kind::after_each, 5, nullptr, &run_hook);
+        auto          ts = rec.instantiate();
+        ASSERT_EQ(ts->name(), std::string("ts"));
+        ASSERT_EQ(ts->testcases().size(), 2UL);
+        ASSERT_EQ(ts->testcases()[0].name(), std::string("a"));
+        ASSERT_EQ(ts->testcases()[1].name(), std::string("b"));
+        ASSERT_TRUE(events().empty());
+        ts->run();
+        ASSERT_EQ(events(), (std::vector<std::string>{"make", "hook", "a", "hook", "b", "hook", "destroy"}));
+    };
+    TEST("runner with registry") {
+        events().clear();
+        registry      reg;
+        suite_record  rec1(&suite_ts1, &testsuite::create, &make, &destroy);
+        suite_record  rec2(&suite_ts2, &testsuite_parallel::create, &make, &destroy);
+        member_record a(rec1, member_kind::testcase, 1, &spec_a, &run_a);
+        member_record b(rec2, member_kind::testcase, 1, &spec_b, &run_b);
+        ASSERT_TRUE(reg.empty());
+        reg.add(&rec1);
+        reg.add(&rec2);
+        ASSERT_FALSE(reg.empty());
+        ASSERT_EQ(rec1.next(), &rec2);
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.thd_count          = 1;
+        runner r(reg);
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(events(), (std::vector<std::string>{"make", "a", "destroy", "make", "b", "destroy"}));
+        ASSERT_NOT_EQ(oss.str().find("ts2"), std::string::npos);
+    };
+    TEST("filtered fixtures are not constructed") {
+        events().clear();
+        registry      reg;
+        suite_record  rec1(&suite_ts1, &testsuite::create, &make, &destroy);
+        suite_record  rec2(&suite_ts2, &testsuite::create, &make, &destroy);
+        member_record a(rec1, member_kind::testcase, 1, &spec_a, &run_a);
+        member_record b(rec2, member_kind::testcase, 1, &spec_b, &run_b);
+        reg.add(&rec1);
+        reg.add(&rec2);
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.f_patterns.add("ts2");
+        runner r(reg);
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(events(), (std::vector<std::string>{"make", "b", "destroy"}));
+        events().clear();
+        c.list_fmt = config::list_format::TEXT;
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_TRUE(events().empty());
+    };
+    TEST("filtered records are not instantiated") {
+        created() = 0;
+        registry      reg;
+        suite_record  rec1(&suite_ts1, &create_counted, &make, &destroy);
+        suite_record  rec2(&suite_ts, &create_counted, &make, &destroy);
+        member_record a1(rec1, member_kind::testcase, 1, &spec_a, &run_a);
+        member_record a2(rec2, member_kind::testcase, 1, &spec_a, &run_a);
+        member_record b2(rec2, member_kind::testcase, 2, &spec_b, &run_b);
+        reg.add(&rec1);
+        reg.add(&rec2);
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.list_fmt           = config::list_format::TEXT;
+        c.f_patterns.add("ts/b");
+        runner r(reg);
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(created().load(), 1);
+        ASSERT_EQ(oss.str().find("ts1"), std::string::npos);
+        ASSERT_NOT_EQ(oss.str().find("1 testsuites, 1 testcases"), std::string::npos);
+        ASSERT_EQ(rec2.instantiate({0, 1})->testcases().size(), 1UL);
+    };
+    TEST("cancelled fixtures are not constructed") {
+        events().clear();
+        suite_record  rec(&suite_ts, &testsuite_parallel::create, &make, &destroy);
+        member_record a(rec, member_kind::testcase, 1, &spec_a, &run_a);
+        auto          ts     = rec.instantiate();
+        auto const    cancel = std::make_shared<tpp::cancellation>();
+        cancel->cancel();
+        ts->cancel_by(cancel);
+        ts->run();
+        ASSERT_TRUE(events().empty());
+        ASSERT_EQ(ts->statistics().skipped(), 1UL);
+    };
+    TEST("instance per worker") {
+        for (std::size_t i = 0; i < 4; ++i) {
+            counter(i) = 0;
+        }
+        suite_record              rec(&suite_ts, &testsuite_parallel::create, &make_worker, &destroy_worker,
+                                      instancing::per_worker);
+        std::deque<member_record> members;
+        for (int i = 0; i < 32; ++i) {
+            members.emplace_back(rec, member_kind::testcase, i, &spec_a, &run_worker);
+        }
+        members.emplace_back(rec, member_kind::thread_setup, 40, nullptr, &init_worker);
+        members.emplace_back(rec, member_kind::thread_teardown, 41, nullptr, &fini_owner);
+        members.emplace_back(rec, member_kind::setup, 42, nullptr, &setup_worker);
+        auto        ts = rec.instantiate();
+        thread_pool pool(4);
+        ts->run(pool);
+        ASSERT_EQ(ts->statistics().successes(), 32UL);
+        ASSERT_TRUE(counter(0) >= 2 && counter(0) <= 5);
+        ASSERT_EQ(counter(1).load(), counter(0).load());
+        ASSERT_EQ(counter(2).load(), counter(0).load());
+        // Every worker finalizes its own instance, while the one of SETUP is not owned by any thread.
+        ASSERT_EQ(counter(3).load(), counter(0).load() - 1);
+    };
+    TEST("instance per testcase") {
+        for (auto create : {&testsuite::create, &testsuite_parallel::create}) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                counter(i) = 0;
+            }
+            suite_record              rec(&suite_ts, create, &tpp::intern::test::make_recycled_module<counting_mod>,
+                                          &tpp::intern::test::destroy_recycled_module<counting_mod>,
+                                          instancing::per_testcase);
+            std::deque<member_record> members;
+            for (int i = 0; i < 16; ++i) {
+                members.emplace_back(rec, member_kind::testcase, i, &spec_a, &run_counting);
+            }
+            members.emplace_back(rec, member_kind::before_each, 20, nullptr, &before_counting);
+            members.emplace_back(rec, member_kind::thread_teardown, 21, nullptr, &fini_worker);
+            auto        ts = rec.instantiate();
+            thread_pool pool(4);
+            ts->repeat(2, false);
+            ts->run(pool);
+            ASSERT_EQ(ts->statistics().successes(), 16UL);
+            ASSERT_EQ(counter(3).load(), 32);
+        }
+    };
+    TEST("instance per suite with thread hooks") {
+        for (std::size_t i = 0; i < 4; ++i) {
+            counter(i) = 0;
+        }
+        suite_record  rec(&suite_ts, &testsuite::create, &make_worker, &destroy_worker);
+        member_record a(rec, member_kind::testcase, 1, &spec_a, &run_worker);
+        member_record b(rec, member_kind::testcase, 2, &spec_b, &run_worker);
+        member_record i(rec, member_kind::thread_setup, 3, nullptr, &init_worker);
+        member_record f(rec, member_kind::thread_teardown, 4, nullptr, &fini_worker);
+        auto          ts = rec.instantiate();
+        ts->run();
+        ASSERT_EQ(ts->statistics().successes(), 2UL);
+        ASSERT_EQ(counter(0).load(), 1);
+        ASSERT_EQ(counter(1).load(), 1);
+        ASSERT_EQ(counter(2).load(), 1);
+        ASSERT_EQ(counter(3).load(), 1);
+    };
+};
+
+SUITE_PAR("test_suite_graph") {
+    static auto
+    make_suites() -> std::vector<testsuite_ptr> {
+        std::vector<testsuite_ptr> suites{testsuite::create("b"), testsuite::create("a"), testsuite::create("c"),
+                                          testsuite::create("d")};
+        suites[0]->depends_on("c");
+        suites[2]->depends_on("a");
+        suites[2]->depends_on("unknown");
+        return suites;
+    }
+    static auto
+    unknown_time(testsuite const&) -> double {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    TEST("order and priority") {
+        auto const                     suites = make_suites();
+        tpp::intern::test::suite_graph uut(suites, &unknown_time);
+        ASSERT_FALSE(uut.empty());
+        ASSERT_EQ(uut.order(), (std::vector<std::size_t>{1, 2, 0, 3}));
+        ASSERT_EQ(uut.dependencies(0), std::vector<std::size_t>{2});
+        ASSERT_EQ(uut.dependents(1), std::vector<std::size_t>{2});
+        ASSERT_EQ(uut.priority(1), 3.0);
+        ASSERT_EQ(uut.priority(2), 2.0);
+        ASSERT_EQ(uut.priority(3), 1.0);
+        ASSERT_TRUE(tpp::intern::test::suite_graph({testsuite::create("x")}, &unknown_time).empty());
+    };
+    TEST("cycle") {
+        auto const suites = make_suites();
+        suites[1]->depends_on("b");
+        ASSERT_THROWS(tpp::intern::test::suite_graph(suites, &unknown_time), std::runtime_error);
+    };
+    TEST("skip dependents of failed testsuites") {
+        for (auto const par : {false, true}) {
+            std::vector<std::string> ran;
+            std::mutex               mtx;
+            auto const               log{[&](char const* n_) {
+                std::lock_guard<std::mutex> lk(mtx);
+                ran.push_back(n_);
+            }};
+            auto const suites = make_suites();
+            suites[0]->test("b", [&] { log("b"); });
+            suites[1]->test("a", [&] { log("a"); });
+            suites[2]->test("c", [&] {
+                log("c");
+                ASSERT_TRUE(false);
+            });
+            suites[3]->test("d", [&] { log("d"); });
+            std::ostringstream oss;
+            config             c;
+            c.report_cfg.ostream = &oss;
+            c.report_fmt         = config::report_format::XML;
+            c.parallel_suites    = par;
+            runner r;
+            std::for_each(suites.cbegin(), suites.cend(), [&](testsuite_ptr const& ts_) { r.add_testsuite(ts_); });
+            ASSERT_EQ(r.run(c), 1);
+            std::sort(ran.begin(), ran.end());
+            ASSERT_EQ(ran, (std::vector<std::string>{"a", "c", "d"}));
+            ASSERT_EQ(suites[0]->statistics().skipped(), 1UL);
+            ASSERT_NOT_EQ(oss.str().find("name=\"b\" errors=\"0\" tests=\"1\" failures=\"0\" skipped=\"1\""), std::string::npos);
+            ASSERT_LT(oss.str().find("name=\"c\""), oss.str().find("name=\"b\""));
+        }
+    };
+    TEST("critical path first") {
+        std::vector<std::string>   started;
+        std::mutex                 mtx;
+        std::vector<testsuite_ptr> suites;
+        for (auto const* n : {"short", "long1", "long2", "long3"}) {
+            suites.push_back(testsuite::create(n));
+            suites.back()->test("", [&, n] {
+                std::lock_guard<std::mutex> lk(mtx);
+                started.push_back(n);
+            });
+        }
+        suites[2]->depends_on("long1");
+        suites[3]->depends_on("long2");
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.parallel_suites    = true;
+        c.thd_count          = 1;
+        runner r;
+        std::for_each(suites.cbegin(), suites.cend(), [&](testsuite_ptr const& ts_) { r.add_testsuite(ts_); });
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(started.size(), 4UL);
+        ASSERT_EQ(started[0], std::string("long1"));
+        ASSERT_EQ(started[1], std::string("long2"));
+    };
+};
+
+#ifdef TPP_INTERN_SYS_UNIX
+SUITE_PAR("test_distributor") {
+    struct hooks
+    {
+        std::atomic<int> setups{0};
+        std::atomic<int> teardowns{0};
+        bool             fail{false};
+    };
+    static auto
+    make_suites(hooks* h_) -> std::vector<testsuite_ptr> {
+        auto seq{testsuite::create("seq")};
+        seq->setup([h_] {
+            ++h_->setups;
+            if (h_->fail) {
+                throw std::logic_error("no setup");
+            }
+        });
+        seq->teardown([h_] { ++h_->teardowns; });
+        seq->test("a", [] { std::cout << "out"; });
+        seq->test("b", [] { ASSERT_TRUE(false); });
+        auto par{testsuite_parallel::create("par")};
+        par->setup([h_] { ++h_->setups; });
+        par->teardown([h_] { ++h_->teardowns; });
+        for (auto const* n : {"x", "x", "y", "z"}) {
+            par->test(n, [] {});
+        }
+        return {seq, par};
+    }
+    static auto
+    unknown_time(testsuite const&) -> double {
+        return std::numeric_limits<double>::infinity();
+    }
+    /// Connect a worker, that runs in a thread of this process on its own copy of the testsuites.
+    static auto
+    start_worker(std::deque<std::vector<testsuite_ptr>>& copies_, std::vector<std::thread>& threads_, hooks* h_)
+        -> std::unique_ptr<connection> {
+        int sv[2];
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        copies_.push_back(make_suites(h_));
+        auto& c{copies_.back()};
+        threads_.emplace_back([&c, sv] {
+            connection conn(sv[1]);
+            worker(c).serve(conn.chan());
+        });
+        return std::unique_ptr<connection>(new connection(sv[0]));
+    }
+
+    TEST("message encoding") {
+        auto const line{(message("RUN") << "a\tb\\c\nd" << 42 << 0.125 << "").encode()};
+        ASSERT_EQ(line.find('\n'), line.size() - 1);
+        auto const m{message::decode(line.substr(0, line.size() - 1))};
+        ASSERT_EQ(m.command(), std::string("RUN"));
+        ASSERT_EQ(m.size(), 4UL);
+        ASSERT_EQ(m.str(0), std::string("a\tb\\c\nd"));
+        ASSERT_EQ(m.num<int>(1), 42);
+        ASSERT_EQ(m.num<double>(2), 0.125);
+        ASSERT_EQ(m.str(3), std::string());
+        ASSERT_THROWS(m.str(4), std::runtime_error);
+        ASSERT_THROWS(m.num<int>(0), std::runtime_error);
+    };
+    TEST("message integers") {
+        auto const big{std::numeric_limits<std::uint64_t>::max()};
+        auto const m{message::decode(
+            (message("N") << big << (big - 1) << -7 << 1.5 << 300 << -1 << "99999999999999999999").encode())};
+        ASSERT_EQ(m.num<std::uint64_t>(0), big);
+        ASSERT_EQ(m.num<std::uint64_t>(1), big - 1);
+        ASSERT_EQ(m.num<int>(2), -7);
+        ASSERT_EQ(m.num<double>(2), -7.0);
+        ASSERT_EQ(m.num<double>(3), 1.5);
+        ASSERT_THROWS(m.num<int>(3), std::runtime_error);
+        ASSERT_THROWS(m.num<std::uint8_t>(4), std::runtime_error);
+        ASSERT_THROWS(m.num<std::size_t>(5), std::runtime_error);
+        ASSERT_THROWS(m.num<std::uint64_t>(6), std::runtime_error);
+        ASSERT_THROWS(m.num<bool>(4), std::runtime_error);
+    };
+    TEST("distribute testcases over workers") {
+        hooks                                  h;
+        std::deque<std::vector<testsuite_ptr>> copies;
+        std::vector<std::thread>               threads;
+        auto const                             suites = make_suites(&h);
+        std::vector<std::size_t> const         ids{0, 1};
+        tpp::intern::test::suite_graph const   graph(suites, &unknown_time);
+        std::vector<std::size_t>               done;
+        distributor                            uut(suites, ids, graph, ids,
+                        [&](std::size_t i_, std::exception_ptr const&) { done.push_back(i_); });
+        uut.add(start_worker(copies, threads, &h));
+        uut.add(start_worker(copies, threads, &h));
+        uut.run();
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t_) { t_.join(); });
+        std::sort(done.begin(), done.end());
+        ASSERT_EQ(done, ids);
+        ASSERT_EQ(suites[0]->testcases()[0].result(), testcase::HAS_PASSED);
+        ASSERT_EQ(suites[0]->testcases()[0].cout(), std::string("out"));
+        ASSERT_EQ(suites[0]->testcases()[1].result(), testcase::HAS_FAILED);
+        ASSERT_EQ(suites[0]->statistics().tests(), 2UL);
+        ASSERT_EQ(suites[0]->statistics().failures(), 1UL);
+        ASSERT_EQ(suites[1]->statistics().successes(), 4UL);
+        ASSERT_GT(h.setups.load(), 1);
+        ASSERT_EQ(h.setups.load(), h.teardowns.load());
+        // Only the copies of workers ran testcases.
+        ASSERT_EQ(copies[0][1]->testcases().size(), 4UL);
+    };
+    TEST("rerun the rest of a part after a worker was lost") {
+        hooks                                  h;
+        std::deque<std::vector<testsuite_ptr>> copies;
+        std::vector<std::thread>               threads;
+        auto const                             suites = make_suites(&h);
+        std::vector<std::size_t> const         ids{0, 1};
+        tpp::intern::test::suite_graph const   graph(suites, &unknown_time);
+        distributor uut(suites, ids, graph, ids, [](std::size_t, std::exception_ptr const&) {});
+        int         sv[2];
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        // Gets the first part, and quits without running it.
+        threads.emplace_back([sv] {
+            connection conn(sv[1]);
+            conn.chan().send(message("HELLO") << TPP_VERSION);
+            message m;
+            conn.chan().receive(m);
+        });
+        uut.add(std::unique_ptr<connection>(new connection(sv[0])));
+        uut.spawn_by([&](std::size_t) { return start_worker(copies, threads, &h); }, 1);
+        uut.run();
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t_) { t_.join(); });
+        ASSERT_EQ(suites[0]->testcases()[0].result(), testcase::HAD_ERROR);
+        ASSERT_EQ(suites[0]->testcases()[0].reason(),
+                  std::string("worker process was disconnected while running the testcase"));
+        ASSERT_EQ(suites[0]->testcases()[1].result(), testcase::HAS_FAILED);
+        ASSERT_EQ(suites[1]->statistics().successes(), 4UL);
+        ASSERT_EQ(copies.size(), 1UL);
+    };
+    TEST("connect workers over TCP") {
+        hooks                                  h;
+        std::deque<std::vector<testsuite_ptr>> copies;
+        auto const                             suites = make_suites(&h);
+        std::vector<std::size_t> const         ids{0, 1};
+        tpp::intern::test::suite_graph const   graph(suites, &unknown_time);
+        distributor uut(suites, ids, graph, ids, [](std::size_t, std::exception_ptr const&) {});
+        auto const  l{std::make_shared<listener>("127.0.0.1:0")};
+        auto const  addr{"localhost:" + std::to_string(l->port())};
+        uut.accept_from(l);
+        // Gets the first part, and quits without running it.
+        std::thread lost([addr] {
+            auto conn{connection::open(addr)};
+            conn->chan().send(message("HELLO") << TPP_VERSION);
+            message m;
+            conn->chan().receive(m);
+        });
+        copies.push_back(make_suites(&h));
+        std::thread rest([&] {
+            lost.join();
+            auto conn{connection::open(addr)};
+            worker(copies.back()).serve(conn->chan());
+        });
+        uut.run();
+        rest.join();
+        auto const probed{connection::open(addr)};
+        int        keepalive{0};
+        socklen_t  len{sizeof(keepalive)};
+        ASSERT_EQ(::getsockopt(probed->chan().fd(), SOL_SOCKET, SO_KEEPALIVE, &keepalive, &len), 0);
+        ASSERT_NOT_EQ(keepalive, 0);
+        ASSERT_EQ(suites[0]->testcases()[0].result(), testcase::HAD_ERROR);
+        ASSERT_EQ(suites[0]->testcases()[1].result(), testcase::HAS_FAILED);
+        ASSERT_EQ(suites[1]->statistics().successes(), 4UL);
+    };
+    TEST("addresses") {
+        std::string host;
+        std::string port;
+        ASSERT_TRUE(connection::split_address("[::1]:8080", host, port));
+        ASSERT_EQ(host, std::string("::1"));
+        ASSERT_EQ(port, std::string("8080"));
+        ASSERT_TRUE(connection::split_address("8080", host, port));
+        ASSERT_EQ(host, std::string());
+        ASSERT_FALSE(connection::split_address("host:", host, port));
+        ASSERT_FALSE(connection::split_address("host:http", host, port));
+        ASSERT_THROWS(connection::open("8080"), std::runtime_error);
+        ASSERT_THROWS(connection::open("fd:x"), std::runtime_error);
+        ASSERT_THROWS(listener("localhost:x"), std::runtime_error);
+        ASSERT_EQ(listener("0").host(), std::string("127.0.0.1"));
+        ASSERT_EQ(listener("0.0.0.0:0").host(), std::string("0.0.0.0"));
+    };
+    TEST("spawn workers of groups on demand") {
+        hooks                                  h;
+        std::deque<std::vector<testsuite_ptr>> copies;
+        std::vector<std::thread>               threads;
+        auto const                             suites = make_suites(&h);
+        std::vector<std::size_t> const         ids{0, 1};
+        tpp::intern::test::suite_graph const   graph(suites, &unknown_time);
+        std::vector<std::size_t>               spawned;
+        distributor uut(suites, ids, graph, ids, [](std::size_t, std::exception_ptr const&) {});
+        uut.group_by(ids);
+        uut.spawn_by(
+            [&](std::size_t g_) {
+                spawned.push_back(g_);
+                return start_worker(copies, threads, &h);
+            },
+            1);
+        uut.run();
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t_) { t_.join(); });
+        // The worker of the first group had to quit, before one of the second could be spawned.
+        ASSERT_EQ(spawned, ids);
+        ASSERT_EQ(suites[0]->statistics().failures(), 1UL);
+        ASSERT_EQ(suites[1]->statistics().successes(), 4UL);
+        ASSERT_EQ(h.setups.load(), 2);
+        ASSERT_EQ(h.teardowns.load(), 2);
+    };
+    TEST("list testsuites") {
+        hooks      h;
+        auto const suites = make_suites(&h);
+        suites[1]->depends_on("seq");
+        suites[1]->test(test_spec("t", tags("slow"), resource("db", 2)), [] {});
+        int sv[2];
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        std::thread t([&suites, sv] {
+            connection conn(sv[1]);
+            worker(suites).serve(conn.chan());
+        });
+        connection conn(sv[0]);
+        conn.chan().send(message("LIST"));
+        conn.chan().send(message("QUIT"));
+        std::vector<std::string> lines;
+        message                  m;
+        while (conn.chan().receive(m)) {
+            lines.push_back(m.encode());
+        }
+        t.join();
+        ASSERT_EQ(lines.size(), 11UL);
+        ASSERT_EQ(lines[1], (message("SUITE") << "seq" << false).encode());
+        ASSERT_EQ(lines[2], (message("TEST") << "a" << 0 << 0 << 0).encode());
+        ASSERT_EQ(lines[4], (message("SUITE") << "par" << true << "seq").encode());
+        ASSERT_EQ(lines[9], (message("TEST") << "t" << 0 << 0 << 1 << "slow" << "db" << 2).encode());
+        ASSERT_EQ(lines[10], message("END").encode());
+    };
+    TEST("errors of hooks") {
+        hooks                                  h;
+        std::deque<std::vector<testsuite_ptr>> copies;
+        std::vector<std::thread>               threads;
+        auto const                             suites = make_suites(&h);
+        std::vector<std::size_t> const         ids{0, 1};
+        tpp::intern::test::suite_graph const   graph(suites, &unknown_time);
+        std::vector<std::string>               errs(2);
+        distributor uut(suites, ids, graph, ids, [&](std::size_t i_, std::exception_ptr const& e_) {
+            if (e_) {
+                errs[i_] = worker::describe(e_);
+            }
+        });
+        h.fail = true;
+        uut.add(start_worker(copies, threads, &h));
+        uut.run();
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t_) { t_.join(); });
+        ASSERT_EQ(errs[0], std::string("[std::runtime_error] >seq< [std::logic_error] no setup"));
+        ASSERT_EQ(errs[1], std::string());
+        ASSERT_EQ(suites[0]->statistics().skipped(), 2UL);
+        ASSERT_EQ(suites[1]->statistics().successes(), 4UL);
+    };
+    TEST("spawn workers from this executable") {
+        if (connection::self("").empty()) {
+            return;
+        }
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.report_fmt         = config::report_format::XML;
+        c.jobs               = 2;
+        c.f_mode             = config::filter_mode::INCLUDE;
+        c.f_patterns.add("test_manifest");
+        runner r(registry::instance());
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_NOT_EQ(oss.str().find("name=\"test_manifest\" errors=\"0\""), std::string::npos);
+    };
+    TEST("aggregate binaries") {
+        auto const self{connection::self("")};
+        if (self.empty()) {
+            return;
+        }
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.report_fmt         = config::report_format::XML;
+        c.jobs               = 2;
+        c.f_mode             = config::filter_mode::INCLUDE;
+        c.f_patterns.add("test_manifest");
+        ASSERT_EQ(aggregator().run({self, self}, c), 0);
+        auto const first{oss.str().find("name=\"test_manifest\" errors=\"0\"")};
+        ASSERT_NOT_EQ(first, std::string::npos);
+        ASSERT_NOT_EQ(oss.str().find("name=\"test_manifest\" errors=\"0\"", first + 1), std::string::npos);
+        ASSERT_NOT_EQ(aggregator().run({self, "/nonexistent"}, c), 0);
+    };
+};
+#endif
+
+SUITE("test_run_cache") {
+    char const* const t_file = "tpp_test_run_cache";
+
+    AFTER_EACH() {
+        std::remove(t_file);
+    };
+
+    TEST("schedule") {
+        run_cache     uut;
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->test("fast", [] {});
+        ts->test("slow", [] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+        ts->run();
+        uut.update(*ts);
+        ASSERT_EQ(uut.schedule(*ts), (std::vector<std::size_t>{1, 0}));
+        ts->test("new", [] {});
+        ASSERT_EQ(uut.schedule(*ts), (std::vector<std::size_t>{2, 1, 0}));
+        testsuite_ptr ts2 = testsuite::create("ts2");
+        ASSERT_TRUE(std::isinf(uut.time(*ts2)));
+        ASSERT_EQ(uut.schedule(std::vector<testsuite_ptr>{ts, ts2}), (std::vector<std::size_t>{1, 0}));
+    };
+    TEST("save and load") {
+        run_cache     uut;
+        testsuite_ptr ts = testsuite::create("t\ts");
+        ts->test("", [] {});
+        ts->test("line\nbreak", [] {});
+        ts->run();
+        uut.update(*ts);
+        uut.save(t_file);
+        run_cache loaded;
+        loaded.load(t_file);
+        ASSERT_EQ(loaded.time(*ts), uut.time(*ts));
+        ASSERT_EQ(loaded.time(ts->testcases().at(0)), uut.time(ts->testcases().at(0)));
+        ASSERT_EQ(loaded.time(ts->testcases().at(1)), uut.time(ts->testcases().at(1)));
+        ASSERT_LT(loaded.time(ts->testcases().at(1)), std::numeric_limits<double>::infinity());
+    };
+    TEST("failed testcases") {
+        run_cache     uut;
+        testsuite_ptr ts = testsuite::create("t\ts");
+        ts->test("pass", [] {});
+        ts->test("fail", [] { ASSERT_TRUE(false); });
+        ts->test("error", [] { throw std::logic_error(""); });
+        ts->run();
+        uut.update(*ts);
+        uut.save(t_file);
+        run_cache loaded;
+        loaded.load(t_file);
+        ASSERT_FALSE(loaded.failed(ts->testcases().at(0)));
+        ASSERT_TRUE(loaded.failed(ts->testcases().at(1)));
+        ASSERT_TRUE(loaded.failed(ts->testcases().at(2)));
+        ASSERT_TRUE(loaded.failed(*ts));
+        ASSERT_FALSE(loaded.failed(*testsuite::create("t")));
+        testsuite_ptr fixed = testsuite::create("t\ts");
+        fixed->test("fail", [] {});
+        fixed->test("error", [] {});
+        fixed->run();
+        loaded.update(*fixed);
+        ASSERT_FALSE(loaded.failed(*ts));
+    };
+    TEST("failed first") {
+        run_cache     uut;
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->test("fast", [] { ASSERT_TRUE(false); });
+        ts->test("slow", [] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+        ts->run();
+        uut.update(*ts);
+        ASSERT_EQ(uut.schedule(*ts), (std::vector<std::size_t>{1, 0}));
+        uut.failed_first();
+        ASSERT_EQ(uut.schedule(*ts), (std::vector<std::size_t>{0, 1}));
+        testsuite_ptr ts2 = testsuite::create("ts2");
+        ASSERT_EQ(uut.schedule(std::vector<testsuite_ptr>{ts2, ts}), (std::vector<std::size_t>{1, 0}));
+    };
+    TEST("rerun failed in runner") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.cache_file         = t_file;
+        std::vector<std::string> ran;
+        bool                     fixed{false};
+        auto const               make_suites{[&] {
+            auto ts1 = testsuite::create("ts1");
+            auto ts2 = testsuite::create("ts2");
+            ts1->test("pass", [&] { ran.push_back("pass"); });
+            ts2->test("pass", [&] { ran.push_back("pass"); });
+            ts2->test("fail", [&] {
+                ran.push_back("fail");
+                ASSERT_TRUE(fixed);
+            });
+            return std::vector<testsuite_ptr>{ts1, ts2};
+        }};
+        runner r1;
+        for (auto const& ts : make_suites()) {
+            r1.add_testsuite(ts);
+        }
+        ASSERT_EQ(r1.run(c), 1);
+        ASSERT_EQ(ran.size(), 3UL);
+        ran.clear();
+        fixed          = true;
+        c.rerun_failed = true;
+        runner r2;
+        for (auto const& ts : make_suites()) {
+            r2.add_testsuite(ts);
+        }
+        ASSERT_EQ(r2.run(c), 0);
+        ASSERT_EQ(ran, (std::vector<std::string>{"fail"}));
+        ran.clear();
+        runner r3;
+        for (auto const& ts : make_suites()) {
+            r3.add_testsuite(ts);
+        }
+        ASSERT_EQ(r3.run(c), 0);
+        ASSERT_TRUE(ran.empty());
+        c.cache_file.clear();
+        ASSERT_EQ(runner().run(c), -2);
+    };
+    TEST("load missing file") {
+        run_cache uut;
+        ASSERT_NOTHROW(uut.load(t_file));
+    };
+    TEST("longest first in runner") {
+        std::ostringstream       oss;
+        std::vector<std::size_t> order;
+        config                   c;
+        c.report_cfg.ostream = &oss;
+        c.cache_file         = t_file;
+        c.thd_count          = 1;
+        auto const make_suite{[&] {
+            auto ts = testsuite_parallel::create("ts");
+            ts->test("fast", [&] { order.push_back(0); });
+            ts->test("slow", [&] {
+                order.push_back(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            });
+            return ts;
+        }};
+        runner r1;
+        r1.add_testsuite(make_suite());
+        ASSERT_EQ(r1.run(c), 0);
+        ASSERT_EQ(order, (std::vector<std::size_t>{0, 1}));
+        order.clear();
+        runner r2;
+        r2.add_testsuite(make_suite());
+        ASSERT_EQ(r2.run(c), 0);
+        ASSERT_EQ(order, (std::vector<std::size_t>{1, 0}));
+    };
+    TEST("balanced shards") {
+        run_cache     cache;
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->test("slow", [] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+        ts->test("medium", [] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+        ts->test("fast", [] {});
+        ts->run();
+        cache.update(*ts);
+        testsuite_ptr s0 = testsuite::create("ts");
+        testsuite_ptr s1 = testsuite::create("ts");
+        for (auto const& s : {s0, s1}) {
+            s->test("slow", [] {});
+            s->test("medium", [] {});
+            s->test("fast", [] {});
+        }
+        shard{0, 2}.apply({s0}, cache);
+        shard{1, 2}.apply({s1}, cache);
+        ASSERT_EQ(s0->testcases().size(), 1UL);
+        ASSERT_EQ(s0->testcases().at(0).name(), std::string("slow"));
+        ASSERT_EQ(s1->testcases().size(), 2UL);
+    };
+};
+
+SUITE("test_baseline") {
+    char const* const t_file = "tpp_test_baseline";
+
+    AFTER_EACH() {
+        std::remove(t_file);
+    };
+
+    static auto
+    bench(std::vector<double> const& samples_) -> testcase {
+        testcase    tc({"b\tc", "ts"}, [] {});
+        measurement m;
+        m.iterations(1);
+        std::for_each(samples_.cbegin(), samples_.cend(), [&](double s_) { m.add(s_); });
+        tc.measured(std::move(m));
+        tc.result(testcase::HAS_PASSED, 1.0, "");
+        return tc;
+    }
+
+    TEST("mann whitney") {
+        std::vector<double> const low{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        std::vector<double> const high{11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+        ASSERT_LT(baseline::p_slower(low, high), 1e-3);
+        ASSERT_GT(baseline::p_slower(high, low), 0.999);
+        ASSERT_GT(baseline::p_slower(low, low), 0.4);
+        ASSERT_EQ(baseline::p_slower({1, 1, 1}, {1, 1, 1}), 1.0);
+        ASSERT_EQ(baseline::p_slower({}, low), 1.0);
+    };
+    TEST("compare") {
+        baseline uut;
+        uut.update(bench({100, 101, 99, 100, 102, 98, 100, 101, 99, 100}));
+        auto same = bench({101, 99, 100, 100, 102, 98, 101, 100, 99, 100});
+        uut.compare(same);
+        ASSERT_EQ(same.result(), testcase::HAS_PASSED);
+        auto slower = bench({110, 111, 109, 110, 112, 108, 110, 111, 109, 110});
+        uut.compare(slower);
+        ASSERT_EQ(slower.result(), testcase::HAS_FAILED);
+        ASSERT_EQ(slower.reason().find("regressed by 10% against the baseline median of 100ns"), 0UL);
+        uut.update(slower);
+        auto again = bench({110, 111, 109, 110, 112, 108, 110, 111, 109, 110});
+        uut.compare(again);
+        ASSERT_EQ(again.result(), testcase::HAS_FAILED);
+        auto tolerated = bench({104, 105, 103, 104, 106, 102, 104, 105, 103, 104});
+        uut.compare(tolerated);
+        ASSERT_EQ(tolerated.result(), testcase::HAS_PASSED);
+        uut.thresholds(2.0, 0.01);
+        uut.compare(tolerated);
+        ASSERT_EQ(tolerated.result(), testcase::HAS_FAILED);
+        testcase unknown({"other", "ts"}, [] {});
+        unknown.result(testcase::HAS_PASSED, 1.0, "");
+        uut.compare(unknown);
+        ASSERT_EQ(unknown.result(), testcase::HAS_PASSED);
+    };
+    TEST("save and load") {
+        baseline saved;
+        saved.update(bench({100.125, 101, 99, 100, 102, 98, 100, 101, 99, 100}));
+        saved.save(t_file);
+        baseline uut;
+        ASSERT_NOTHROW(uut.load("tpp_test_baseline_missing"));
+        uut.load(t_file);
+        auto slower = bench({110, 111, 109, 110, 112, 108, 110, 111, 109, 110});
+        uut.compare(slower);
+        ASSERT_EQ(slower.result(), testcase::HAS_FAILED);
+    };
+    TEST("regressions in runner") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.save_baseline      = t_file;
+        auto const make_suite{[](int n_) {
+            auto ts = testsuite::create("ts");
+            ts->test(test_spec("bench", benchmark()), [n_] {
+                for (int i = 0; i < n_; ++i) {
+                    do_not_optimize(i);
+                }
+            });
+            ts->test("test", [] {});
+            return ts;
+        }};
+        auto const read_file{[&] {
+            std::ifstream     in(t_file);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }};
+        runner r1;
+        r1.add_testsuite(make_suite(10));
+        ASSERT_EQ(r1.run(c), 0);
+        auto const saved{read_file()};
+        ASSERT_FALSE(saved.empty());
+        c.compare_baseline = t_file;
+        runner r2;
+        r2.add_testsuite(make_suite(10000));
+        ASSERT_EQ(r2.run(c), 1);
+        ASSERT_NOT_EQ(oss.str().find("regressed by"), std::string::npos);
+        // The regressed samples do not replace the baseline, that they were compared to.
+        ASSERT_EQ(read_file(), saved);
+    };
 };
 
 SUITE("test_testsuite") {
+    TEST("parallel safe testcases") {
+        thread_pool              pool(4);
+        testsuite_ptr            ts = testsuite::create("ts");
+        std::atomic<int>         arrived{0};
+        std::vector<std::string> order;
+        std::mutex               mtx;
+        auto const               log{[&](char const* e_) {
+            std::lock_guard<std::mutex> lk(mtx);
+            order.push_back(e_);
+        }};
+        ts->test("", [&] { log("first"); });
+        for (int i = 0; i < 4; ++i) {
+            ts->test(test_spec("", parallel_safe()), [&] {
+                ++arrived;
+                for (int j = 0; j < 1000 && arrived.load() < 4; ++j) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                ASSERT_EQ(arrived.load(), 4);
+                log("parallel");
+            });
+        }
+        ts->test("", [&] { log("last"); });
+        ts->test(test_spec("", parallel_safe()), [] { ASSERT_TRUE(false); });
+        ts->run(pool);
+        ASSERT_EQ(ts->statistics().successes(), 6UL);
+        ASSERT_EQ(ts->statistics().failures(), 1UL);
+        ASSERT_EQ(order, (std::vector<std::string>{"first", "parallel", "parallel", "parallel", "parallel", "last"}));
+    };
+    TEST("keep by index") {
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->test("a", [] {});
+        ts->test("b", [] {});
+        ts->test("c", [] {});
+        ts->keep({1, 0, 1});
+        ASSERT_EQ(ts->testcases().size(), 2UL);
+        ASSERT_EQ(std::string(ts->testcases()[0].name()), "a");
+        ASSERT_EQ(std::string(ts->testcases()[1].name()), "c");
+        ts->keep({0});
+        ASSERT_TRUE(ts->testcases().empty());
+    };
     TEST("creation") {
         auto a = std::chrono::system_clock::now();
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -511,6 +2091,222 @@ SUITE("test_testsuite") {
         }
         ASSERT_LT(t, ts->statistics().elapsed_time());
     };
+#ifdef TPP_INTERN_SYS_UNIX
+    TEST("isolated") {
+        int           i  = 0;
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->isolate();
+        ts->before_each([&i] { ++i; });
+        ts->test("", [] { std::cout << "out"; });
+        ts->test("", [] { ASSERT_TRUE(false); });
+        ts->test("", [] { std::abort(); });
+        ts->test("", [] { std::exit(3); });
+        ts->run();
+        ASSERT_EQ(i, 0);
+        statistic const& stat = ts->statistics();
+        ASSERT_EQ(stat.successes(), 1UL);
+        ASSERT_EQ(stat.failures(), 1UL);
+        ASSERT_EQ(stat.errors(), 2UL);
+        ASSERT_EQ(ts->testcases().at(0).cout(), "out");
+        ASSERT_GT(ts->testcases().at(0).elapsed_time(), .0);
+        ASSERT_TRUE(ts->testcases().at(1).reason().find("Expected") != std::string::npos);
+        ASSERT_TRUE(ts->testcases().at(2).reason().find("killed by signal") != std::string::npos);
+        ASSERT_TRUE(ts->testcases().at(3).reason().find("exited with code 3") != std::string::npos);
+    };
+    TEST("isolated hook error") {
+        testsuite_ptr ts = testsuite::create("ts");
+        ts->isolate();
+        ts->after_each([] { throw std::logic_error("hook"); });
+        ts->test("", [] {});
+        ASSERT_THROWS(ts->run(), std::runtime_error);
+    };
+    TEST("isolated in parallel") {
+        testsuite_ptr ts = testsuite_parallel::create("ts");
+        ts->isolate();
+        for (int k = 0; k < 8; ++k) {
+            ts->test("", [] { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+        }
+        thread_pool pool(8);
+        ts->run(pool);
+        ASSERT_EQ(ts->statistics().successes(), 8UL);
+        ASSERT_LT(ts->statistics().elapsed_time(), 800.0);
+    };
+    TEST("isolated within isolation") {
+        testsuite_ptr ts = testsuite_parallel::create("ts");
+        ts->isolate();
+        for (int k = 0; k < 4; ++k) {
+            ts->test("", [] {
+                testsuite_ptr inner = testsuite_parallel::create("inner");
+                inner->isolate();
+                for (int j = 0; j < 4; ++j) {
+                    inner->test("", [] {});
+                }
+                thread_pool pool(4);
+                inner->run(pool);
+                ASSERT_EQ(inner->statistics().successes(), 4UL);
+            });
+        }
+        thread_pool pool(4);
+        ts->run(pool);
+        ASSERT_EQ(ts->statistics().successes(), 4UL);
+    };
+#endif
+    TEST("timeout") {
+        testsuite_ptr ts = testsuite::create("ts");
+        int           n{0};
+        ts->timeout(100);
+        ts->test(test_spec("", timeout(50)), [] { std::this_thread::sleep_for(std::chrono::milliseconds(500)); });
+        ts->test("", [&] {
+            ++n;
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        });
+        ts->test("", [&] { ++n; });
+        ts->run();
+        ASSERT_EQ(ts->statistics().errors(), 2UL);
+        ASSERT_EQ(ts->statistics().successes(), 1UL);
+        ASSERT_TRUE(ts->testcases().at(0).attributes().isolated);
+        ASSERT_TRUE(ts->testcases().at(0).reason().find("timed out after 50ms") == 0);
+        ASSERT_TRUE(ts->testcases().at(1).reason().find("timed out after 100ms") == 0);
+        // Testcases, that are not isolated, are checked afterwards, and keep their side effects.
+        ASSERT_EQ(n, 2);
+#ifdef TPP_INTERN_SYS_UNIX
+        ASSERT_TRUE(ts->testcases().at(0).reason().find("stack trace") != std::string::npos);
+        ASSERT_LT(ts->testcases().at(0).elapsed_time(), 400.0);
+#endif
+    };
+    TEST("repeat") {
+        int  n{0};
+        auto ts = testsuite::create("ts");
+        ts->test("flaky", [&] {
+            ++n;
+            std::cout << n;
+            ASSERT_NOT_EQ(n % 3, 0);
+        });
+        ts->test("pass", [] {});
+        ts->repeat(7, false);
+        ts->run();
+        ASSERT_EQ(n, 7);
+        auto const& tc = ts->testcases().at(0);
+        ASSERT_EQ(tc.result(), testcase::HAS_FAILED);
+        ASSERT_EQ(tc.cout(), "3");
+        ASSERT_EQ(tc.repetitions().runs(), 7UL);
+        ASSERT_EQ(tc.repetitions().failures(), 2UL);
+        ASSERT_EQ(ts->testcases().at(1).result(), testcase::HAS_PASSED);
+        ASSERT_EQ(ts->testcases().at(1).repetitions().runs(), 7UL);
+        ASSERT_EQ(ts->statistics().failures(), 1UL);
+        ASSERT_EQ(ts->statistics().tests(), 2UL);
+    };
+    TEST("repeat until fail") {
+        int  n{0};
+        auto ts = testsuite_parallel::create("ts");
+        ts->test("flaky", [&] { ASSERT_LT(++n, 42); });
+        ts->repeat(100, true);
+        sequential_executor exec;
+        ts->run(exec);
+        ASSERT_EQ(n, 42);
+        ASSERT_EQ(ts->testcases().at(0).result(), testcase::HAS_FAILED);
+        ASSERT_EQ(ts->testcases().at(0).repetitions().runs(), 42UL);
+        ASSERT_EQ(ts->testcases().at(0).repetitions().failures(), 1UL);
+    };
+    TEST("attributes", timeout(60000), tags("meta")) {
+        ASSERT_EQ(test_spec("").attrs.timeout, .0);
+        ASSERT_EQ(test_spec("", timeout(1)).attrs.timeout, 1.0);
+        ASSERT_TRUE(test_spec("").attrs.tags.empty());
+        auto const t = test_spec("", tags("a", "b"), tags("c")).attrs.tags;
+        ASSERT_EQ(t.size(), 3UL);
+        ASSERT_EQ(std::string(t.at(0)) + t.at(1) + t.at(2), "abc");
+        ASSERT_FALSE(test_spec("").attrs.isolated);
+        ASSERT_TRUE(test_spec("", isolated()).attrs.isolated);
+    };
+};
+
+SUITE_PAR("test_repetition") {
+    TEST("percentiles") {
+        repetition uut;
+        ASSERT_EQ(uut.runs(), 0UL);
+        ASSERT_EQ(uut.median(), .0);
+        for (int i = 100; i > 0; --i) {
+            uut.add(static_cast<double>(i), i % 10 == 0);
+        }
+        ASSERT_EQ(uut.runs(), 100UL);
+        ASSERT_EQ(uut.failures(), 10UL);
+        ASSERT_EQ(uut.min(), 1.0);
+        ASSERT_EQ(uut.median(), 50.0);
+        ASSERT_EQ(uut.p99(), 99.0);
+        ASSERT_EQ(uut.percentile(100), 100.0);
+    };
+};
+
+SUITE_PAR("test_benchmark") {
+    TEST("statistics") {
+        measurement uut;
+        ASSERT_EQ(uut.mean(), .0);
+        ASSERT_EQ(uut.median(), .0);
+        ASSERT_EQ(uut.stddev(), .0);
+        for (double s : {4.0, 1.0, 3.0, 2.0}) {
+            uut.add(s);
+        }
+        ASSERT_EQ(uut.samples().size(), 4UL);
+        ASSERT_EQ(uut.mean(), 2.5);
+        ASSERT_EQ(uut.median(), 2.5);
+        ASSERT_EQ(uut.min(), 1.0);
+        ASSERT_EQ(uut.max(), 4.0);
+        ASSERT_LT(std::abs(uut.stddev() - std::sqrt(5.0 / 3.0)), 1e-9);
+        uut.add(10.0);
+        ASSERT_EQ(uut.median(), 3.0);
+    };
+    TEST("calibrate iterations") {
+        std::size_t n{0};
+        auto const  m = tpp::intern::test::benchmark::measure(
+            [&] {
+                ++n;
+                do_not_optimize(n);
+            },
+            3, 1.0);
+        ASSERT_EQ(m.samples().size(), 3UL);
+        ASSERT_GT(m.iterations(), 1UL);
+        ASSERT_GT(n, m.iterations() * 3);
+        ASSERT_GT(m.min(), .0);
+        // Every sample takes at least about 1ms.
+        ASSERT_GT(m.mean() * static_cast<double>(m.iterations()), 5e5);
+    };
+    TEST("benchmark testcases") {
+        auto ts = testsuite::create("ts");
+        ts->test(test_spec("pass", benchmark()), [] {
+            std::vector<int> v{3, 1, 2};
+            std::sort(v.begin(), v.end());
+            do_not_optimize(v);
+            clobber_memory();
+        });
+        ts->test(test_spec("fail", benchmark()), [] { ASSERT_TRUE(false); });
+        ts->test(test_spec("serial", serial(), benchmark()), [] {});
+        ts->run();
+        auto const& pass{ts->testcases().at(0)};
+        ASSERT_EQ(pass.result(), testcase::HAS_PASSED);
+        ASSERT_EQ(pass.measured().samples().size(), 20UL);
+        ASSERT_GT(pass.measured().iterations(), 0UL);
+        ASSERT_TRUE(pass.attributes().benchmark);
+        ASSERT_EQ(pass.attributes().mode, tpp::intern::test::concurrency::EXCLUSIVE);
+        ASSERT_EQ(ts->testcases().at(1).result(), testcase::HAS_FAILED);
+        ASSERT_TRUE(ts->testcases().at(1).measured().samples().empty());
+        ASSERT_EQ(ts->testcases().at(2).attributes().mode, tpp::intern::test::concurrency::SERIAL);
+    };
+    TEST("transfer measurements") {
+        testcase tc({"b", "ts"}, [] {}, test_spec("", benchmark()).attrs);
+        tc();
+        testcase uut({"b", "ts"}, [] {});
+        worker::apply(worker::result("0", 0, tc), uut);
+        ASSERT_EQ(uut.measured().iterations(), tc.measured().iterations());
+        ASSERT_EQ(uut.measured().samples(), tc.measured().samples());
+        ASSERT_TRUE(uut.repetitions().times().empty());
+#ifdef TPP_INTERN_SYS_UNIX
+        auto ts = testsuite::create("ts");
+        ts->test(test_spec("b", benchmark()), [] {});
+        ts->isolate();
+        ts->run();
+        ASSERT_EQ(ts->testcases().at(0).measured().samples().size(), 20UL);
+#endif
+    };
 };
 
 SUITE_PAR("test_testcase") {
@@ -547,6 +2343,22 @@ SUITE_PAR("test_testcase") {
         ASSERT_EQ(tc2.result(), testcase::HAD_ERROR);
         ASSERT(tc2.elapsed_time(), GT, 0.0);
         ASSERT(tc2.reason(), EQ, std::string("unknown error"));
+    };    TEST("move") {
+        testcase tc({"t1", "ctx"}, [] {}, test_spec("", tags("a")).attrs);
+        tc.result(testcase::HAS_FAILED, 1.0, "reason");
+        tc.cout("out");
+        tc.cerr("err");
+        testcase moved(std::move(tc));
+        ASSERT_EQ(moved.result(), testcase::HAS_FAILED);
+        ASSERT_EQ(moved.reason(), std::string("reason"));
+        ASSERT_EQ(moved.cout(), std::string("out"));
+        ASSERT_EQ(moved.cerr(), std::string("err"));
+        ASSERT_EQ(moved.attributes().tags.size(), 1UL);
+        testcase assigned({"t2", "ctx"}, [] {});
+        assigned = std::move(moved);
+        ASSERT_EQ(assigned.cout(), std::string("out"));
+        ASSERT_EQ(assigned.cerr(), std::string("err"));
+        ASSERT_EQ(std::string(assigned.name()), "t1");
     };
 };
 
@@ -729,6 +2541,74 @@ SUITE("test_reporters") {
         t_ss.clear();
     }
 
+    TEST("prepared testcases") {
+        for (auto strip : {false, true}) {
+            t_cfg.strip = strip;
+            for (auto const make : {&reporter_factory::make<console_reporter>, &reporter_factory::make<xml_reporter>,
+                                    &reporter_factory::make<json_reporter>,
+                                    &reporter_factory::make<markdown_reporter>}) {
+                auto sync = make(t_cfg);
+                sync->begin_report();
+                sync->report(t_ts);
+                sync->report(t_ts);
+                sync->end_report();
+                auto const expected{t_ss.str()};
+                t_ss.str("");
+                auto uut = make(t_cfg);
+                uut->begin_report();
+                for (int k = 0; k < 2; ++k) {
+                    for (auto const& tc : t_ts->testcases()) {
+                        uut->prepare(tc);
+                    }
+                    uut->report(t_ts);
+                }
+                uut->end_report();
+                ASSERT_EQ(t_ss.str(), expected);
+                t_ss.str("");
+            }
+        }
+    };
+    TEST("repeated testcases") {
+        auto ts = testsuite::create("testsuite");
+        ts->test("test", [] {});
+        ts->repeat(3, false);
+        ts->run();
+        for (auto const& e :
+             std::vector<std::pair<decltype(&reporter_factory::make<console_reporter>), std::string>>{
+                 {&reporter_factory::make<console_reporter>, "runs = 3, failed = 0, min = "},
+                 {&reporter_factory::make<xml_reporter>, "runs=\"3\" failed_runs=\"0\" min=\""},
+                 {&reporter_factory::make<json_reporter>, "\"failed_runs\": 0,"},
+                 {&reporter_factory::make<markdown_reporter>, "PASSED (0/3 failed)|"}}) {
+            auto uut = e.first(t_cfg);
+            uut->begin_report();
+            uut->report(ts);
+            uut->end_report();
+            ASSERT_NOT_EQ(t_ss.str().find(e.second), std::string::npos);
+            t_ss.str("");
+        }
+    };
+    TEST("benchmarked testcases") {
+        auto ts = testsuite::create("testsuite");
+        ts->test(test_spec("bench", benchmark()), [] {});
+        ts->run();
+        for (auto const& e :
+             std::vector<std::pair<decltype(&reporter_factory::make<console_reporter>), std::string>>{
+                 {&reporter_factory::make<console_reporter>,
+                  R"(iterations = \d+, mean = \S+ns, median = \S+ns, stddev = \S+ns, min = \S+ns, max = \S+ns)"},
+                 {&reporter_factory::make<xml_reporter>,
+                  R"(iterations="\d+" mean_ns="\S+" median_ns="\S+" stddev_ns="\S+" min_ns="\S+" max_ns="\S+")"},
+                 {&reporter_factory::make<json_reporter>,
+                  R"("iterations": \d+,\s+"mean_ns": \S+,\s+"median_ns": \S+,\s+"stddev_ns": \S+,\s+"min_ns": )"},
+                 {&reporter_factory::make<markdown_reporter>,
+                  R"(\(\d+ iterations, mean \S+ns, median \S+ns, stddev \S+ns, min \S+ns, max \S+ns\)\|PASSED)"}}) {
+            auto uut = e.first(t_cfg);
+            uut->begin_report();
+            uut->report(ts);
+            uut->end_report();
+            ASSERT_LIKE(t_ss.str(), std::regex(e.second));
+            t_ss.str("");
+        }
+    };
     TEST("console_reporter") {
         auto uut = reporter_factory::make<console_reporter>(t_cfg);
         uut->begin_report();
@@ -998,15 +2878,16 @@ SUITE("test_reporters") {
         ASSERT_EQ(line, "## testsuite");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_EQ(line, "|Tests|Successes|Failures|Errors|Time|");
+        ASSERT_EQ(line, "|Tests|Successes|Failures|Errors|Skipped|Time|");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_EQ(line, "|-|-|-|-|-|");
+        ASSERT_EQ(line, "|-|-|-|-|-|-|");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_MATCH(line, "\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|\\d+\\.\\d+ms\\|"_re, m);
+        ASSERT_MATCH(line, "\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|\\d+\\.\\d+ms\\|"_re, m);
         ASSERT_EQ(m.str(1), "3");
         ASSERT_EQ(m.str(2), "1");
         ASSERT_EQ(m.str(3), "1");
         ASSERT_EQ(m.str(4), "1");
+        ASSERT_EQ(m.str(5), "0");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
         ASSERT_EQ(line, "### Tests");
@@ -1083,15 +2964,16 @@ SUITE("test_reporters") {
         ASSERT_EQ(line, "## Summary");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_EQ(line, "|Tests|Successes|Failures|Errors|Time|");
+        ASSERT_EQ(line, "|Tests|Successes|Failures|Errors|Skipped|Time|");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_EQ(line, "|-|-|-|-|-|");
+        ASSERT_EQ(line, "|-|-|-|-|-|-|");
         ASSERT_TRUE(bool(std::getline(t_ss, line)));
-        ASSERT_MATCH(line, "\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|\\d+\\.\\d+ms\\|"_re, m);
+        ASSERT_MATCH(line, "\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|(\\d+)\\|\\d+\\.\\d+ms\\|"_re, m);
         ASSERT_EQ(m.str(1), "3");
         ASSERT_EQ(m.str(2), "1");
         ASSERT_EQ(m.str(3), "1");
         ASSERT_EQ(m.str(4), "1");
+        ASSERT_EQ(m.str(5), "0");
     };
     TEST("xml_reporter") {
         std::smatch m;
@@ -1222,7 +3104,7 @@ SUITE_PAR("test_cmdline_parser") {
         ASSERT_FALSE(c.report_cfg.strip);
         ASSERT_NULL(c.report_cfg.ostream);
         ASSERT_TRUE(c.report_cfg.outfile.empty());
-        ASSERT_EQ(c.thd_count, omp_get_max_threads());
+        ASSERT_EQ(c.thd_count, static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U)));
     };
     TEST("report formats") {
         cmdline_parser             uut;
@@ -1416,6 +3298,134 @@ SUITE_PAR("test_cmdline_parser") {
         std::array<char const*, 3> argv{"test", "-t", "-1"};
         ASSERT_THROWS(uut.parse(argv.size(), argv.data()), std::runtime_error);
     };
+    TEST("cache file") {
+        cmdline_parser             uut;
+        std::array<char const*, 2> argv1{"test", "--cache"};
+        std::array<char const*, 3> argv2{"test", "--cache", "file"};
+        ASSERT_THROWS(uut.parse(argv1.size(), argv1.data()), std::runtime_error);
+        uut.parse(argv2.size(), argv2.data());
+        ASSERT_EQ(uut.config().cache_file, "file");
+    };
+    TEST("parallel suites") {
+        cmdline_parser             uut;
+        std::array<char const*, 1> argv1{"test"};
+        std::array<char const*, 2> argv2{"test", "-p"};
+        std::array<char const*, 2> argv3{"test", "--parallel-suites"};
+        uut.parse(argv1.size(), argv1.data());
+        ASSERT_FALSE(uut.config().parallel_suites);
+        uut.parse(argv2.size(), argv2.data());
+        ASSERT_TRUE(uut.config().parallel_suites);
+        cmdline_parser uut2;
+        uut2.parse(argv3.size(), argv3.data());
+        ASSERT_TRUE(uut2.config().parallel_suites);
+    };
+    TEST("timeout") {
+        cmdline_parser             uut;
+        std::array<char const*, 4> argv{"test", "--timeout", "100", "--isolate"};
+        uut.parse(argv.size(), argv.data());
+        ASSERT_EQ(uut.config().timeout, 100);
+        cmdline_parser             unisolated;
+        std::array<char const*, 3> argv2{"test", "--timeout", "100"};
+        ASSERT_THROWS(unisolated.parse(argv2.size(), argv2.data()), std::runtime_error);
+    };
+    TEST("fail fast") {
+        cmdline_parser             uut;
+        std::array<char const*, 2> argv1{"test", "--fail-fast"};
+        std::array<char const*, 2> argv2{"test", "--fail-fast=3"};
+        std::array<char const*, 2> argv3{"test", "--fail-fast=0"};
+        ASSERT_EQ(uut.config().fail_fast, 0);
+        uut.parse(argv1.size(), argv1.data());
+        ASSERT_EQ(uut.config().fail_fast, 1);
+        uut.parse(argv2.size(), argv2.data());
+        ASSERT_EQ(uut.config().fail_fast, 3);
+        ASSERT_THROWS(uut.parse(argv3.size(), argv3.data()), std::runtime_error);
+    };
+    TEST("rerun failed") {
+        cmdline_parser             uut;
+        std::array<char const*, 3> argv{"test", "--rerun-failed", "--failed-first"};
+        ASSERT_FALSE(uut.config().rerun_failed);
+        ASSERT_FALSE(uut.config().failed_first);
+        uut.parse(argv.size(), argv.data());
+        ASSERT_TRUE(uut.config().rerun_failed);
+        ASSERT_TRUE(uut.config().failed_first);
+    };
+    TEST("repeat") {
+        cmdline_parser             uut;
+        std::array<char const*, 4> argv{"test", "--repeat", "10", "--until-fail"};
+        ASSERT_EQ(uut.config().repeat, 0);
+        ASSERT_FALSE(uut.config().until_fail);
+        uut.parse(argv.size(), argv.data());
+        ASSERT_EQ(uut.config().repeat, 10);
+        ASSERT_TRUE(uut.config().until_fail);
+        cmdline_parser             unbounded;
+        std::array<char const*, 2> argv2{"test", "--until-fail"};
+        ASSERT_THROWS(unbounded.parse(argv2.size(), argv2.data()), std::runtime_error);
+    };
+    TEST("isolate") {
+        cmdline_parser             uut;
+        std::array<char const*, 2> argv{"test", "--isolate"};
+        ASSERT_FALSE(uut.config().isolated);
+        uut.parse(argv.size(), argv.data());
+        ASSERT_TRUE(uut.config().isolated);
+    };
+    TEST("list") {
+        cmdline_parser             uut;
+        std::array<char const*, 2> argv1{"test", "--list"};
+        std::array<char const*, 2> argv2{"test", "--list=json"};
+        std::array<char const*, 2> argv3{"test", "--list=yaml"};
+        ASSERT_EQ(uut.config().list_fmt, config::list_format::NONE);
+        uut.parse(argv1.size(), argv1.data());
+        ASSERT_EQ(uut.config().list_fmt, config::list_format::TEXT);
+        uut.parse(argv2.size(), argv2.data());
+        ASSERT_EQ(uut.config().list_fmt, config::list_format::JSON);
+        ASSERT_THROWS(uut.parse(argv3.size(), argv3.data()), std::runtime_error);
+    };
+    TEST("shuffle") {
+        cmdline_parser             uut;
+        std::array<char const*, 2> argv1{"test", "--shuffle=123"};
+        std::array<char const*, 2> argv2{"test", "--shuffle"};
+        ASSERT_FALSE(uut.config().shuffle.enabled);
+        uut.parse(argv1.size(), argv1.data());
+        ASSERT_TRUE(uut.config().shuffle.enabled);
+        ASSERT_EQ(uut.config().shuffle.seed, 123UL);
+        cmdline_parser p;
+        p.parse(argv2.size(), argv2.data());
+        ASSERT_TRUE(p.config().shuffle.enabled);
+        for (auto const* inv : {"--shuffle=", "--shuffle=-1", "--shuffle=1x"}) {
+            cmdline_parser             q;
+            std::array<char const*, 2> args{"test", inv};
+            ASSERT_THROWS(q.parse(args.size(), args.data()), std::runtime_error);
+        }
+    };
+    TEST("baseline") {
+        cmdline_parser             uut;
+        std::array<char const*, 9> argv{"test",           "--save-baseline", "a", "--compare-baseline", "b",
+                                        "--max-regression", "2.5",          "--significance", "0.05"};
+        ASSERT_EQ(uut.config().max_regression, 5.0);
+        ASSERT_EQ(uut.config().significance, 0.01);
+        uut.parse(argv.size(), argv.data());
+        ASSERT_EQ(uut.config().save_baseline, "a");
+        ASSERT_EQ(uut.config().compare_baseline, "b");
+        ASSERT_EQ(uut.config().max_regression, 2.5);
+        ASSERT_EQ(uut.config().significance, 0.05);
+        for (auto const* inv : {"-1", "x", "1x"}) {
+            cmdline_parser             p;
+            std::array<char const*, 3> args{"test", "--max-regression", inv};
+            ASSERT_THROWS(p.parse(args.size(), args.data()), std::runtime_error);
+        }
+    };
+    TEST("shard") {
+        cmdline_parser             uut;
+        std::array<char const*, 3> argv{"test", "--shard", "2/3"};
+        uut.parse(argv.size(), argv.data());
+        ASSERT_EQ(uut.config().shard.index, 2UL);
+        ASSERT_EQ(uut.config().shard.count, 3UL);
+        for (auto const* inv : {"3/3", "1/0", "-1/2", "1", "1/2x", "1-2", "/2"}) {
+            cmdline_parser             p;
+            std::array<char const*, 3> args{"test", "--shard", inv};
+            ASSERT_THROWS(p.parse(args.size(), args.data()), std::runtime_error);
+        }
+    };
 };
 
 SUITE("test_runner") {
@@ -1455,11 +3465,28 @@ SUITE("test_runner") {
         ASSERT_GT(t_ts2->statistics().elapsed_time(), .0);
         ASSERT_EQ(t_ts2->statistics().tests(), 1UL);
     };
+    TEST("until fail ends") {
+        config c;
+        c.report_cfg.ostream = &t_null;
+        c.until_fail         = true;
+        runner r;
+        r.add_testsuite(t_ts1);
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(t_ts1->testcases().at(0).result(), testcase::HAS_PASSED);
+        int n{0};
+        c.repeat = 5;
+        t_ts2->test("flaky", [&] { ASSERT_LT(++n, 3); });
+        runner r2;
+        r2.add_testsuite(t_ts2);
+        ASSERT_EQ(r2.run(c), 1);
+        ASSERT_EQ(t_ts2->testcases().at(0).repetitions().runs(), 5UL);
+        ASSERT_EQ(t_ts2->testcases().at(1).repetitions().runs(), 3UL);
+    };
     TEST("tests with include filter") {
         config c;
         c.report_cfg.ostream = &t_null;
         c.f_mode             = config::filter_mode::INCLUDE;
-        c.f_patterns.emplace_back(std::regex(".*?1"));
+        c.f_patterns.add("*1");
         runner r;
         r.add_testsuite(t_ts1);
         r.add_testsuite(t_ts2);
@@ -1469,11 +3496,40 @@ SUITE("test_runner") {
         ASSERT_EQ(t_ts2->statistics().elapsed_time(), .0);
         ASSERT_EQ(t_ts2->statistics().tests(), 0UL);
     };
+    TEST("tests with testcase filter") {
+        config c;
+        c.report_cfg.ostream = &t_null;
+        c.f_mode             = config::filter_mode::INCLUDE;
+        c.f_patterns.add("testsuite1/other");
+        t_ts1->test("other", [] {});
+        runner r;
+        r.add_testsuite(t_ts1);
+        r.add_testsuite(t_ts2);
+        r.run(c);
+        ASSERT_EQ(t_ts1->statistics().tests(), 1UL);
+        ASSERT_EQ(std::string(t_ts1->testcases().at(0).name()), "other");
+        ASSERT_EQ(t_ts2->statistics().tests(), 0UL);
+    };
+    TEST("list without running") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.list_fmt           = config::list_format::TEXT;
+        c.f_mode             = config::filter_mode::INCLUDE;
+        c.f_patterns.add("*1");
+        runner r;
+        r.add_testsuite(t_ts1);
+        r.add_testsuite(t_ts2);
+        ASSERT_EQ(r.run(c), 0);
+        ASSERT_EQ(oss.str(), "testsuite1\n  test\n1 testsuites, 1 testcases\n");
+        ASSERT_EQ(t_ts1->statistics().tests(), 0UL);
+        ASSERT_EQ(t_ts1->testcases().at(0).result(), testcase::IS_UNDONE);
+    };
     TEST("tests with exclude filter") {
         config c;
         c.report_cfg.ostream = &t_null;
         c.f_mode             = config::filter_mode::EXCLUDE;
-        c.f_patterns.emplace_back(std::regex(".*?2"));
+        c.f_patterns.add("*2");
         runner r;
         r.add_testsuite(t_ts1);
         r.add_testsuite(t_ts2);
@@ -1483,6 +3539,178 @@ SUITE("test_runner") {
         ASSERT_EQ(t_ts2->statistics().elapsed_time(), .0);
         ASSERT_EQ(t_ts2->statistics().tests(), 0UL);
     };
+    TEST("parallel testsuites") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        c.parallel_suites    = true;
+        auto ts3             = testsuite_parallel::create("testsuite3");
+        ts3->test("test", [] { std::cout << "out"; });
+        ts3->test("test", [] { ASSERT_TRUE(false); });
+        t_ts1->test("test", [] { std::cout << "out1"; });
+        runner r;
+        r.add_testsuite(t_ts1);
+        r.add_testsuite(t_ts2);
+        r.add_testsuite(ts3);
+        ASSERT_EQ(r.run(c), 1);
+        ASSERT_EQ(t_ts1->statistics().tests(), 2UL);
+        ASSERT_EQ(t_ts2->statistics().tests(), 1UL);
+        ASSERT_EQ(ts3->statistics().failures(), 1UL);
+        ASSERT_EQ(t_ts1->testcases().at(1).cout(), "out1");
+        ASSERT_EQ(ts3->testcases().at(0).cout(), "out");
+        auto const rep{oss.str()};
+        ASSERT_LT(rep.find("testsuite1"), rep.find("testsuite2"));
+        ASSERT_LT(rep.find("testsuite2"), rep.find("testsuite3"));
+    };
+    TEST("stable report order") {
+        std::ostringstream oss;
+        config             c;
+        c.report_fmt         = config::report_format::JSON;
+        c.report_cfg.ostream = &oss;
+        c.parallel_suites    = true;
+        c.thd_count          = 4;
+        runner                     r;
+        std::vector<testsuite_ptr> suites;
+        for (int s = 0; s < 6; ++s) {
+            suites.push_back(testsuite_parallel::create(s % 2 == 0 ? "even" : "odd"));
+            for (int t = 0; t < 6; ++t) {
+                suites.back()->test(t % 2 == 0 ? "even" : "odd", [s, t] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds((12 - s - t) % 5));
+                    std::cout << s << t;
+                });
+            }
+            r.add_testsuite(suites.back());
+        }
+        c.report_cfg.capture_out = true;
+        ASSERT_EQ(r.run(c), 0);
+        auto const  rep{oss.str()};
+        std::size_t pos{0};
+        for (int s = 0; s < 6; ++s) {
+            for (int t = 0; t < 6; ++t) {
+                auto const next{rep.find("\"stdout\": \"" + std::to_string(s) + std::to_string(t) + '"', pos)};
+                ASSERT_NOT_EQ(next, std::string::npos);
+                pos = next;
+            }
+        }
+    };
+    TEST("report error stops reporting") {
+        std::ostringstream oss;
+        config             c;
+        c.report_cfg.ostream = &oss;
+        t_ts2->setup([] { throw std::logic_error("setup"); });
+        auto ts3 = testsuite::create("testsuite3");
+        ts3->test("test", [] {});
+        runner r;
+        r.add_testsuite(t_ts1);
+        r.add_testsuite(t_ts2);
+        r.add_testsuite(ts3);
+        ASSERT_EQ(r.run(c), -2);
+        ASSERT_NOT_EQ(oss.str().find("testsuite1"), std::string::npos);
+        ASSERT_EQ(oss.str().find("testsuite2"), std::string::npos);
+        ASSERT_EQ(ts3->statistics().tests(), 0UL);
+    };
+    TEST("parallel testsuites with error") {
+        config c;
+        c.report_cfg.ostream = &t_null;
+        c.parallel_suites    = true;
+        t_ts1->setup([] { throw std::logic_error("setup"); });
+        runner r;
+        r.add_testsuite(t_ts1);
+        r.add_testsuite(t_ts2);
+        ASSERT_EQ(r.run(c), -2);
+        ASSERT_EQ(t_ts2->statistics().tests(), 1UL);
+    };
+    TEST("fail fast") {
+        for (auto const fmt : {config::report_format::CNS, config::report_format::XML, config::report_format::JSON,
+                               config::report_format::MD}) {
+            std::ostringstream oss;
+            config             c;
+            c.report_fmt         = fmt;
+            c.report_cfg.ostream = &oss;
+            c.fail_fast          = 2;
+            auto ts1             = testsuite::create("testsuite1");
+            auto ts2             = testsuite::create("testsuite2");
+            bool setup{false};
+            ts1->test("test", [] { ASSERT_TRUE(false); });
+            ts1->test("test", [] {});
+            ts1->test("test", [] { throw std::logic_error(""); });
+            ts1->test("test", [] {});
+            ts2->setup([&] { setup = true; });
+            ts2->test("test", [] {});
+            runner r;
+            r.add_testsuite(ts1);
+            r.add_testsuite(ts2);
+            ASSERT_EQ(r.run(c), 2);
+            ASSERT_FALSE(setup);
+            ASSERT_EQ(ts1->statistics().successes(), 1UL);
+            ASSERT_EQ(ts1->statistics().skipped(), 1UL);
+            ASSERT_EQ(ts2->statistics().tests(), 1UL);
+            ASSERT_EQ(ts2->statistics().skipped(), 1UL);
+            ASSERT_EQ(ts2->statistics().successes(), 0UL);
+            auto const rep{oss.str()};
+            ASSERT_TRUE(rep.find("testsuite2") != std::string::npos);
+            ASSERT_TRUE(rep.find("kipped") != std::string::npos || rep.find("SKIPPED") != std::string::npos);
+            if (fmt == config::report_format::MD) {
+                ASSERT_NOT_EQ(rep.find("|Tests|Successes|Failures|Errors|Skipped|Time|\n|-|-|-|-|-|-|\n|5|1|1|1|2|"),
+                              std::string::npos);
+            }
+        }
+    };
+    TEST("fail fast cancels running tests") {
+        config c;
+        c.report_cfg.ostream = &t_null;
+        c.fail_fast          = 1;
+        c.thd_count          = 2;
+        auto ts              = testsuite_parallel::create("testsuite");
+        bool              cancelled{false};
+        std::atomic<bool> started{false};
+        ts->test("test", [&] {
+            started = true;
+            for (int i = 0; i < 500 && !tpp::cancellation::requested(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            cancelled = tpp::cancellation::requested();
+        });
+        ts->test("test", [&] {
+            while (!started) {
+                std::this_thread::yield();
+            }
+            ASSERT_TRUE(false);
+        });
+        runner r;
+        r.add_testsuite(ts);
+        ASSERT_EQ(r.run(c), 1);
+        ASSERT_TRUE(cancelled);
+        ASSERT_FALSE(tpp::cancellation::requested());
+        ASSERT_LT(ts->statistics().elapsed_time(), 4000.0);
+    };
+    TEST("shards") {
+        std::multiset<std::string> ran;
+        std::size_t                reported{0};
+        for (std::size_t i{0}; i < 3; ++i) {
+            std::ostringstream oss;
+            config             c;
+            c.report_fmt         = config::report_format::JSON;
+            c.report_cfg.ostream = &oss;
+            c.shard              = shard{i, 3};
+            runner r;
+            for (auto const* name : {"a", "b", "c"}) {
+                auto ts = testsuite::create(name);
+                for (auto const* tc : {"1", "2", "3", "4", "5"}) {
+                    ts->test(tc, [&ran, name, tc] { ran.insert(std::string(name) + tc); });
+                }
+                r.add_testsuite(ts);
+            }
+            ASSERT_EQ(r.run(c), 0);
+            auto const rep{oss.str()};
+            for (std::size_t p{0}; (p = rep.find("\"result\"", p)) != std::string::npos; ++p) {
+                ++reported;
+            }
+        }
+        ASSERT_EQ(ran.size(), 15UL);
+        ASSERT_EQ(std::set<std::string>(ran.cbegin(), ran.cend()).size(), 15UL);
+        ASSERT_EQ(reported, 15UL);
+    };
 };
 
 #ifdef TPP_INTERN_SYS_UNIX
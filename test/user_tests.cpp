@@ -15,6 +15,10 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <numeric>
+#include <thread>
+#include <vector>
+
 #include "tpp.hpp"
 
 class MyClass
@@ -66,3 +70,58 @@ DESCRIBE_PAR("TestMyClass") {
         std::cerr << "print \"quoted\"" << std::endl;
     }
 };
+
+DESCRIBE_PAR_PER_WORKER("TestMyClassPerWorker") {
+    MyClass         fixture_;
+    std::thread::id owner_;
+
+    THREAD_SETUP() {
+        owner_ = std::this_thread::get_id();
+    };
+    BEFORE_EACH() {
+        fixture_.incr();
+    };
+
+    TEST("runs on the instance of its thread") {
+        ASSERT_TRUE(owner_ == std::this_thread::get_id());
+        ASSERT(fixture_.i(), GT, 0);
+    };
+    TEST("runs on the instance of its thread too") {
+        ASSERT_TRUE(owner_ == std::this_thread::get_id());
+        ASSERT(fixture_.i(), GT, 0);
+    };
+};
+
+DESCRIBE_PAR_PER_TEST("TestMyClassPerTest") {
+    MyClass fixture_;
+
+    BEFORE_EACH() {
+        fixture_.incr();
+    };
+
+    TEST("runs on a new instance") {
+        ASSERT_EQ(fixture_.i(), 1);
+    };
+    TEST("runs on a new instance too") {
+        ASSERT_EQ(fixture_.i(), 1);
+    };
+};
+
+DESCRIBE("TestMyClassAfterwards", depends_on("TestMyClass")) {
+    TEST("runs after TestMyClass passed") {
+        ASSERT_EQ(MyClass().i(), 0);
+    };
+};
+
+SUITE("BenchmarkMyClass") {
+    std::vector<int> v_ = std::vector<int>(1000, 1);
+
+    BENCHMARK("sum of 1000 ints") {
+        do_not_optimize(std::accumulate(v_.cbegin(), v_.cend(), 0));
+    };
+    BENCHMARK("construct MyClass") {
+        MyClass c;
+        do_not_optimize(c);
+        clobber_memory();
+    };
+};